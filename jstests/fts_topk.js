@@ -0,0 +1,36 @@
+// the text command stops reading postings once the top results are settled
+
+load( "jstests/libs/fts.js" );
+
+t = db.text_topk;
+t.drop();
+
+for ( var i = 0; i < 1000; i++ ) {
+    var text = "common filler words";
+    for ( var j = 0; j < i % 7; j++ )
+        text += " common";
+    if ( i % 10 == 0 )
+        text += " rare";
+    t.save( { _id : i , title : ( i % 100 == 0 ? "common rare" : "other" ) , text : text } );
+}
+
+t.ensureIndex( { title : "text" , text : "text" } , { weights : { title : 10 } } );
+
+function check( search, limit ) {
+    var all = t.runCommand( "text" , { search : search , limit : 100000 } );
+    var top = t.runCommand( "text" , { search : search , limit : limit } );
+
+    assert.eq( limit, top.results.length, tojson( top.stats ) );
+    for ( var i = 0; i < limit; i++ ) {
+        assert.eq( all.results[i].score, top.results[i].score, search + " " + i );
+    }
+    return top;
+}
+
+var res = check( "common", 5 );
+assert.lt( res.stats.nscanned, 1000, tojson( res.stats ) );
+
+check( "common rare", 5 );
+check( "rare", 3 );
+check( "common -rare", 5 );
+check( "common \"filler words\"", 10 );
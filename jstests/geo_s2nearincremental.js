@@ -0,0 +1,46 @@
+// $near on a 2dsphere index returns documents as soon as each annulus proves them closest, and
+// keeps documents it sees beyond the annulus for later.  Check that the order holds and nothing is
+// lost, with points and with lines spanning many annuli.
+t = db.geo_s2nearincremental
+t.drop()
+t.ensureIndex({geo: "2dsphere"});
+
+origin = { "type" : "Point", "coordinates": [ 0, 0 ] };
+for (var x = -10; x <= 10; x += 0.5) {
+    for (var y = -10; y <= 10; y += 0.5) {
+        t.insert({geo: { "type" : "Point", "coordinates": [ x, y ] }});
+    }
+}
+// Lines reaching from far away into the search area have keys in many cells.
+t.insert({geo: { "type" : "LineString", "coordinates": [ [ 0.1, 0.1 ], [ 60, 60 ] ] }});
+t.insert({geo: { "type" : "LineString", "coordinates": [ [ -60, 5 ], [ 40, 5.2 ] ] }});
+var total = t.count();
+
+var res = db.runCommand({geoNear: t.getName(), near: origin, spherical: true, num: total});
+assert.commandWorked(res);
+assert.eq(total, res.results.length);
+for (var i = 1; i < res.results.length; ++i) {
+    assert.lte(res.results[i - 1].dis, res.results[i].dis);
+}
+
+// Each document is returned once.
+var ids = {};
+t.find({geo: {$near: {$geometry: origin}}}).forEach(function(doc) {
+    assert(!ids[doc._id.str]);
+    ids[doc._id.str] = true;
+});
+assert.eq(total, Object.keySet(ids).length);
+
+// A limited query returns the closest documents.
+var limited = db.runCommand({geoNear: t.getName(), near: origin, spherical: true, num: 20});
+assert.eq(20, limited.results.length);
+for (var i = 0; i < 20; ++i) {
+    assert.eq(res.results[i].dis, limited.results[i].dis);
+}
+assert.eq(20, t.find({geo: {$near: {$geometry: origin}}}).limit(20).itcount());
+
+// Everything within $maxDistance is found.
+var maxDistance = 500 * 1000;
+var within = 0;
+res.results.forEach(function(r) { if (r.dis < maxDistance) { ++within; } });
+assert.eq(within, t.find({geo: {$near: {$geometry: origin, $maxDistance: maxDistance}}}).itcount());
@@ -0,0 +1,40 @@
+// Queries on separately indexed fields may intersect the indexes, and return the same documents
+// as a collection scan.
+
+t = db.jstests_indexintersect1;
+t.drop();
+
+t.ensureIndex( { a:1 } );
+t.ensureIndex( { b:1 } );
+t.ensureIndex( { c:1 } );
+for( i = 0; i < 300; ++i ) {
+    t.save( { a:i % 7, b:i % 11, c:[ i % 5, i % 5 + 1 ] } );
+}
+
+function checkQuery( query ) {
+    expected = t.find( query ).hint( { $natural:1 } ).sort( { _id:1 } ).toArray();
+    // Run twice, the second time using any recorded plan.
+    for( i = 0; i < 2; ++i ) {
+        assert.eq( expected, t.find( query ).sort( { _id:1 } ).toArray() );
+        assert.eq( expected.length, t.find( query ).itcount() );
+    }
+    explain = t.find( query ).explain( true );
+    assert.eq( expected.length, explain.n );
+    return explain;
+}
+
+function hasIntersectionPlan( explain ) {
+    return explain.allPlans.some( function( plan ) {
+                                      return plan.cursor.indexOf( "IntersectionCursor" ) == 0;
+                                  } );
+}
+
+// Point intervals, merged by location.
+assert( hasIntersectionPlan( checkQuery( { a:3, b:4 } ) ) );
+// Ranges and a multikey index, intersected by hashing.
+assert( hasIntersectionPlan( checkQuery( { a:{ $gt:2 }, b:{ $lt:3 }, c:{ $in:[ 1, 2 ] } } ) ) );
+checkQuery( { a:{ $in:[ 1, 2 ] }, c:3 } );
+checkQuery( { $or:[ { a:1, b:2 }, { b:3, c:4 } ] } );
+
+// A sorted query does not intersect indexes.
+assert( !hasIntersectionPlan( t.find( { a:3, b:4 } ).sort( { d:1 } ).explain( true ) ) );
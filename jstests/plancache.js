@@ -0,0 +1,43 @@
+// The planCache command lists cached plans with their run statistics, and writes no longer
+// flush the cache.
+
+t = db.jstests_plancache;
+t.drop();
+
+t.ensureIndex( { a:1 } );
+t.ensureIndex( { b:1 } );
+for( i = 0; i < 50; ++i ) {
+    t.save( { a:1, b:i } );
+}
+
+function cacheInfo() {
+    res = db.runCommand( { planCache:t.getName() } );
+    assert.commandWorked( res );
+    return res;
+}
+
+assert.eq( 0, cacheInfo().plans.length );
+
+// The first query races the plans and records the winner, the second runs the cached plan.
+assert.eq( 1, t.find( { a:1, b:5 } ).itcount() );
+assert.eq( 1, t.find( { a:1, b:6 } ).itcount() );
+
+info = cacheInfo();
+assert.eq( 1, info.plans.length );
+plan = info.plans[ 0 ];
+assert.eq( { b:1 }, plan.indexKey );
+assert.lte( 1, plan.runs );
+assert.eq( plan.maxNscanned, 1 );
+
+// More than 100 writes leave the plan cached.
+for( i = 0; i < 150; ++i ) {
+    t.save( { a:2, b:i } );
+}
+info = cacheInfo();
+assert.eq( 1, info.plans.length );
+assert.lte( 150, info.writes );
+
+assert.commandWorked( db.runCommand( { planCache:t.getName(), clear:true } ) );
+assert.eq( 0, cacheInfo().plans.length );
+
+assert.commandFailed( db.runCommand( { planCache:"jstests_plancache_missing" } ) );
@@ -0,0 +1,75 @@
+// A node cloning collections in parallel during initial sync (initialSyncCloneThreads > 1) stops
+// its copying threads promptly when it is shut down, and syncs fully once restarted.
+
+load("jstests/replsets/rslib.js");
+basename = "jstests_initsync_parallel_interrupt";
+
+print("1. Bring up set");
+replTest = new ReplSetTest( {name: basename, nodes: 1} );
+replTest.startSet();
+replTest.initiate();
+
+m = replTest.getMaster();
+md = m.getDB("d");
+
+print("2. Insert some data into several collections");
+var nColls = 4;
+var N = 20000;
+for( var c = 0; c < nColls; ++c ) {
+    for( var i = 0; i < N; ++i ) {
+        md["c" + c].insert( {_id:i, x:i, pad:new Array(100).join("x")} );
+    }
+}
+md.getLastError();
+
+print("3. Bring up a new node cloning on several threads");
+ports = allocatePorts( 3 );
+hostname = getHostName();
+var options = {replSet : basename, oplogSize : 2, setParameter : "initialSyncCloneThreads=4"};
+s = startMongodTest( ports[2], basename, false, options );
+
+var config = replTest.getReplSetConfig();
+config.version = 2;
+config.members.push({_id:2, host:hostname+":"+ports[2]});
+try {
+    m.getDB("admin").runCommand({replSetReconfig:config});
+}
+catch(e) {
+    print(e);
+}
+reconnect(s);
+
+print("4. Wait for the new node to start cloning");
+s.setSlaveOk();
+sd = s.getDB("d");
+wait( function() {
+    for( var c = 0; c < nColls; ++c ) {
+        if( sd["c" + c].stats().count > 0 ) {
+            return true;
+        }
+    }
+    return false;
+} );
+
+print("5. Shut it down while the copying threads are running");
+var start = new Date();
+stopMongod( ports[2] );
+var elapsed = new Date() - start;
+print("shutdown took " + elapsed + "ms");
+assert.lt( elapsed, 60 * 1000, "cloning threads held up shutdown" );
+
+print("6. Restart it and check the clone completes");
+s = startMongodTest( ports[2], basename, true, options );
+s.setSlaveOk();
+sd = s.getDB("d");
+wait( function() {
+    var status = s.getDB("admin").runCommand({replSetGetStatus:1});
+    return status.ok && status.myState == 2;
+} );
+for( var c = 0; c < nColls; ++c ) {
+    assert.eq( N, sd["c" + c].count(), "collection c" + c );
+    assert.eq( N - 1, sd["c" + c].findOne({_id:N - 1}).x );
+}
+
+replTest.stopSet();
+stopMongod( ports[2] );
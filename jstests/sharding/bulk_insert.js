@@ -329,6 +329,58 @@ assert.neq(null, err);
 assert(isDupKeyError(err));
 assert.eq(6, collDi.find().itcount());
 
+jsTest.log("Bulk insert (yes COE) interleaved across shards with errors on both shards...")
+
+// Put the chunks on different shards
+printjson(admin.runCommand({moveChunk : collSh + "",
+                            find : {ukey : 0},
+                            to : shards[1]._id,
+                            _waitForDelete: true}));
+
+// Regrouped by shard: each shard's errors are left to the client's getLastError
+resetColls();
+var inserts = [{ukey : 0},
+               {ukey : -1},
+               {ukey : 0},
+               {ukey : -1},
+               {ukey : 1},
+               {ukey : -2}]
+
+collSh.insert(inserts, 1);
+var gle = collSh.getDB().getLastErrorObj();
+printjson(gle);
+assert(isDupKeyError(gle.err));
+assert.eq(2, gle.errs.length);
+assert(isDupKeyError(gle.errs[0]));
+assert(isDupKeyError(gle.errs[1]));
+assert.eq(4, collSh.find().itcount());
+
+jsTest.log("Bulk insert (yes COE) with an error in a shard's first group of two...")
+
+// The 8MB group limit splits the first shard's documents, so its connection is written twice.
+// The error in the first group must not be hidden by the second.
+var data5MB = "x";
+while (data5MB.length < 5 * 1024 * 1024)
+    data5MB += data5MB;
+data5MB = data5MB.substring(0, 5 * 1024 * 1024);
+
+resetColls();
+collSh.insert({ukey : 1});
+assert.eq(null, collSh.getDB().getLastError());
+var inserts = [{ukey : 1, data : data5MB},
+               {ukey : -1},
+               {ukey : 2, data : data5MB}]
+
+collSh.insert(inserts, 1);
+var err = printPass(collSh.getDB().getLastError());
+assert(isDupKeyError(err));
+assert.eq(3, collSh.find().itcount());
+
+printjson(admin.runCommand({moveChunk : collSh + "",
+                            find : {ukey : 0},
+                            to : shards[0]._id,
+                            _waitForDelete: true}));
+
 //
 // Test when WBL has to be invoked mid-insert
 //
@@ -0,0 +1,62 @@
+//
+// The recipient of a migration requests the next _migrateClone batch while it inserts the current
+// one, migrateCloneInsertsPerLock documents at a time.  Check that moves spanning several clone
+// batches deliver every document intact, with group sizes that don't divide the batches.
+//
+
+var st = new ShardingTest({ shards : 2, mongos : 1, other : { separateConfig : true } });
+st.stopBalancer();
+
+var mongos = st.s0;
+var admin = mongos.getDB( "admin" );
+var config = mongos.getDB( "config" );
+var shards = config.shards.find().toArray();
+var coll = mongos.getCollection( "foo.bar" );
+
+assert.commandWorked(admin.runCommand({ enableSharding : coll.getDB() + "" }));
+printjson(admin.runCommand({ movePrimary : coll.getDB() + "", to : shards[0]._id }));
+assert.commandWorked(admin.runCommand({ shardCollection : coll + "", key : { _id : 1 } }));
+
+// About 24MB, more than one _migrateClone batch.
+var N = 3000;
+var pad = new Array(8 * 1024).join("x");
+for (var i = 0; i < N; i++) {
+    coll.insert({ _id : i, x : i * 3, s : "doc" + i, pad : pad });
+}
+assert.eq(null, coll.getDB().getLastError());
+
+var setInsertsPerLock = function(n) {
+    [st.shard0, st.shard1].forEach(function(shard) {
+        assert.commandWorked(shard.getDB("admin").runCommand({ setParameter : 1,
+                                                               migrateCloneInsertsPerLock : n }));
+    });
+};
+
+var checkMoved = function(to, other) {
+    assert.eq(N, coll.find().itcount(), "count through mongos");
+    assert.eq(N, to.getCollection(coll + "").count(), "count on the recipient");
+    assert.eq(0, other.getCollection(coll + "").count(), "count left on the donor");
+    var n = 0;
+    to.getCollection(coll + "").find().sort({ _id : 1 }).forEach(function(doc) {
+        assert.eq(n, doc._id);
+        assert.eq(n * 3, doc.x);
+        assert.eq("doc" + n, doc.s);
+        assert.eq(pad, doc.pad);
+        n++;
+    });
+    assert.eq(N, n);
+};
+
+// 7 doesn't divide a batch, so a group spans the end of one batch.
+setInsertsPerLock(7);
+assert.commandWorked(admin.runCommand({ moveChunk : coll + "", find : { _id : 0 },
+                                        to : shards[1]._id }));
+checkMoved(st.shard1, st.shard0);
+
+// One group larger than any batch.
+setInsertsPerLock(100000);
+assert.commandWorked(admin.runCommand({ moveChunk : coll + "", find : { _id : 0 },
+                                        to : shards[0]._id }));
+checkMoved(st.shard0, st.shard1);
+
+st.stop();
@@ -0,0 +1,74 @@
+//
+// With parallelCollectionScanThreads set, a shard's unindexed aggregation scans the collection on
+// several threads.  Documents the shard holds but doesn't own (orphans, as left by an aborted
+// migration) must still be filtered out of the results.
+//
+
+var st = new ShardingTest({ shards : 2, mongos : 1, other : { separateConfig : true } });
+st.stopBalancer();
+
+var mongos = st.s0;
+var admin = mongos.getDB( "admin" );
+var config = mongos.getDB( "config" );
+var shards = config.shards.find().toArray();
+var coll = mongos.getCollection( "foo.bar" );
+
+assert.commandWorked(admin.runCommand({ enableSharding : coll.getDB() + "" }));
+printjson(admin.runCommand({ movePrimary : coll.getDB() + "", to : shards[0]._id }));
+assert.commandWorked(admin.runCommand({ shardCollection : coll + "", key : { _id : 1 } }));
+
+// More than 16MB on each shard, so both split their scans.
+var N = 4000;
+var pad = new Array(10 * 1024).join("x");
+assert.commandWorked(admin.runCommand({ split : coll + "", middle : { _id : N / 2 } }));
+assert.commandWorked(admin.runCommand({ moveChunk : coll + "", find : { _id : N / 2 },
+                                        to : shards[1]._id }));
+for (var i = 0; i < N; i++) {
+    coll.insert({ _id : i, a : i % 10, pad : pad });
+}
+assert.eq(null, coll.getDB().getLastError());
+
+// Orphans: copies of shard1's documents inserted straight into shard0.
+var shard0Coll = st.shard0.getCollection( coll + "" );
+for (var i = N / 2; i < N / 2 + 500; i++) {
+    shard0Coll.insert({ _id : i, a : i % 10, pad : pad });
+}
+assert.eq(null, shard0Coll.getDB().getLastError());
+assert.eq(N / 2 + 500, shard0Coll.count());
+
+[st.shard0, st.shard1].forEach(function(shard) {
+    assert.commandWorked(shard.getDB("admin").runCommand({ setParameter : 1,
+                                                           parallelCollectionScanThreads : 4 }));
+});
+
+var aggregate = function(pipeline) {
+    var res = coll.aggregate(pipeline);
+    assert.commandWorked(res);
+    return res.result;
+};
+
+// Each matching document once, and no orphans.
+var res = aggregate([ { $match : { a : 3 } },
+                      { $group : { _id : null, n : { $sum : 1 }, ids : { $sum : "$_id" } } } ]);
+var sum = 0;
+for (var i = 3; i < N; i += 10) {
+    sum += i;
+}
+assert.eq(1, res.length);
+assert.eq(N / 10, res[0].n);
+assert.eq(sum, res[0].ids);
+
+res = aggregate([ { $match : { a : { $in : [ 1, 2 ] } } }, { $project : { _id : 1 } } ]);
+assert.eq(N / 5, res.length);
+var seen = {};
+res.forEach(function(doc) {
+    assert(!seen[doc._id], "duplicate " + doc._id);
+    seen[doc._id] = true;
+});
+
+// A pipeline that stops early leaves the collection writable.
+assert.eq(5, aggregate([ { $match : { a : 3 } }, { $limit : 5 } ]).length);
+coll.insert({ _id : N, a : 3 });
+assert.eq(null, coll.getDB().getLastError());
+
+st.stop();
@@ -0,0 +1,82 @@
+//
+// Sorted queries over several shards merge the shards' results in order, with the getMore for a
+// shard's next batch sent ahead (parallelCursorReadAhead).  Cursors dropped while a read-ahead
+// getMore is in flight must leave their connections usable.
+//
+
+var st = new ShardingTest({ shards : 3, mongos : 1, other : { separateConfig : true } });
+st.stopBalancer();
+
+var mongos = st.s0;
+var admin = mongos.getDB( "admin" );
+var config = mongos.getDB( "config" );
+var shards = config.shards.find().toArray();
+var coll = mongos.getCollection( "foo.bar" );
+
+assert.commandWorked(admin.runCommand({ enableSharding : coll.getDB() + "" }));
+printjson(admin.runCommand({ movePrimary : coll.getDB() + "", to : shards[0]._id }));
+assert.commandWorked(admin.runCommand({ shardCollection : coll + "", key : { _id : 1 } }));
+assert.commandWorked(admin.runCommand({ split : coll + "", middle : { _id : 1000 } }));
+assert.commandWorked(admin.runCommand({ split : coll + "", middle : { _id : 2000 } }));
+assert.commandWorked(admin.runCommand({ moveChunk : coll + "", find : { _id : 1000 },
+                                        to : shards[1]._id }));
+assert.commandWorked(admin.runCommand({ moveChunk : coll + "", find : { _id : 2000 },
+                                        to : shards[2]._id }));
+
+// x is a permutation of _id, so every shard has x values from all over the range.
+var N = 3000;
+var pad = new Array(200).join("x");
+for (var i = 0; i < N; i++) {
+    coll.insert({ _id : i, x : (i * 7) % N, pad : pad });
+}
+assert.eq(null, coll.getDB().getLastError());
+
+var checkSorted = function(readAhead) {
+    assert.commandWorked(admin.runCommand({ setParameter : 1, parallelCursorReadAhead : readAhead }));
+
+    var n = 0;
+    coll.find({}, { x : 1 }).sort({ x : 1 }).batchSize(50).forEach(function(doc) {
+        assert.eq(n, doc.x, "ascending, read-ahead " + readAhead);
+        n++;
+    });
+    assert.eq(N, n, "ascending count, read-ahead " + readAhead);
+
+    n = N - 1;
+    coll.find({}, { x : 1 }).sort({ x : -1 }).batchSize(7).forEach(function(doc) {
+        assert.eq(n, doc.x, "descending, read-ahead " + readAhead);
+        n--;
+    });
+    assert.eq(-1, n, "descending count, read-ahead " + readAhead);
+
+    var page = coll.find({}, { x : 1 }).sort({ x : 1 }).skip(1234).limit(500).toArray();
+    assert.eq(500, page.length);
+    for (var j = 0; j < page.length; j++) {
+        assert.eq(1234 + j, page[j].x, "skip and limit, read-ahead " + readAhead);
+    }
+
+    // Unsorted queries return each document once.
+    assert.eq(N, coll.find().batchSize(30).itcount(), "unsorted, read-ahead " + readAhead);
+};
+
+checkSorted(0);
+checkSorted(1);
+checkSorted(100);
+checkSorted(100000);
+
+// Drop cursors part way through, with their next batches requested.  The connections they
+// return to the pool must not hand the replies to later queries.
+assert.commandWorked(admin.runCommand({ setParameter : 1, parallelCursorReadAhead : 100 }));
+for (var k = 0; k < 20; k++) {
+    var cursor = coll.find().sort({ x : 1 }).batchSize(20);
+    for (var j = 0; j < 25; j++) {
+        assert.eq(j, cursor.next().x);
+    }
+    cursor = null;
+    gc(); // kills the cursor on mongos
+}
+for (var k = 0; k < 20; k++) {
+    assert.eq(k, coll.findOne({ x : k }).x);
+    assert.eq(N, coll.find().sort({ x : 1 }).itcount());
+}
+
+st.stop();
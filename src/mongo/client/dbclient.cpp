@@ -866,6 +866,25 @@ namespace mongo {
         }
 #endif
 
+        if ( MessagingPort::compressionAllowed ) {
+            // if the server agrees it compresses what it sends us, and we do the same
+            BSONObj info;
+            try {
+                if ( runCommand( "admin",
+                                 BSON( "isMaster" << 1 << "compression" << BSON_ARRAY( "snappy" ) ),
+                                 info ) &&
+                     info["compression"].type() == Array ) {
+                    p->setCompression( true );
+                }
+            }
+            catch ( DBException& e ) {
+                errmsg = str::stream() << "couldn't connect to server " << _server.toString()
+                                       << causedBy( e );
+                _failed = true;
+                return false;
+            }
+        }
+
         return true;
     }
 
@@ -116,21 +116,30 @@ namespace mongo {
         return ok;
     }
 
+    void DBClientCursor::assembleGetMore( Message& toSend ) {
+        BufBuilder b;
+        b.appendNum(opts);
+        b.appendStr(ns);
+        b.appendNum(nextBatchSize());
+        b.appendNum(cursorId);
+        toSend.setData(dbGetMore, b.buf(), b.len());
+    }
+
     void DBClientCursor::requestMore() {
         verify( cursorId && batch.pos == batch.nReturned );
 
+        if ( _prefetchConn ) {
+            receivePrefetched();
+            return;
+        }
+
         if (haveLimit) {
             nToReturn -= batch.nReturned;
             verify(nToReturn > 0);
         }
-        BufBuilder b;
-        b.appendNum(opts);
-        b.appendStr(ns);
-        b.appendNum(nextBatchSize());
-        b.appendNum(cursorId);
 
         Message toSend;
-        toSend.setData(dbGetMore, b.buf(), b.len());
+        assembleGetMore( toSend );
         auto_ptr<Message> response(new Message());
 
         if ( _client ) {
@@ -150,6 +159,40 @@ namespace mongo {
         }
     }
 
+    void DBClientCursor::prefetchMore() {
+        if ( _prefetchConn || _client || cursorId == 0 || haveLimit )
+            return;
+        if ( opts & ( QueryOption_CursorTailable | QueryOption_Exhaust ) )
+            return;
+        verify( _scopedHost.size() );
+
+        Message toSend;
+        assembleGetMore( toSend );
+
+        auto_ptr<ScopedDbConnection> conn( new ScopedDbConnection( _scopedHost ) );
+        if ( ! conn->get()->lazySupported() ) {
+            conn->done();
+            return;
+        }
+        conn->get()->say( toSend );
+        _prefetchConn.reset( conn.release() );
+    }
+
+    void DBClientCursor::receivePrefetched() {
+        boost::shared_ptr<AScopedConnection> conn;
+        conn.swap( _prefetchConn );
+        auto_ptr<Message> response(new Message());
+        if ( ! conn->get()->recv( *response ) ) {
+            // conn goes away without done(), closing the socket
+            uasserted( 16840, "recv failed while receiving prefetched getMore" );
+        }
+        _client = conn->get();
+        this->batch.m = response;
+        dataReceived();
+        _client = 0;
+        conn->done();
+    }
+
     /** with QueryOption_Exhaust, the server just blasts data at us (marked at end with cursorid==0). */
     void DBClientCursor::exhaustReceiveMore() {
         verify( cursorId && batch.pos == batch.nReturned );
@@ -161,6 +204,10 @@ namespace mongo {
         }
         batch.m = response;
         dataReceived();
+        // a tailable cursor keeps its id through empty batches, but here the server won't be
+        // asked again: cursorid 0 is the end of the stream
+        if ( ( (QueryResult *) batch.m->singleData() )->cursorId == 0 )
+            cursorId = 0;
     }
 
     void DBClientCursor::dataReceived( bool& retry, string& host ) {
@@ -219,7 +266,10 @@ namespace mongo {
         if ( cursorId == 0 )
             return false;
 
-        requestMore();
+        if ( opts & QueryOption_Exhaust )
+            exhaustReceiveMore();
+        else
+            requestMore();
         return batch.pos < batch.nReturned;
     }
 
@@ -314,6 +364,18 @@ namespace mongo {
 
         DESTRUCTOR_GUARD (
 
+        if ( _prefetchConn ) {
+            // the reply to a getMore we sent is still on the wire: take it off before the
+            // connection goes back to the pool, and learn whether there is a cursor left to kill
+            Message response;
+            if ( _prefetchConn->get()->recv( response ) ) {
+                QueryResult *qr = (QueryResult *) response.singleData();
+                cursorId = qr->cursorId;
+                _prefetchConn->done();
+            }
+            _prefetchConn.reset();
+        }
+
         if ( cursorId && _ownCursor && ! inShutdown() ) {
             BufBuilder b;
             b.appendNum( (int)0 ); // reserved
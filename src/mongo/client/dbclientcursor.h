@@ -199,6 +199,18 @@ namespace mongo {
         void initLazy( bool isRetry = false );
         bool initLazyFinish( bool& retry );
 
+        /**
+         * Send the getMore for the next batch now, without waiting for the reply; more() picks
+         * the reply up once the current batch is used up.  Lets the caller overlap the round
+         * trip with work on the current batch.
+         *
+         * Only for attached cursors (see attach()): a connection is taken from the pool and held
+         * while the request is out.  Does nothing if there is no next batch or one is already on
+         * its way, or for tailable, exhaust and limited cursors.
+         */
+        void prefetchMore();
+        bool morePrefetched() const { return _prefetchConn.get() != 0; }
+
         class Batch : boost::noncopyable { 
             friend class DBClientCursor;
             auto_ptr<Message> m;
@@ -234,10 +246,13 @@ namespace mongo {
         string _scopedHost;
         string _lazyHost;
         bool wasError;
+        boost::shared_ptr<AScopedConnection> _prefetchConn; // holds a getMore we've sent, see prefetchMore()
 
         void dataReceived() { bool retry; string lazyHost; dataReceived( retry, lazyHost ); }
         void dataReceived( bool& retry, string& lazyHost );
         void requestMore();
+        void receivePrefetched();
+        void assembleGetMore( Message& toSend );
         void exhaustReceiveMore(); // for exhaust
 
         // Don't call from a virtual function
@@ -22,6 +22,7 @@
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/client/parallel.h"
 #include "mongo/db/dbmessage.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/config.h"
@@ -477,6 +478,7 @@ namespace mongo {
         _numServers = _servers.size();
         _lastFrom = 0;
         _cursors = 0;
+        _mergeInited = false;
 
         if( ! _qSpec.isEmpty() ){
 
@@ -1581,6 +1583,64 @@ namespace mongo {
         _cursorMap.clear();
     }
 
+    namespace {
+        /**
+         * how many documents may be left in a shard's current batch before a merge sends the
+         * getMore for the next one, so the round trip overlaps merging the rest.  0 turns
+         * read-ahead off.
+         */
+        int parallelCursorReadAhead = 100;
+
+        ExportedServerParameter<int> ParallelCursorReadAhead(
+            ServerParameterSet::getGlobal(),
+            "parallelCursorReadAhead",
+            &parallelCursorReadAhead,
+            true,
+            true );
+
+        /** orders a heap of cursor indexes so the front's next document sorts first */
+        class MergeCompare {
+        public:
+            MergeCompare( FilteringClientCursor* cursors, const BSONObj& sortKey )
+                : _cursors( cursors ), _sortKey( sortKey ) {
+            }
+            bool operator()( int a, int b ) const {
+                int c = _cursors[a].peek().woSortOrder( _cursors[b].peek(), _sortKey, true );
+                if ( c != 0 )
+                    return c > 0;
+                return a > b;
+            }
+        private:
+            FilteringClientCursor* _cursors;
+            const BSONObj& _sortKey;
+        };
+    }
+
+    void ParallelSortClusteredCursor::_readAhead( int i ) {
+        DBClientCursor* c = _cursors[i].raw();
+        if ( c && parallelCursorReadAhead > 0 && c->objsLeftInBatch() <= parallelCursorReadAhead )
+            c->prefetchMore();
+    }
+
+    void ParallelSortClusteredCursor::_initMerge() {
+        if ( _mergeInited )
+            return;
+        _mergeInited = true;
+
+        // get every shard's next batch moving before we wait on any of them
+        for ( int i = 0; i < _numServers; i++ )
+            _readAhead( i );
+
+        _mergeHeap.reserve( _numServers );
+        for ( int i = 0; i < _numServers; i++ ) {
+            if ( _cursors[i].more() )
+                _mergeHeap.push_back( i );
+            else if ( _cursors[i].rawMData() )
+                _cursors[i].rawMData()->pcState->done = true;
+        }
+        make_heap( _mergeHeap.begin(), _mergeHeap.end(), MergeCompare( _cursors, _sortKey ) );
+    }
+
     bool ParallelSortClusteredCursor::more() {
 
         if ( _needToSkip > 0 ) {
@@ -1595,6 +1655,11 @@ namespace mongo {
             _needToSkip = n;
         }
 
+        if ( ! _sortKey.isEmpty() ) {
+            _initMerge();
+            return ! _mergeHeap.empty();
+        }
+
         for ( int i=0; i<_numServers; i++ ) {
             if ( _cursors[i].more() )
                 return true;
@@ -1603,6 +1668,31 @@ namespace mongo {
     }
 
     BSONObj ParallelSortClusteredCursor::next() {
+        if ( ! _sortKey.isEmpty() ) {
+            _initMerge();
+            uassert( 16857 ,  "no more elements" , ! _mergeHeap.empty() );
+
+            MergeCompare cmp( _cursors, _sortKey );
+            pop_heap( _mergeHeap.begin(), _mergeHeap.end(), cmp );
+            int i = _mergeHeap.back();
+
+            BSONObj best = _cursors[i].next();
+            if( _cursors[i].rawMData() )
+                _cursors[i].rawMData()->pcState->count++;
+
+            _readAhead( i );
+            if ( _cursors[i].more() ) {
+                push_heap( _mergeHeap.begin(), _mergeHeap.end(), cmp );
+            }
+            else {
+                _mergeHeap.pop_back();
+                if( _cursors[i].rawMData() )
+                    _cursors[i].rawMData()->pcState->done = true;
+            }
+            return best;
+        }
+
+        // unsorted: take from the shards in turn
         BSONObj best = BSONObj();
         int bestFrom = -1;
 
@@ -1640,6 +1730,7 @@ namespace mongo {
 
         uassert( 10019 ,  "no more elements" , ! best.isEmpty() );
         _cursors[bestFrom].next();
+        _readAhead( bestFrom );
 
         if( _cursors[bestFrom].rawMData() )
             _cursors[bestFrom].rawMData()->pcState->count++;
@@ -392,7 +392,17 @@ namespace mongo {
         FilteringClientCursor * _cursors;
         int _needToSkip;
 
+        // for a sorted merge: the indexes into _cursors of the cursors with more to give,
+        // kept as a heap on each cursor's next document.  built on first use by _initMerge()
+        vector<int> _mergeHeap;
+        bool _mergeInited;
+
     private:
+        void _initMerge();
+
+        /** sends cursor i's next getMore if its current batch is down to the read-ahead depth */
+        void _readAhead( int i );
+
         /**
          * Setups the shard version of the connection. When using a replica
          * set connection and the primary cannot be reached, the version
@@ -131,6 +131,7 @@ namespace {
         dbAdminRoleActions.addAction(ActionType::ensureIndex);
         dbAdminRoleActions.addAction(ActionType::indexRead);
         dbAdminRoleActions.addAction(ActionType::indexStats);
+        dbAdminRoleActions.addAction(ActionType::planCache);
         dbAdminRoleActions.addAction(ActionType::profileEnable);
         dbAdminRoleActions.addAction(ActionType::profileRead);
         dbAdminRoleActions.addAction(ActionType::reIndex);
@@ -18,10 +18,13 @@
 
 #include "mongo/pch.h"
 
+#include <boost/thread/thread.hpp>
+
 #include "mongo/base/init.h"
 #include "mongo/base/status.h"
 #include "mongo/bson/util/builder.h"
 #include "mongo/db/cloner.h"
+#include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/commands/rename_collection.h"
 #include "mongo/db/db.h"
@@ -94,12 +97,57 @@ namespace mongo {
         return res;
     }
 
-    Cloner::Cloner() { }
+    Cloner::Cloner() : _parallelWork(NULL) { }
+
+    /** the collections left to copy, shared by the threads of copyCollectionsInParallel() */
+    struct Cloner::ParallelWork {
+        ParallelWork(const list<BSONObj>& colls, CurOp* op, bool mayBeInterrupted)
+            : m("Cloner::ParallelWork"), toClone(colls), callerOp(op),
+              callerMayBeInterrupted(mayBeInterrupted), interrupted(false) {}
+
+        /** @return false when there is nothing left to do or some thread has failed */
+        bool next(BSONObj* collection) {
+            scoped_lock lk(m);
+            if ( toClone.empty() || !errmsg.empty() )
+                return false;
+            *collection = toClone.front();
+            toClone.pop_front();
+            return true;
+        }
+
+        void fail(const string& msg, bool isInterrupt = false) {
+            scoped_lock lk(m);
+            if ( errmsg.empty() ) {
+                errmsg = msg;
+                interrupted = isInterrupt;
+            }
+        }
+
+        /** the copying threads have clients and ops of their own, so they check the caller's
+            op here rather than their own.  a shutdown stops them whether or not the caller may
+            be interrupted, as the clone can't finish anyway. */
+        void checkForInterrupt() const {
+            uassert( 16854, "clone interrupted at shutdown", !killCurrentOp.globalInterruptCheck() );
+            uassert( 16855, "clone interrupted",
+                     !callerMayBeInterrupted || !callerOp->killPending() );
+        }
+
+        mongo::mutex m;
+        list<BSONObj> toClone;
+        CurOp* callerOp;
+        bool callerMayBeInterrupted;
+        string errmsg; // first failure
+        bool interrupted; // whether the first failure was checkForInterrupt()
+    };
+
 
     struct Cloner::Fun {
         Fun() : lastLog(0) { }
         time_t lastLog;
         void operator()( DBClientCursorBatchIterator &i ) {
+            if ( _parallelWork ) {
+                _parallelWork->checkForInterrupt();
+            }
             Lock::GlobalWrite lk;
             if ( context ) {
                 context->relocked();
@@ -115,6 +163,9 @@ namespace mongo {
                         lastLog = now;
                     }
                     mayInterrupt( _mayBeInterrupted );
+                    if ( _parallelWork ) {
+                        _parallelWork->checkForInterrupt();
+                    }
                     dbtempreleaseif t( _mayYield );
                 }
 
@@ -175,6 +226,7 @@ namespace mongo {
         Client::Context *context;
         bool _mayYield;
         bool _mayBeInterrupted;
+        const ParallelWork *_parallelWork;
     };
 
     /* copy the specified collection
@@ -197,6 +249,7 @@ namespace mongo {
         f.logForRepl = logForRepl;
         f._mayYield = mayYield;
         f._mayBeInterrupted = mayBeInterrupted;
+        f._parallelWork = _parallelWork;
 
         int options = QueryOption_NoCursorTimeout | ( slaveOk ? QueryOption_SlaveOk : 0 );
         {
@@ -296,9 +349,6 @@ namespace mongo {
         return true;
     }
 
-    extern bool inDBRepair;
-    void ensureIdIndexForNewNs(const char *ns);
-
     bool Cloner::go(const char *masterHost, string& errmsg, const string& fromdb, bool logForRepl, bool slaveOk, bool useReplAuth, bool snapshot, bool mayYield, bool mayBeInterrupted, int *errCode) {
 
         CloneOptions opts;
@@ -316,6 +366,117 @@ namespace mongo {
 
     }
 
+    extern bool inDBRepair;
+    void ensureIdIndexForNewNs(const char *ns);
+
+    void Cloner::copyCollectionAndIdIndex(const BSONObj& collection, const string& todb,
+                                          const CloneOptions& opts, bool masterSameProcess) {
+        LOG(2) << "  really will clone: " << collection << endl;
+        const char * from_name = collection["name"].valuestr();
+        BSONObj options = collection.getObjectField("options");
+
+        /* change name "<fromdb>.collection" -> <todb>.collection */
+        const char *p = strchr(from_name, '.');
+        verify(p);
+        string to_name = todb + p;
+
+        bool wantIdIndex = false;
+        {
+            string err;
+            const char *toname = to_name.c_str();
+            /* we defer building id index for performance - building it in batch is much faster */
+            userCreateNS(toname, options, err, opts.logForRepl, &wantIdIndex);
+        }
+        LOG(1) << "\t\t cloning " << from_name << " -> " << to_name << endl;
+        Query q;
+        if( opts.snapshot )
+            q.snapshot();
+        copy(from_name, to_name.c_str(), false, opts.logForRepl, masterSameProcess, opts.slaveOk, opts.mayYield, opts.mayBeInterrupted, q);
+
+        if( wantIdIndex ) {
+            /* we need dropDups to be true as we didn't do a true snapshot and this is before applying oplog operations
+               that occur during the initial sync.  inDBRepair makes dropDups be true.
+               */
+            bool old = inDBRepair;
+            try {
+                inDBRepair = true;
+                ensureIdIndexForNewNs(to_name.c_str());
+                inDBRepair = old;
+            }
+            catch(...) {
+                inDBRepair = old;
+                throw;
+            }
+        }
+    }
+
+    void Cloner::parallelCopyThread(const string& masterHost, const CloneOptions& opts,
+                                    const string& todb, ParallelWork* work) {
+        Client::initThread("clonerWorker");
+        if (AuthorizationManager::isAuthEnabled()) {
+            cc().getAuthorizationManager()->grantInternalAuthorization("_clonerWorker");
+        }
+
+        try {
+            string errmsg;
+            ConnectionString cs = ConnectionString::parse( masterHost, errmsg );
+            auto_ptr<DBClientBase> con( cs.connect( errmsg ) );
+            uassert( 16839, str::stream() << "can't connect to " << masterHost << ": " << errmsg,
+                     con.get() && replAuthenticate(con.get(), false) );
+
+            Cloner cloner;
+            cloner._conn = con;
+            cloner._parallelWork = work;
+
+            BSONObj collection;
+            while ( work->next( &collection ) ) {
+                work->checkForInterrupt();
+                const char *p = strchr(collection["name"].valuestr(), '.');
+                Client::WriteContext ctx( todb + p );
+                cloner.copyCollectionAndIdIndex( collection, todb, opts, false );
+            }
+        }
+        catch ( DBException& e ) {
+            work->fail( e.toString(), e.getCode() == 16854 || e.getCode() == 16855 );
+        }
+        catch ( std::exception& e ) {
+            work->fail( e.what() );
+        }
+
+        cc().shutdown();
+    }
+
+    bool Cloner::copyCollectionsInParallel(const char *masterHost, const CloneOptions& opts,
+                                           const string& todb, const list<BSONObj>& toClone,
+                                           string& errmsg) {
+        ParallelWork work( toClone, cc().curop(), opts.mayBeInterrupted );
+        int nThreads = std::min( opts.parallelCollections, static_cast<int>( toClone.size() ) );
+        LOG(1) << "\t cloning " << toClone.size() << " collections into " << todb
+               << " over " << nThreads << " connections" << endl;
+        {
+            // the copying threads take the database lock for themselves
+            mayInterrupt( opts.mayBeInterrupted );
+            dbtemprelease r;
+
+            boost::thread_group threads;
+            for ( int i = 0; i < nThreads; i++ ) {
+                threads.create_thread( boost::bind( &Cloner::parallelCopyThread,
+                                                    string( masterHost ), boost::cref( opts ),
+                                                    boost::cref( todb ), &work ) );
+            }
+            threads.join_all();
+        }
+
+        // an interrupted clone fails the caller the way the sequential copy would
+        mayInterrupt( opts.mayBeInterrupted );
+        uassert( 16856, "parallel clone failed: " + work.errmsg, !work.interrupted );
+        if ( !work.errmsg.empty() ) {
+            errmsg = "parallel clone failed: " + work.errmsg;
+            return false;
+        }
+        return true;
+    }
+
     bool Cloner::go(const char *masterHost, const CloneOptions& opts, set<string>& clonedColls,
                     string& errmsg, int* errCode) {
         if ( errCode ) {
@@ -423,48 +584,18 @@ namespace mongo {
             }
         }
 
-        for ( list<BSONObj>::iterator i=toClone.begin(); i != toClone.end(); i++ ) {
-            {
-                mayInterrupt( opts.mayBeInterrupted );
-                dbtempreleaseif r( opts.mayYield );
-            }
-            BSONObj collection = *i;
-            LOG(2) << "  really will clone: " << collection << endl;
-            const char * from_name = collection["name"].valuestr();
-            BSONObj options = collection.getObjectField("options");
-
-            /* change name "<fromdb>.collection" -> <todb>.collection */
-            const char *p = strchr(from_name, '.');
-            verify(p);
-            string to_name = todb + p;
-
-            bool wantIdIndex = false;
-            {
-                string err;
-                const char *toname = to_name.c_str();
-                /* we defer building id index for performance - building it in batch is much faster */
-                userCreateNS(toname, options, err, opts.logForRepl, &wantIdIndex);
-            }
-            LOG(1) << "\t\t cloning " << from_name << " -> " << to_name << endl;
-            Query q;
-            if( opts.snapshot )
-                q.snapshot();
-            copy(from_name, to_name.c_str(), false, opts.logForRepl, masterSameProcess, opts.slaveOk, opts.mayYield, opts.mayBeInterrupted, q);
-
-            if( wantIdIndex ) {
-                /* we need dropDups to be true as we didn't do a true snapshot and this is before applying oplog operations
-                   that occur during the initial sync.  inDBRepair makes dropDups be true.
-                   */
-                bool old = inDBRepair;
-                try {
-                    inDBRepair = true;
-                    ensureIdIndexForNewNs(to_name.c_str());
-                    inDBRepair = old;
-                }
-                catch(...) {
-                    inDBRepair = old;
-                    throw;
+        if ( opts.parallelCollections > 1 && opts.mayYield && !masterSameProcess &&
+             toClone.size() > 1 ) {
+            if ( !copyCollectionsInParallel( masterHost, opts, todb, toClone, errmsg ) )
+                return false;
+        }
+        else {
+            for ( list<BSONObj>::iterator i=toClone.begin(); i != toClone.end(); i++ ) {
+                {
+                    mayInterrupt( opts.mayBeInterrupted );
+                    dbtempreleaseif r( opts.mayYield );
                 }
+                copyCollectionAndIdIndex( *i, todb, opts, masterSameProcess );
             }
         }
 
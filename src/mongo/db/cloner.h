@@ -92,8 +92,23 @@ namespace mongo {
                   bool masterSameProcess, bool slaveOk, bool mayYield, bool mayBeInterrupted,
                   Query q);
 
+        /** create the collection described by a system.namespaces entry in todb, copy its
+            documents and build its _id index.  caller holds the todb write lock. */
+        void copyCollectionAndIdIndex(const BSONObj& collection, const string& todb,
+                                      const CloneOptions& opts, bool masterSameProcess);
+
+        struct ParallelWork;
+        /** clone toClone over opts.parallelCollections connections of their own */
+        bool copyCollectionsInParallel(const char *masterHost, const CloneOptions& opts,
+                                       const string& todb, const list<BSONObj>& toClone,
+                                       string& errmsg);
+        static void parallelCopyThread(const string& masterHost, const CloneOptions& opts,
+                                       const string& todb, ParallelWork* work);
+
         struct Fun;
         auto_ptr<DBClientBase> _conn;
+        // set for a cloner copying on behalf of copyCollectionsInParallel()
+        ParallelWork* _parallelWork;
     };
 
     struct CloneOptions {
@@ -108,6 +123,8 @@ namespace mongo {
 
             syncData = true;
             syncIndexes = true;
+
+            parallelCollections = 1;
         }
             
         string fromDB;
@@ -122,6 +139,10 @@ namespace mongo {
 
         bool syncData;
         bool syncIndexes;
+
+        // number of collections to copy at once, each over its own connection.  only honored
+        // with mayYield and a remote source; the copying threads are internally authorized.
+        int parallelCollections;
     };
 
 } // namespace mongo
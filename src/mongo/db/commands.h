@@ -212,6 +212,8 @@ namespace mongo {
         bool shutdownHelper();
     };
 
-    bool _runCommands(const char *ns, BSONObj& jsobj, BufBuilder &b, BSONObjBuilder& anObjBuilder, bool fromRepl, int queryOptions);
+    /** runs the command in ns/jsobj if it is one; its result is left in anObjBuilder.
+        @return true if ran a cmd */
+    bool _runCommands(const char *ns, BSONObj& jsobj, BSONObjBuilder& anObjBuilder, bool fromRepl, int queryOptions);
 
 } // namespace mongo
@@ -0,0 +1,72 @@
+/** @file plan_cache.cpp
+    planCache command: list or clear the cached query plans of a collection
+*/
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pch.h"
+
+#include <string>
+#include <vector>
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/namespace_details.h"
+#include "mongo/db/pdfile.h"
+
+namespace mongo {
+
+    class PlanCacheCmd : public Command {
+    public:
+        PlanCacheCmd() : Command( "planCache" ) {}
+        virtual LockType locktype() const { return READ; }
+        virtual bool slaveOk() const { return true; }
+        virtual bool logTheOp() { return false; }
+        virtual void help( stringstream& help ) const {
+            help << "list the query plans cached for a collection, with how they have done since\n"
+                "{ planCache : <collection_name>, [clear : true] }\n"
+                " clear drops the cached plans, so the next query of each shape races its plans\n";
+        }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::planCache);
+            out->push_back(Privilege(parseNs(dbname, cmdObj), actions));
+        }
+        bool run( const string& dbname, BSONObj& cmdObj, int, string& errmsg,
+                  BSONObjBuilder& result, bool fromRepl ) {
+            string ns = dbname + "." + cmdObj.firstElement().valuestrsafe();
+            if ( !nsdetails( ns ) ) {
+                errmsg = "ns not found";
+                return false;
+            }
+
+            SimpleMutex::scoped_lock lk( NamespaceDetailsTransient::_qcMutex );
+            NamespaceDetailsTransient& nsdt = NamespaceDetailsTransient::get_inlock( ns );
+            if ( cmdObj["clear"].trueValue() ) {
+                nsdt.clearQueryCache();
+            }
+            nsdt.appendQueryCacheInfo( &result );
+            return true;
+        }
+    } planCacheCmd;
+
+}
@@ -27,6 +27,7 @@
 #include "mongo/db/dur.h"
 #include "mongo/db/lockstat.h"
 #include "mongo/db/namespacestring.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/server.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/concurrency/mapsf.h"
@@ -53,6 +54,27 @@ namespace mongo {
 
     static const bool DB_LEVEL_LOCKING_ENABLED = ( ( MONGOD_CONCURRENCY_LEVEL ) >= MONGOD_CONCURRENCY_LEVEL_DB );
 
+    // off by default; see Lock::CollectionWrite.  startup only as Database relies on it not
+    // changing once a database is open
+    static bool collectionLevelWriteLocking = false;
+
+    // startup only; a lock's implementation is chosen when it is created
+    static bool readMostlyDBLocksEnabled = false;
+
+    namespace {
+        ExportedServerParameter<bool> ReadMostlyDBLocksSetting( ServerParameterSet::getGlobal(),
+                                                                "readMostlyDBLocks",
+                                                                &readMostlyDBLocksEnabled,
+                                                                true,
+                                                                false );
+
+        ExportedServerParameter<bool> CollectionLevelWriteLockingSetting( ServerParameterSet::getGlobal(),
+                                                                          "collectionLevelWriteLocking",
+                                                                          &collectionLevelWriteLocking,
+                                                                          true,
+                                                                          false );
+    }
+
     inline LockState& lockState() { 
         return cc().lockState();
     }
@@ -88,6 +110,9 @@ namespace mongo {
     typedef mapsf< StringMap<WrapperForRWLock*> > DBLocksMap;
     static DBLocksMap dblocks;
 
+    /* ns->lock for Lock::CollectionWrite. same lifetime rules as dblocks. */
+    static DBLocksMap collectionLocks;
+
     /* we don't want to touch dblocks too much as a mutex is involved.  thus party for that, 
        this is here...
     */
@@ -263,6 +288,12 @@ namespace mongo {
     bool Lock::dbLevelLockingEnabled() {
         return DB_LEVEL_LOCKING_ENABLED;
     }
+    bool Lock::collectionLevelLockingEnabled() {
+        return DB_LEVEL_LOCKING_ENABLED && collectionLevelWriteLocking;
+    }
+    bool Lock::readMostlyDBLocks() {
+        return readMostlyDBLocksEnabled;
+    }
 
     RWLockRecursive &Lock::ParallelBatchWriterMode::_batchLock = *(new RWLockRecursive("special"));
     void Lock::ParallelBatchWriterMode::iAmABatchParticipant() {
@@ -398,6 +429,12 @@ namespace mongo {
     void Lock::DBWrite::_relock() { 
         lockDB(_what);
     }
+    void Lock::CollectionWrite::_tempRelease() { 
+        unlockCollection();
+    }
+    void Lock::CollectionWrite::_relock() { 
+        lockCollection();
+    }
     void Lock::DBRead::_tempRelease() {
         unlockDB();
     }
@@ -519,6 +556,7 @@ namespace mongo {
             // nested. if/when we do temprelease with DBWrite we will need to increment here
             // (so we can not release or assert if nested).
             massert(16106, str::stream() << "internal error tried to lock two databases at the same time. old:" << ls.otherName() << " new:" << db , db == ls.otherName() );
+            massert(16827, str::stream() << "can't lock database " << db << " while holding a collection lock on " << ls.collectionName(), ls.collectionCount() == 0 );
             return;
         }
 
@@ -709,6 +747,7 @@ namespace mongo {
             // nested. prev could be read or write. if/when we do temprelease with DBRead/DBWrite we will need to increment/decrement here
             // (so we can not release or assert if nested).  temprelease we should avoid if we can though, it's a bit of an anti-pattern.
             massert(16099, str::stream() << "internal error tried to lock two databases at the same time. old:" << ls.otherName() << " new:" << db, db == ls.otherName() );
+            massert(16828, str::stream() << "can't lock database " << db << " while holding a collection lock on " << ls.collectionName(), ls.collectionCount() == 0 );
             return;
         }
 
@@ -732,6 +771,102 @@ namespace mongo {
         _weLocked = ls.otherLock();
     }
 
+    Lock::CollectionWrite::CollectionWrite( const StringData& ns )
+        : ScopedLock( 'w' ), _what(ns.toString()) {
+        lockCollection();
+    }
+
+    Lock::CollectionWrite::~CollectionWrite() {
+        unlockCollection();
+    }
+
+    void Lock::CollectionWrite::lockCollection() {
+        fassert( 16829, !_what.empty() );
+        LockState& ls = lockState();
+
+        Acquiring a(this,ls);
+        _locked_w = false;
+        _locked_W = false;
+        _dbLocked = 0;
+        _weLocked = 0;
+
+        massert( 16830 , "can't get a CollectionWrite while having a read lock" , ! ls.hasAnyReadLock() );
+        if( ls.isW() )
+            return;
+
+        if( !DB_LEVEL_LOCKING_ENABLED ) {
+            qlk.lock_W();
+            _locked_W = true;
+            return;
+        }
+
+        StringData db = nsToDatabaseSubstring( _what );
+        massert( 16831, str::stream() << "collection level locking is not available for " << db, n(db) == notnestable );
+
+        // as in lockOther, do all checks before taking anything
+        if( ls.otherCount() ) {
+            massert( 16832, str::stream() << "internal error tried to lock two databases at the same time. old:" << ls.otherName() << " new:" << db , db == ls.otherName() );
+            massert( 16833, str::stream() << "can't get a CollectionWrite on " << _what << " while holding a read lock on " << db, ls.otherCount() > 0 );
+            // nested in a DBWrite (covers us), or in a CollectionWrite which must be ours
+            massert( 16834, str::stream() << "can't lock collection " << _what << " while holding a collection lock on " << ls.collectionName(),
+                     ls.collectionCount() == 0 || ls.collectionName() == _what );
+            return;
+        }
+        massert( 16835, str::stream() << "can't lock collection " << _what << " when local or admin is already locked", ls.nestableCount() == 0 );
+
+        // database in intent mode first, then the global intent lock, as DBWrite does
+        if( db != ls.otherName() ) {
+            DBLocksMap::ref r(dblocks);
+            WrapperForRWLock*& lock = r[db];
+            if( lock == 0 )
+                lock = new WrapperForRWLock(db);
+            ls.lockedOther( db , 1 , lock );
+        }
+        else {
+            ls.lockedOther(1);
+        }
+        ls.otherLock()->lock_intent();
+        _dbLocked = ls.otherLock();
+
+        qlk.lock_w();
+        _locked_w = true;
+
+        if( _what != ls.collectionName() ) {
+            DBLocksMap::ref r(collectionLocks);
+            WrapperForRWLock*& lock = r[_what];
+            if( lock == 0 )
+                lock = new WrapperForRWLock(_what);
+            ls.lockedCollection( _what , 1 , lock );
+        }
+        else {
+            ls.lockedCollection(1);
+        }
+        ls.collectionLock()->lock();
+        _weLocked = ls.collectionLock();
+    }
+
+    void Lock::CollectionWrite::unlockCollection() {
+        LockState& ls = lockState();
+        if( _weLocked ) {
+            recordTime();  // for lock stats
+            ls.unlockedCollection();
+            _weLocked->unlock();
+        }
+        if( _dbLocked ) {
+            ls.unlockedOther();
+            _dbLocked->unlock_intent();
+        }
+        if( _locked_w ) {
+            qlk.unlock_w();
+        }
+        if( _locked_W ) {
+            qlk.unlock_W();
+        }
+        _weLocked = 0;
+        _dbLocked = 0;
+        _locked_W = _locked_w = false;
+    }
+
     Lock::DBWrite::UpgradeToExclusive::UpgradeToExclusive() {
         fassert( 16187, lockState().threadState() == 'w' );
 
@@ -859,6 +994,14 @@ namespace mongo {
                     b.append(i->first, i->second->stats.report());
                 }
             }
+            {
+                // only collections that have seen a CollectionWrite are here; the keys have
+                // a '.' in them which distinguishes them from the database entries above
+                DBLocksMap::ref r(collectionLocks);
+                for( DBLocksMap::const_iterator i = r.r.begin(); i != r.r.end(); ++i ) {
+                    b.append(i->first, i->second->stats.report());
+                }
+            }
             return b.obj();
         }
 
@@ -49,6 +49,14 @@ namespace mongo {
         static void assertWriteLocked(const StringData& ns);
 
         static bool dbLevelLockingEnabled(); 
+
+        /** true if writes may use CollectionWrite instead of DBWrite. see the
+            collectionLevelWriteLocking server parameter */
+        static bool collectionLevelLockingEnabled();
+
+        /** true if database locks are ReadMostlyLocks. see the readMostlyDBLocks server
+            parameter */
+        static bool readMostlyDBLocks();
         
         static LockStat* globalLockStat();
         static LockStat* nestableLockStat( Nestable db );
@@ -193,6 +201,39 @@ namespace mongo {
             bool _nested;
         };
 
+        /** lock a single collection for writing.  the database is held in an intent mode (w on
+            the database's QLock) so writers to other collections of the same database may run
+            concurrently; DBRead and DBWrite on the database still exclude us.  the collection's
+            index namespaces are covered by the lock too.
+
+            only use this when the write touches nothing but the collection's own records and
+            btree indexes -- the caller must check that after acquiring (see instance.cpp).
+            extent and file allocation for the database is serialized by Database itself.
+
+            local and admin are not supported (they are nestable); nothing else may be locked
+            by this thread first except a lock that already covers the collection, in which
+            case this is a noop.
+        */
+        class CollectionWrite : public ScopedLock {
+            void lockCollection();
+            void unlockCollection();
+
+        protected:
+            void _tempRelease();
+            void _relock();
+
+        public:
+            CollectionWrite(const StringData& ns);
+            virtual ~CollectionWrite();
+
+        private:
+            bool _locked_w;
+            bool _locked_W;
+            WrapperForRWLock *_dbLocked;
+            WrapperForRWLock *_weLocked;
+            const string _what;
+        };
+
         // lock this database for reading. do not shared_lock globally first, that is handledin herein. 
         class DBRead : public ScopedLock {
             void lockTop(LockState&);
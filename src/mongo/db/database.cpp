@@ -61,7 +61,7 @@ namespace mongo {
     }
 
     Database::Database(const char *nm, bool& newDb, const string& _path )
-        : name(nm), path(_path), namespaceIndex( path, name ),
+        : name(nm), path(_path), _allocMutex("allocExtent"), namespaceIndex( path, name ),
           profileName(name + ".system.profile")
     {
         try {
@@ -88,6 +88,11 @@ namespace mongo {
                 }
 #endif
             }
+            if ( Lock::collectionLevelLockingEnabled() ) {
+                // collection writers may grow _files (in allocExtent) while others read it,
+                // so it must never reallocate
+                _files.reserve( DiskLoc::MaxFiles );
+            }
             newDb = namespaceIndex.exists();
             _profile = cmdLine.defaultProfile;
             checkDuplicateUncasedNames(true);
@@ -394,6 +399,7 @@ namespace mongo {
 
 
     Extent* Database::allocExtent( const char *ns, int size, bool capped, bool enforceQuota ) {
+        SimpleMutex::scoped_lock lk( _allocMutex );
         // todo: when profiling, these may be worth logging into profile collection
         bool fromFreeList = true;
         Extent *e = DataFileMgr::allocFromFreeList( ns, size, capped );
@@ -22,6 +22,7 @@
 #include "mongo/db/cmdline.h"
 #include "mongo/db/namespace_details.h"
 #include "mongo/db/record.h"
+#include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
 
@@ -135,6 +136,10 @@ namespace mongo {
         //   to others and we are in the dbholder lock then.
         vector<MongoDataFile*> _files;
 
+        // held by allocExtent.  writers holding only a Lock::CollectionWrite share the database,
+        // so the free list and new data files can't rely on the database lock alone
+        SimpleMutex _allocMutex;
+
     public: // this should be private later
 
         NamespaceIndex namespaceIndex;
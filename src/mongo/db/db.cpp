@@ -49,6 +49,7 @@
 #include "mongo/db/stats/counters.h"
 #include "mongo/db/stats/snapshots.h"
 #include "mongo/db/ttl.h"
+#include "mongo/s/d_logic.h"
 #include "mongo/s/d_writeback.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/background.h"
@@ -236,6 +237,36 @@ namespace mongo {
             globalScriptEngine->threadDone();
         }
 
+        virtual bool canMoveBetweenThreads() const { return true; }
+
+        virtual ThreadState* detachFromThread( AbstractMessagingPort* p ) {
+            ConnectionState* s = new ConnectionState();
+            s->client = currentClient.release();
+            s->sharding = ShardedConnectionInfo::release();
+            return s;
+        }
+
+        virtual void attachToThread( AbstractMessagingPort* p , ThreadState* state ) {
+            scoped_ptr<ConnectionState> s( static_cast<ConnectionState*>( state ) );
+            verify( currentClient.get() == 0 );
+            currentClient.reset( s->client );
+            ShardedConnectionInfo::set( s->sharding );
+            s->client = 0;
+            s->sharding = 0;
+        }
+
+    private:
+        class ConnectionState : public ThreadState {
+        public:
+            ConnectionState() : client(0), sharding(0) {}
+            virtual ~ConnectionState() {
+                delete sharding;
+                delete client;
+            }
+            Client* client;
+            ShardedConnectionInfo* sharding;
+        };
+
     };
 
     void logStartup() {
@@ -2176,7 +2176,7 @@ namespace mongo {
 
        returns true if ran a cmd
     */
-    bool _runCommands(const char *ns, BSONObj& _cmdobj, BufBuilder &b, BSONObjBuilder& anObjBuilder, bool fromRepl, int queryOptions) {
+    bool _runCommands(const char *ns, BSONObj& _cmdobj, BSONObjBuilder& anObjBuilder, bool fromRepl, int queryOptions) {
         string dbname = nsToDatabase( ns );
 
         if( logLevel >= 1 )
@@ -2222,9 +2222,6 @@ namespace mongo {
             anObjBuilder.append("bad cmd" , _cmdobj );
         }
 
-        BSONObj x = anObjBuilder.done();
-        b.appendBuf((void*) x.objdata(), x.objsize());
-
         return true;
     }
 
@@ -91,10 +91,16 @@ namespace mongo {
     }
 
     void replyToQuery( int queryResultFlags, Message& response, const BSONObj& resultObj ) {
-        BufBuilder bufBuilder;
+        // big owned results (aggregate, inline map/reduce, ...) are sent from their own buffer
+        // after the header rather than copied in behind it
+        const bool byReference = resultObj.isOwned() && resultObj.objsize() >= 64 * 1024;
+
+        BufBuilder bufBuilder( byReference ? sizeof( QueryResult ) : 512 );
         bufBuilder.skip( sizeof( QueryResult ));
-        bufBuilder.appendBuf( reinterpret_cast< void *>(
-                const_cast< char* >( resultObj.objdata() )), resultObj.objsize() );
+        if ( !byReference ) {
+            bufBuilder.appendBuf( reinterpret_cast< void *>(
+                    const_cast< char* >( resultObj.objdata() )), resultObj.objsize() );
+        }
 
         QueryResult* queryResult = reinterpret_cast< QueryResult* >( bufBuilder.buf() );
         bufBuilder.decouple();
@@ -107,6 +113,11 @@ namespace mongo {
         queryResult->nReturned = 1;
 
         response.setData( queryResult, true ); // transport will free
+        if ( byReference ) {
+            // the copy of resultObj shares its buffer, keeping the bytes alive until sent
+            boost::shared_ptr<void> holder( new BSONObj( resultObj ) );
+            response.appendPinned( resultObj.objdata(), resultObj.objsize(), holder );
+        }
     }
 
 }
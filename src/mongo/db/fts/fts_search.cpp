@@ -60,14 +60,112 @@ namespace mongo {
             return _ftsMatcher.matchesNonTerm( BSONObj::make( record ) );
         }
 
+        namespace {
+            // with more terms than this we can't tell which postings of a document we have
+            // not seen, so all the postings are read
+            const unsigned MaxTermsForEarlyFinish = 64;
+
+            const size_t InitialScoreSlots = 1024;
+
+            size_t hashRecord( const Record* rec ) {
+                unsigned long long h = reinterpret_cast<size_t>( rec );
+                h *= 0x9e3779b97f4a7c15ULL;
+                return static_cast<size_t>( h ^ ( h >> 32 ) );
+            }
+
+            bool higherScore( const ScoreTable::Entry* a, const ScoreTable::Entry* b ) {
+                return a->score > b->score;
+            }
+
+            // adds one more term's weight to a score the way the postings always have
+            double addWeight( double score, double weight ) {
+                if ( score )
+                    return score + weight * ( 1 + 1 / weight );
+                return score + weight;
+            }
+        }
+
+        ScoreTable::ScoreTable() : _size( 0 ) {
+            Entry empty;
+            empty.rec = NULL;
+            empty.score = 0;
+            empty.terms = 0;
+            empty.verified = false;
+            _slots.assign( InitialScoreSlots, empty );
+        }
+
+        ScoreTable::Entry& ScoreTable::findOrInsert( Record* rec, bool* pInserted ) {
+            size_t mask = _slots.size() - 1;
+            size_t i = hashRecord( rec ) & mask;
+            while ( _slots[i].rec ) {
+                if ( _slots[i].rec == rec ) {
+                    *pInserted = false;
+                    return _slots[i];
+                }
+                i = ( i + 1 ) & mask;
+            }
+
+            // keep the table at most half full
+            if ( ( _size + 1 ) * 2 > _slots.size() ) {
+                _grow();
+                mask = _slots.size() - 1;
+                i = hashRecord( rec ) & mask;
+                while ( _slots[i].rec )
+                    i = ( i + 1 ) & mask;
+            }
+
+            _size++;
+            _slots[i].rec = rec;
+            *pInserted = true;
+            return _slots[i];
+        }
+
+        void ScoreTable::_grow() {
+            vector<Entry> old;
+            old.swap( _slots );
+
+            Entry empty;
+            empty.rec = NULL;
+            empty.score = 0;
+            empty.terms = 0;
+            empty.verified = false;
+            _slots.assign( old.size() * 2, empty );
+
+            const size_t mask = _slots.size() - 1;
+            for ( size_t j = 0; j < old.size(); j++ ) {
+                if ( !old[j].rec )
+                    continue;
+                size_t i = hashRecord( old[j].rec ) & mask;
+                while ( _slots[i].rec )
+                    i = ( i + 1 ) & mask;
+                _slots[i] = old[j];
+            }
+        }
+
+        void ScoreTable::getEntries( vector<Entry*>* entries ) {
+            entries->reserve( _size );
+            for ( size_t i = 0; i < _slots.size(); i++ ) {
+                if ( _slots[i].rec )
+                    entries->push_back( &_slots[i] );
+            }
+        }
+
         /*
-         * GO: sets the tree cursors on each term in terms,  processes the terms by advancing
-         * the terms cursors and storing the partial
-         * results and lastly calculates the top results
+         * GO: sets the tree cursors on each term in terms, and reads the postings of all the
+         * terms in parallel, keeping a partial score for every document seen.
+         *
+         * The postings of a term come in order of descending weight, so the weight each
+         * cursor is on bounds what is left of that term.  From time to time we check whether
+         * those bounds already settle which documents are the top results (see _tryFinish),
+         * and stop reading postings as soon as they do.
+         *
          * @param results, the priority queue containing the top results
          * @param limit, number of results in the priority queue
          */
         void FTSSearch::go(Results* results, unsigned limit ) {
+            if ( limit == 0 )
+                return;
+
             vector< shared_ptr<BtreeCursor> > cursors;
 
             for ( unsigned i = 0; i < _query.getTerms().size(); i++ ) {
@@ -83,97 +181,182 @@ namespace mongo {
                 cursors.push_back( c );
             }
 
+            vector<double> heads( cursors.size() );
+            for ( unsigned i = 0; i < cursors.size(); i++ )
+                heads[i] = cursors[i]->eof() ? -1 : _currentWeight( cursors[i].get() );
+
+            const bool canFinishEarly = cursors.size() <= MaxTermsForEarlyFinish;
+            // checking costs about as much as reading the postings seen so far, so check
+            // each time that number doubles
+            long long nextCheck = limit;
+
             while ( !inShutdown() ) {
                 bool gotAny = false;
                 for ( unsigned i = 0; i < cursors.size(); i++ ) {
                     if ( cursors[i]->eof() )
                         continue;
                     gotAny = true;
-                    _process( cursors[i].get() );
+                    _process( cursors[i].get(), i );
                     cursors[i]->advance();
+                    heads[i] = cursors[i]->eof() ? -1 : _currentWeight( cursors[i].get() );
                 }
 
                 if ( !gotAny )
                     break;
 
+                if ( canFinishEarly && _keysLookedAt >= nextCheck ) {
+                    if ( _tryFinish( results, limit, heads ) )
+                        return;
+                    nextCheck = _keysLookedAt * 2;
+                }
+
                 RARELY killCurrentOp.checkForInterrupt();
             }
 
+            // we have read every posting (or are shutting down): the partial scores are all
+            // there is
+            std::fill( heads.begin(), heads.end(), -1 );
+            bool finished = _tryFinish( results, limit, heads );
+            verify( finished );
+        }
 
-            // priority queue using a compare that grabs the lowest of two ScoredLocations by score.
-            for ( Scores::iterator i = _scores.begin(); i != _scores.end(); ++i ) {
-
-                if ( i->second < 0 )
+        bool FTSSearch::_tryFinish( Results* results,
+                                    unsigned limit,
+                                    const vector<double>& heads ) {
+            // a document we haven't seen can have at most every term, at the weight its
+            // cursor is on
+            bool anyLeft = false;
+            double unseenBound = 0;
+            for ( unsigned i = 0; i < heads.size(); i++ ) {
+                if ( heads[i] < 0 )
                     continue;
+                unseenBound = addWeight( unseenBound, heads[i] );
+                anyLeft = true;
+            }
 
-                // priority queue
-                if ( results->size() < limit ) { // case a: queue unfilled
-
-                    if ( !_ok( i->first ) )
+            vector<ScoreTable::Entry*> entries;
+            _scores.getEntries( &entries );
+            std::sort( entries.begin(), entries.end(), higherScore );
+
+            // the best documents seen so far that pass the phrase and negation checks
+            vector<ScoreTable::Entry*> chosen;
+            size_t next = 0;
+            for ( ; next < entries.size() && chosen.size() < limit; next++ ) {
+                ScoreTable::Entry* entry = entries[next];
+                if ( entry->score < 0 )
+                    break; // the rest are rejected too
+                if ( !entry->verified ) {
+                    if ( !_ok( entry->rec ) ) {
+                        entry->score = -1;
                         continue;
-
-                    results->push( ScoredLocation( i->first, i->second ) );
-
+                    }
+                    entry->verified = true;
                 }
-                else if ( i->second > results->top().score ) { // case b: queue filled
-
-                    if ( !_ok( i->first ) )
-                        continue;
+                chosen.push_back( entry );
+            }
 
-                    results->pop();
-                    results->push( ScoredLocation( i->first, i->second ) );
+            if ( anyLeft ) {
+                // scores only grow, so the lowest chosen score is a floor for the results.
+                // no other document may be able to get above it.
+                if ( chosen.size() < limit )
+                    return false;
+                const double floor = chosen.back()->score;
+
+                if ( unseenBound > floor )
+                    return false;
+
+                for ( ; next < entries.size(); next++ ) {
+                    const ScoreTable::Entry* entry = entries[next];
+                    if ( entry->score < 0 )
+                        break;
+
+                    double bound = entry->score;
+                    for ( unsigned i = 0; i < heads.size(); i++ ) {
+                        if ( heads[i] >= 0 && !( entry->terms & ( 1ULL << i ) ) )
+                            bound = addWeight( bound, heads[i] );
+                    }
+                    if ( bound > floor )
+                        return false;
                 }
-                else {
-                    // else do nothing (case c)
-                }
-
             }
 
+            for ( unsigned i = 0; i < chosen.size(); i++ ) {
+                results->push( ScoredLocation( chosen[i]->rec,
+                                               _completeScore( *chosen[i], heads ) ) );
+            }
+            return true;
         }
 
-        /*
-         * Takes a cursor and updates the partial score for said cursor in _scores map
-         * @param cursor, btree cursor pointing to the current document to be scored
-         */
-        void FTSSearch::_process( BtreeCursor* cursor ) {
-            _keysLookedAt++;
+        double FTSSearch::_completeScore( const ScoreTable::Entry& entry,
+                                          const vector<double>& heads ) {
+            vector<unsigned> missing;
+            for ( unsigned i = 0; i < heads.size(); i++ ) {
+                if ( heads[i] >= 0 && !( entry.terms & ( 1ULL << i ) ) )
+                    missing.push_back( i );
+            }
+            if ( missing.empty() )
+                return entry.score;
+
+            // the weights in the index come from scoring the document, so scoring it again
+            // gives the postings we haven't read
+            _objectsLookedAt++;
+            TermFrequencyMap weights;
+            _ftsSpec.scoreDocument( BSONObj::make( entry.rec ), &weights );
+
+            double score = entry.score;
+            for ( unsigned i = 0; i < missing.size(); i++ ) {
+                TermFrequencyMap::const_iterator w = weights.find( _query.getTerms()[missing[i]] );
+                if ( w != weights.end() )
+                    score = addWeight( score, w->second );
+            }
+            return score;
+        }
 
+        double FTSSearch::_currentWeight( BtreeCursor* cursor ) const {
             BSONObj key = cursor->currKey();
 
             BSONObjIterator i( key );
             for ( unsigned j = 0; j < _ftsSpec.numExtraBefore(); j++)
                 i.next();
             i.next(); // move past indexToken
-            BSONElement scoreElement = i.next();
+            return i.next().number();
+        }
 
-            double score = scoreElement.number();
+        /*
+         * Takes a cursor and updates the partial score for said cursor in _scores
+         * @param cursor, btree cursor pointing to the current document to be scored
+         * @param termNumber, which of the query's terms cursor is for
+         */
+        void FTSSearch::_process( BtreeCursor* cursor, unsigned termNumber ) {
+            _keysLookedAt++;
+
+            double score = _currentWeight( cursor );
 
-            double& cur = _scores[(cursor->currLoc()).rec()];
+            bool inserted;
+            ScoreTable::Entry& cur = _scores.findOrInsert( cursor->currLoc().rec(), &inserted );
 
-            if ( cur < 0 ) {
+            if ( cur.score < 0 ) {
                 // already been rejected
                 return;
             }
 
-            if ( cur == 0 && _matcher.get() ) {
+            if ( inserted && _matcher.get() ) {
                 // we haven't seen this before and we have a matcher
                 MatchDetails d;
                 if ( !_matcher->matchesCurrent( cursor, &d ) ) {
-                    cur = -1;
+                    cur.score = -1;
                 }
 
                 if ( d.hasLoadedRecord() )
                     _objectsLookedAt++;
 
-                if ( cur == -1 )
+                if ( cur.score == -1 )
                     return;
             }
 
-            if ( cur )
-                cur += score * (1 + 1 / score);
-            else
-                cur += score;
-
+            if ( termNumber < MaxTermsForEarlyFinish )
+                cur.terms |= 1ULL << termNumber;
+            cur.score = addWeight( cur.score, score );
         }
 
     }
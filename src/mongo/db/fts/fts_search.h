@@ -18,7 +18,6 @@
 
 #pragma once
 
-#include <map>
 #include <set>
 #include <vector>
 #include <queue>
@@ -51,12 +50,40 @@ namespace mongo {
 
         typedef a_priority_queue<ScoredLocation, vector<ScoredLocation>, ScoredLocationComp> Results;
 
+        /**
+         * The partial score of every document a search has seen so far, in a flat open
+         * addressing table keyed by Record*.
+         */
+        class ScoreTable {
+        public:
+            struct Entry {
+                Record* rec;          // NULL if the slot is free
+                double score;         // sum of the postings seen so far; < 0 if rejected
+                unsigned long long terms; // bit i set: term i's posting has been seen
+                bool verified;        // passed FTSSearch::_ok()
+            };
+
+            ScoreTable();
+
+            /** @param pInserted set to whether rec is new, with a zero score */
+            Entry& findOrInsert( Record* rec, bool* pInserted );
+
+            size_t size() const { return _size; }
+
+            /** pointers to every entry, in no particular order */
+            void getEntries( std::vector<Entry*>* entries );
+
+        private:
+            void _grow();
+
+            std::vector<Entry> _slots; // size is a power of 2
+            size_t _size;
+        };
+
         class FTSSearch {
             MONGO_DISALLOW_COPYING(FTSSearch);
         public:
 
-            typedef std::map<Record*,double> Scores;
-
             FTSSearch( IndexDescriptor* descriptor,
                        const FTSSpec& ftsSpec,
                        const BSONObj& indexPrefix,
@@ -70,7 +97,28 @@ namespace mongo {
 
         private:
 
-            void _process( BtreeCursor* cursor );
+            /**
+             * Adds the posting cursor i is on to the document's partial score
+             */
+            void _process( BtreeCursor* cursor, unsigned i );
+
+            /** the weight in the posting cursor is on */
+            double _currentWeight( BtreeCursor* cursor ) const;
+
+            /**
+             * Puts the top limit documents in results if they are already known: when no
+             * document outside them, seen or not, can still score higher than the lowest of
+             * them.  The scores of the chosen documents are completed from the documents
+             * themselves where postings for them have not been read yet.
+             *
+             * @param heads the weight each posting cursor is on, -1 if it is exhausted
+             * @return false if more postings have to be read first
+             */
+            bool _tryFinish( Results* results, unsigned limit, const std::vector<double>& heads );
+
+            /** completes the score of a document whose postings we have not all seen */
+            double _completeScore( const ScoreTable::Entry& entry,
+                                   const std::vector<double>& heads );
 
             /**
              * checks not index pieces
@@ -89,7 +137,7 @@ namespace mongo {
             long long _keysLookedAt;
             long long _objectsLookedAt;
 
-            Scores _scores;
+            ScoreTable _scores;
 
         };
 
@@ -109,6 +109,7 @@ namespace mongo {
         // point-only.  We tag it as intersect and limit $within to
         // space-containing geometry.
         if (GeoParser::isPoint(obj) && geoContainer.parseFrom(obj)) {
+            geometry = obj.getOwned();
             predicate = GeoQuery::INTERSECT;
             return true;
         }
@@ -121,6 +122,7 @@ namespace mongo {
         // Legacy within #2 : t.find({ loc : { $within : { $box/etc : ...
         bool contains = (BSONObj::opWITHIN == static_cast<BSONObj::MatchType>(e.getGtLtOp()));
         if (contains && geoContainer.parseFrom(embeddedObj)) {
+            geometry = embeddedObj.getOwned();
             predicate = GeoQuery::WITHIN;
             return true;
         }
@@ -153,6 +155,7 @@ namespace mongo {
                 if (e.isABSONObj()) {
                     BSONObj embeddedObj = e.embeddedObject();
                      if (geoContainer.parseFrom(embeddedObj)) {
+                         geometry = embeddedObj.getOwned();
                          hasGeometry = true;
                      }
                 }
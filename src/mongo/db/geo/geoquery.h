@@ -109,6 +109,8 @@ namespace mongo {
         bool hasS2Region() const;
         const S2Region& getRegion() const;
         string getField() const { return field; }
+        // The geometry as it was given in the query, identifying the region for caching.
+        const BSONObj& getGeometry() const { return geometry; }
     private:
         // Try to parse the provided object into the right place.
         bool parseLegacyQuery(const BSONObj &obj);
@@ -117,6 +119,7 @@ namespace mongo {
         // Name of the field in the query.
         string field;
         GeometryContainer geoContainer;
+        BSONObj geometry;
         Predicate predicate;
     };
 }  // namespace mongo
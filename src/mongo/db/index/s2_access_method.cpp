@@ -152,10 +152,19 @@ namespace mongo {
         *keys = keysToAdd;
     }
 
+    static S2RegionCoverer* lazyCoverer(const S2IndexingParams& params,
+                                        scoped_ptr<S2RegionCoverer>* coverer) {
+        if (!*coverer) {
+            coverer->reset(new S2RegionCoverer());
+            params.configureCoverer(coverer->get());
+        }
+        return coverer->get();
+    }
+
     // Get the index keys for elements that are GeoJSON.
     void S2AccessMethod::getGeoKeys(const BSONElementSet& elements, BSONObjSet* out) const {
-        S2RegionCoverer coverer;
-        _params.configureCoverer(&coverer);
+        // Only lines and polygons need covering, and most inserts are points.
+        scoped_ptr<S2RegionCoverer> coverer;
 
         // See here for GeoJSON format: geojson.org/geojson-spec.html
         for (BSONElementSet::iterator i = elements.begin(); i != elements.end(); ++i) {
@@ -164,20 +173,22 @@ namespace mongo {
             const BSONObj &obj = i->Obj();
 
             vector<string> cells;
+            S2Point point;
             S2Polyline line;
-            S2Cell point;
-            // We only support GeoJSON polygons.  Why?:
-            // 1. we don't automagically do WGS84/flat -> WGS84, and
-            // 2. the old polygon format must die.
-            if (GeoParser::isGeoJSONPolygon(obj)) {
+            if (GeoParser::parsePoint(obj, &point)) {
+                // A point is keyed by the cell containing it at the finest indexed level, which
+                // we get straight from its leaf cell id.
+                cells.push_back(S2CellId::FromPoint(point).parent(_params.finestIndexedLevel)
+                                .toString());
+            } else if (GeoParser::isGeoJSONPolygon(obj)) {
+                // We only support GeoJSON polygons.  Why?:
+                // 1. we don't automagically do WGS84/flat -> WGS84, and
+                // 2. the old polygon format must die.
                 S2Polygon polygon;
                 GeoParser::parseGeoJSONPolygon(obj, &polygon);
-                keysFromRegion(&coverer, polygon, &cells);
+                keysFromRegion(lazyCoverer(_params, &coverer), polygon, &cells);
             } else if (GeoParser::parseLineString(obj, &line)) {
-                keysFromRegion(&coverer, line, &cells);
-            } else if (GeoParser::parsePoint(obj, &point)) {
-                S2CellId parent(point.id().parent(_params.finestIndexedLevel));
-                cells.push_back(parent.toString());
+                keysFromRegion(lazyCoverer(_params, &coverer), line, &cells);
             } else {
                 uasserted(16755, "Can't extract geo keys from object, malformed geometry?:"
                         + obj.toString());
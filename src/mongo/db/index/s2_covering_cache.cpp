@@ -0,0 +1,112 @@
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/db/index/s2_covering_cache.h"
+
+#include <vector>
+
+#include "mongo/base/counter.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/index/s2_common.h"
+#include "third_party/s2/s2region.h"
+
+namespace mongo {
+
+    static Counter64 coveringCacheHits;
+    static ServerStatusMetricField<Counter64> displayCoveringCacheHits(
+            "geo.s2CoveringCache.hits", &coveringCacheHits );
+    static Counter64 coveringCacheMisses;
+    static ServerStatusMetricField<Counter64> displayCoveringCacheMisses(
+            "geo.s2CoveringCache.misses", &coveringCacheMisses );
+
+    S2CoveringCache& S2CoveringCache::get() {
+        static S2CoveringCache cache;
+        return cache;
+    }
+
+    string S2CoveringCache::makeKey(const BSONObj& regionKey, const string& field,
+                                    const S2RegionCoverer& coverer, int coarsestIndexedLevel) {
+        BSONObjBuilder keyBuilder;
+        keyBuilder.append("r", regionKey);
+        keyBuilder.append("f", field);
+        keyBuilder.append("min", coverer.min_level());
+        keyBuilder.append("max", coverer.max_level());
+        keyBuilder.append("cells", coverer.max_cells());
+        keyBuilder.append("coarsest", coarsestIndexedLevel);
+        BSONObj keyObj = keyBuilder.obj();
+        return string(keyObj.objdata(), keyObj.objsize());
+    }
+
+    BSONObj S2CoveringCache::coverAsBSON(const S2Region& region, const BSONObj& regionKey,
+                                         const string& field, S2RegionCoverer* coverer,
+                                         int coarsestIndexedLevel, size_t* cellsInCover) {
+        const string key = makeKey(regionKey, field, *coverer, coarsestIndexedLevel);
+
+        {
+            SimpleMutex::scoped_lock lk(_mutex);
+            unordered_map<string, Entries::iterator>::const_iterator it = _index.find(key);
+            if (it != _index.end()) {
+                coveringCacheHits.increment();
+                _entries.splice(_entries.begin(), _entries, it->second);
+                const Covering& covering = it->second->second;
+                if (NULL != cellsInCover) { *cellsInCover = covering.cells; }
+                return covering.ranges;
+            }
+        }
+
+        // Cover without the lock, a racing thread covering the same region just does it twice.
+        coveringCacheMisses.increment();
+        vector<S2CellId> cover;
+        coverer->GetCovering(region, &cover);
+        if (NULL != cellsInCover) { *cellsInCover = cover.size(); }
+        if (cover.empty()) { return BSONObj(); }
+
+        Covering covering;
+        covering.ranges = S2SearchUtil::coverAsBSON(cover, field, coarsestIndexedLevel);
+        covering.cells = cover.size();
+
+        SimpleMutex::scoped_lock lk(_mutex);
+        if (_index.find(key) == _index.end()) {
+            _entries.push_front(make_pair(key, covering));
+            _index[key] = _entries.begin();
+            if (_entries.size() > MaxEntries) {
+                _index.erase(_entries.back().first);
+                _entries.pop_back();
+            }
+        }
+        return covering.ranges;
+    }
+
+    bool S2CoveringCache::contains(const BSONObj& regionKey, const string& field,
+                                   const S2RegionCoverer& coverer,
+                                   int coarsestIndexedLevel) const {
+        const string key = makeKey(regionKey, field, coverer, coarsestIndexedLevel);
+        SimpleMutex::scoped_lock lk(_mutex);
+        return _index.find(key) != _index.end();
+    }
+
+    size_t S2CoveringCache::size() const {
+        SimpleMutex::scoped_lock lk(_mutex);
+        return _entries.size();
+    }
+
+    void S2CoveringCache::clear() {
+        SimpleMutex::scoped_lock lk(_mutex);
+        _entries.clear();
+        _index.clear();
+    }
+
+}  // namespace mongo
@@ -0,0 +1,88 @@
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <list>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/unordered_map.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "third_party/s2/s2regioncoverer.h"
+
+class S2Region;
+
+namespace mongo {
+
+    /**
+     * Remembers the index key ranges covering recently queried regions, so that a 2dsphere query
+     * repeating a geometry doesn't run the S2RegionCoverer again.  Covering a polygon is most of
+     * the cost of starting a small geo query.
+     *
+     * A covering depends only on the region, the field and the coverer's settings, which together
+     * make the key, so entries never go stale.  The least recently used entry is dropped once
+     * MaxEntries are held.
+     */
+    class S2CoveringCache {
+        MONGO_DISALLOW_COPYING(S2CoveringCache);
+    public:
+        static const size_t MaxEntries = 1000;
+
+        S2CoveringCache() : _mutex("S2CoveringCache") { }
+
+        /** The cache shared by all the 2dsphere cursors. */
+        static S2CoveringCache& get();
+
+        /**
+         * @return the FieldRangeSet expression matching the keys of 'field' that 'coverer''s
+         * covering of 'region' may intersect, as built by S2SearchUtil::coverAsBSON(), or an
+         * empty object if the region has no covering.  'regionKey' must identify 'region': equal
+         * keys with equal fields and coverer settings are assumed to cover alike.  If
+         * 'cellsInCover' is non-NULL it is set to the number of cells in the covering.
+         */
+        BSONObj coverAsBSON(const S2Region& region, const BSONObj& regionKey, const string& field,
+                            S2RegionCoverer* coverer, int coarsestIndexedLevel,
+                            size_t* cellsInCover = NULL);
+
+        /**
+         * @return true if a covering is held for 'regionKey', 'field' and the coverer's settings,
+         * without making it the most recently used.
+         */
+        bool contains(const BSONObj& regionKey, const string& field,
+                      const S2RegionCoverer& coverer, int coarsestIndexedLevel) const;
+
+        size_t size() const;
+        void clear();
+
+    private:
+        static string makeKey(const BSONObj& regionKey, const string& field,
+                              const S2RegionCoverer& coverer, int coarsestIndexedLevel);
+
+        struct Covering {
+            BSONObj ranges;
+            size_t cells;
+        };
+        typedef std::list<std::pair<string, Covering> > Entries;
+
+        mutable SimpleMutex _mutex;
+        // Most recently used first.
+        Entries _entries;
+        unordered_map<string, Entries::iterator> _index;
+    };
+
+}  // namespace mongo
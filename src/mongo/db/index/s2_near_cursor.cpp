@@ -19,6 +19,7 @@
 #include "mongo/db/btreecursor.h"
 #include "mongo/db/index/index_cursor.h"
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index/s2_covering_cache.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/queryutil.h"
 #include "third_party/s2/s2regionintersection.h"
@@ -38,6 +39,8 @@ namespace mongo {
         _stats = Stats();
         _returned = unordered_set<DiskLoc, DiskLoc::Hasher>();
         _results = priority_queue<Result>();
+        _examined = unordered_set<DiskLoc, DiskLoc::Hasher>();
+        _scannedCells.Init(vector<S2CellId>());
 
         BSONObjBuilder geoFieldsToNuke;
         for (size_t i = 0; i < _indexedGeoFields.size(); ++i) {
@@ -67,9 +70,26 @@ namespace mongo {
             ++_nearFieldIndex;
         }
 
+        // Cover the indexed geo components of the query.  They're the same in every annulus.
+        S2RegionCoverer coverer;
+        _params.configureCoverer(&coverer);
+        BSONObjBuilder indexedGeoRanges;
+        for (size_t i = 0; i < _indexedGeoFields.size(); ++i) {
+            BSONObj fieldRange = S2CoveringCache::get().coverAsBSON(
+                    _indexedGeoFields[i].getRegion(), _indexedGeoFields[i].getGeometry(),
+                    _indexedGeoFields[i].getField(), &coverer, _params.coarsestIndexedLevel);
+            uassert(16761, "Couldn't generate index keys for geo field "
+                    + _indexedGeoFields[i].getField(),
+                    !fieldRange.isEmpty());
+            indexedGeoRanges.appendElements(fieldRange);
+        }
+        _indexedGeoRanges = indexedGeoRanges.obj();
+
         // _outerRadius can't be greater than (pi * r) or we wrap around the opposite
         // side of the world.
         _maxDistance = min(M_PI * _params.radius, _nearQuery.maxDistance);
+        _searchCap = S2Cap::FromAxisAngle(_nearQuery.centroid,
+                S1Angle::Radians(_maxDistance / _params.radius));
 
         // Start with a conservative _radiusIncrement.
         _radiusIncrement = 5 * S2::kAvgEdge.GetValue(_params.finestIndexedLevel) * _params.radius;
@@ -78,6 +98,7 @@ namespace mongo {
         // isn't local to the start point.
         // Set up _outerRadius with proper checks (maybe maxDistance is really small?)
         nextAnnulus();
+        scanAnnulus();
         fillResults();
     }
 
@@ -101,58 +122,52 @@ namespace mongo {
         return Status::OK();
     }
 
-    bool S2NearIndexCursor::isEOF() const {
-        if (_innerRadius > _maxDistance) {
-            return true;
-        }
-
-        return _results.empty();
-    }
+    bool S2NearIndexCursor::isEOF() const { return _results.empty(); }
 
     BSONObj S2NearIndexCursor::getKey() const { return _results.top().key; }
     DiskLoc S2NearIndexCursor::getValue() const { return _results.top().loc; }
     string S2NearIndexCursor::toString() { return "S2NearCursor"; }
 
     void S2NearIndexCursor::next() {
-        if (_innerRadius > _maxDistance) {
-            LOG(2) << "advancing but exhausted search distance" << endl;
-        }
-
         if (!_results.empty()) {
             _returnedDistance = _results.top().distance;
             _returned.insert(_results.top().loc);
             _results.pop();
             ++_stats._numReturned;
-            // Safe to grow the radius as we've returned everything in our shell.  We don't do this
-            // check outside of !_results.empty() because we could have results, yield, dump them
-            // (_results would be empty), then need to recreate them w/the same radii.  In that case
-            // we'd grow when we shouldn't.
-            if (_results.empty()) { nextAnnulus(); }
         }
 
-        if (_results.empty()) { fillResults(); }
+        fillResults();
     }
 
     Status S2NearIndexCursor::savePosition() {
+        // Once the search is over there is nothing to forget.
+        if (_results.empty()) { return Status::OK(); }
+
+        // Documents may move or be deleted during the yield, so we forget everything we've
+        // examined but not returned.
         _results = priority_queue<Result>();
+        _examined = unordered_set<DiskLoc, DiskLoc::Hasher>();
+        _scannedCells.Init(vector<S2CellId>());
         return Status::OK();
     }
 
     Status S2NearIndexCursor::restorePosition() {
-        if (_results.empty()) {
+        if (_results.empty() && 0 == _scannedCells.num_cells()) {
+            // savePosition() forgot what we'd scanned.  Look again at everything that may not
+            // have been returned, from the last distance returned out to the edge of the area
+            // searched so far.
+            _innerRadius = min(_returnedDistance, _outerRadius);
+            scanAnnulus();
             fillResults();
         }
         return Status::OK();
     }
 
-    // Make the object that describes all keys that are within our current search annulus.
+    // Make the object that describes the keys in our current search annulus that are not in the
+    // cells we've already scanned.  Returns an empty object if there are no such keys.
     BSONObj S2NearIndexCursor::makeFRSObject() {
-        BSONObjBuilder frsObjBuilder;
-        frsObjBuilder.appendElements(_filteredQuery);
-
         S2RegionCoverer coverer;
-        // Step 1: Make the BSON'd covering for our search annulus.
-        BSONObj inExpr;
+        // Step 1: Make the covering for our search annulus.
         // Caps are inclusive and inverting a cap includes the border.  This means that our
         // initial _innerRadius of 0 is OK -- we'll still find a point that is exactly at
         // the start of our search.
@@ -170,63 +185,67 @@ namespace mongo {
         vector<S2CellId> cover;
         S2SearchUtil::setCoverLimitsBasedOnArea(area, &coverer, _params.coarsestIndexedLevel);
         coverer.GetCovering(_annulus, &cover);
-        LOG(2) << "annulus cover size is " << cover.size()
-            << ", params (" << coverer.min_level() << ", " << coverer.max_level() << ")"
-            << endl;
-        inExpr = S2SearchUtil::coverAsBSON(cover, _nearQuery.field,
-                _params.coarsestIndexedLevel);
-        frsObjBuilder.appendElements(inExpr);
 
-        _params.configureCoverer(&coverer);
-        // Cover the indexed geo components of the query.
-        for (size_t i = 0; i < _indexedGeoFields.size(); ++i) {
-            vector<S2CellId> cover;
-            coverer.GetCovering(_indexedGeoFields[i].getRegion(), &cover);
-            uassert(16761, "Couldn't generate index keys for geo field "
-                    + _indexedGeoFields[i].getField(),
-                    cover.size() > 0);
-            BSONObj fieldRange = S2SearchUtil::coverAsBSON(cover, _indexedGeoFields[i].getField(),
-                    _params.coarsestIndexedLevel);
-            frsObjBuilder.appendElements(fieldRange);
+        // Step 2: Drop the cells we've scanned already.  Every key under such a cell, and every
+        // key for a cell containing it, was looked at then.
+        vector<S2CellId> newCells;
+        for (size_t i = 0; i < cover.size(); ++i) {
+            if (_scannedCells.Contains(cover[i])) {
+                ++_stats._cellSkip;
+            } else {
+                newCells.push_back(cover[i]);
+            }
         }
+        LOG(2) << "annulus cover size is " << cover.size() << ", " << newCells.size()
+            << " not yet scanned, params (" << coverer.min_level() << ", "
+            << coverer.max_level() << ")" << endl;
+        if (newCells.empty()) { return BSONObj(); }
+
+        vector<S2CellId> scanned(_scannedCells.cell_ids());
+        scanned.insert(scanned.end(), newCells.begin(), newCells.end());
+        _scannedCells.Init(scanned);
+
+        BSONObjBuilder frsObjBuilder;
+        frsObjBuilder.appendElements(_filteredQuery);
+        frsObjBuilder.appendElements(S2SearchUtil::coverAsBSON(newCells, _nearQuery.field,
+                _params.coarsestIndexedLevel));
+
+        // The indexed geo components of the query were covered by seek().
+        frsObjBuilder.appendElements(_indexedGeoRanges);
 
         return frsObjBuilder.obj();
     }
 
-    // Fill _results with all of the results in the annulus defined by _innerRadius and
-    // _outerRadius.  If no results are found, grow the annulus and repeat until success (or
-    // until the edge of the world).
+    // Grow the annulus until the closest result we have is closer than its outer edge, and so
+    // closer than anything we have yet to scan (or until the edge of the world).
     void S2NearIndexCursor::fillResults() {
-        verify(_results.empty());
+        while (_results.empty() || _results.top().distance >= _outerRadius) {
+            if (_outerRadius >= _maxDistance) {
+                // We've searched everywhere, anything we have is in order.
+                break;
+            }
+            nextAnnulus();
+            scanAnnulus();
+        }
+    }
+
+    // Look at the documents with keys in the cells of the current annulus we haven't scanned yet,
+    // and add those we haven't examined yet to _results, whatever their distance.
+    void S2NearIndexCursor::scanAnnulus() {
         if (_innerRadius >= _outerRadius) { return; }
-        if (_innerRadius > _maxDistance) { return; }
 
-        // We iterate until 1. our search radius is too big or 2. we find results.
-        do {
+        LOG(1) << "looking at annulus from " << _innerRadius << " to " << _outerRadius << endl;
+        LOG(1) << "Total # returned: " << _stats._numReturned << endl;
+
+        size_t found = 0;
+        BSONObj frsObj = makeFRSObject();
+        if (!frsObj.isEmpty()) {
             // Some of these arguments are opaque, look at the definitions of the involved classes.
-            FieldRangeSet frs(_descriptor->parentNS().c_str(), makeFRSObject(), false, false);
+            FieldRangeSet frs(_descriptor->parentNS().c_str(), frsObj, false, false);
             shared_ptr<FieldRangeVector> frv(new FieldRangeVector(frs, _specForFRV, 1));
             scoped_ptr<BtreeCursor> cursor(BtreeCursor::make(nsdetails(_descriptor->parentNS()),
                         _descriptor->getOnDisk(), frv, 0, 1));
 
-            // The cursor may return the same obj more than once for a given
-            // FRS, so we make sure to only consider it once in any given annulus.
-            //
-            // We don't want this outside of the 'do' loop because the covering
-            // for an annulus may return an object whose distance to the query
-            // point is actually contained in a subsequent annulus.  If we
-            // didn't consider every object in a given annulus we might miss
-            // the point.
-            //
-            // We don't use a global 'seen' because we get that by requiring
-            // the distance from the query point to the indexed geo to be
-            // within our 'current' annulus, and I want to dodge all yield
-            // issues if possible.
-            unordered_set<DiskLoc, DiskLoc::Hasher> seen;
-
-            LOG(1) << "looking at annulus from " << _innerRadius << " to " << _outerRadius << endl;
-            LOG(1) << "Total # returned: " << _stats._numReturned << endl;
-            // Do the actual search through this annulus.
             for (; cursor->ok(); cursor->advance()) {
                 // Don't bother to look at anything we've returned.
                 if (_returned.end() != _returned.find(cursor->currLoc())) {
@@ -235,13 +254,15 @@ namespace mongo {
                 }
 
                 ++_stats._nscanned;
-                if (seen.end() != seen.find(cursor->currLoc())) {
+                // We look at a document once, whatever annulus it was found in, until we yield.
+                // It may have several keys, or keys found again under a coarser cell.
+                if (_examined.end() != _examined.find(cursor->currLoc())) {
                     ++_stats._btreeDups;
                     continue;
                 }
 
-                // Get distance interval from our query point to the cell.
-                // If it doesn't overlap with our current shell, toss.
+                // The cells we've scanned may hold keys beyond this annulus, which we'll skip
+                // when their annulus comes.  So we keep whatever is within our search area.
                 BSONObj currKey(cursor->currKey());
                 BSONObjIterator it(currKey);
                 BSONElement geoKey;
@@ -250,18 +271,16 @@ namespace mongo {
                 }
 
                 S2Cell keyCell = S2Cell(S2CellId::FromString(geoKey.String()));
-                if (!_annulus.MayIntersect(keyCell)) {
+                if (!_searchCap.MayIntersect(keyCell)) {
                     ++_stats._keyGeoSkip;
                     continue;
                 }
 
-                // We have to add this document to seen *AFTER* the key intersection test.
-                // A geometry may have several keys, one of which may be in our search shell and one
-                // of which may be outside of it.  We don't want to ignore a document just because
-                // one of its covers isn't inside this annulus.
-                seen.insert(cursor->currLoc());
-
-                // At this point forward, we will not examine the document again in this annulus.
+                // We have to add this document to _examined *AFTER* the key intersection test.
+                // A geometry may have several keys, one of which may be in our search area and
+                // one of which may be outside of it.  We don't want to ignore a document just
+                // because one of its covers isn't inside the search area.
+                _examined.insert(cursor->currLoc());
 
                 const BSONObj& indexedObj = cursor->currLoc().obj();
 
@@ -314,29 +333,21 @@ namespace mongo {
                 // This would return points out of order.
                 if (minDistance < _returnedDistance) { continue; }
 
-                // If the min. distance satisfies our distance criteria
-                if (minDistance >= _innerRadius && minDistance < _outerRadius) {
-                    // The result is valid.  We have to de-dup ourselves here.
-                    if (_returned.end() == _returned.find(cursor->currLoc())) {
-                        _results.push(Result(cursor->currLoc(), cursor->currKey(),
-                                    minDistance));
-                    }
+                if (minDistance < _maxDistance) {
+                    _results.push(Result(cursor->currLoc(), cursor->currKey(), minDistance));
+                    ++found;
                 }
             }
+        }
 
-            if (_results.empty()) {
-                LOG(1) << "results empty!\n";
-                _radiusIncrement *= 2;
-                nextAnnulus();
-            } else if (_results.size() < 300) {
-                _radiusIncrement *= 2;
-            } else if (_results.size() > 600) {
-                _radiusIncrement /= 2;
-            }
-        } while (_results.empty()
-                && _innerRadius < _maxDistance
-                && _innerRadius < _outerRadius);
-        LOG(1) << "Filled shell with " << _results.size() << " results" << endl;
+        // Aim for a few hundred documents per annulus.
+        if (found < 300) {
+            _radiusIncrement *= 2;
+        } else if (found > 600) {
+            _radiusIncrement /= 2;
+        }
+        LOG(1) << "Found " << found << " results in annulus, " << _results.size()
+            << " waiting" << endl;
     }
 
     // Grow _innerRadius and _outerRadius by _radiusIncrement, capping _outerRadius at halfway
@@ -27,6 +27,7 @@
 #include "mongo/db/pdfile.h"
 #include "mongo/platform/unordered_set.h"
 #include "third_party/s2/s2cap.h"
+#include "third_party/s2/s2cellunion.h"
 #include "third_party/s2/s2regionintersection.h"
 
 namespace mongo {
@@ -78,17 +79,25 @@ namespace mongo {
         };
 
         /**
-         * Make the object that describes all keys that are within our current search annulus.
+         * Make the object that describes the keys within our current search annulus that are not
+         * under the cells we've already scanned, and note the annulus's new cells as scanned.
+         * Returns an empty object if there are no such keys.
          */
         BSONObj makeFRSObject();
 
         /**
-         * Fill _results with all of the results in the annulus defined by _innerRadius and
-         * _outerRadius.  If no results are found, grow the annulus and repeat until success (or
-         * until the edge of the world).
+         * Grow the annulus and scan it until the closest result in _results is closer than the
+         * annulus's outer edge, so that nothing we have yet to scan can be closer.
          */
         void fillResults();
 
+        /**
+         * Add the documents in the current annulus's unscanned cells that we haven't examined
+         * to _results, whatever their distance.  Documents beyond the annulus are kept for when
+         * the search reaches them, as the cells they were found in won't be scanned again.
+         */
+        void scanAnnulus();
+
         /**
          * Grow _innerRadius and _outerRadius by _radiusIncrement, capping _outerRadius at halfway
          * around the world (pi * _params.radius).
@@ -112,6 +121,8 @@ namespace mongo {
 
         // What geo regions are we looking for?
         vector<GeoQuery> _indexedGeoFields;
+        // And the FRS expression for the keys they may intersect.
+        BSONObj _indexedGeoRanges;
 
         // How were the keys created?  We need this to search for the right stuff.
         S2IndexingParams _params;
@@ -123,9 +134,19 @@ namespace mongo {
         // What's the max distance (arc length) we're willing to look for results?
         double _maxDistance;
 
-        // We compute an annulus of results and cache it here.
+        // The documents we've examined and not returned, closest first.  Only those closer than
+        // _outerRadius are known to be in order.
         priority_queue<Result> _results;
 
+        // What have we examined since the last yield?
+        unordered_set<DiskLoc, DiskLoc::Hasher> _examined;
+
+        // The cells whose keys we've scanned since the last yield.
+        S2CellUnion _scannedCells;
+
+        // Everything within _maxDistance of the query point.
+        S2Cap _searchCap;
+
         // These radii define the annulus we're currently looking at.
         double _innerRadius;
         double _outerRadius;
@@ -140,7 +161,7 @@ namespace mongo {
 
         struct Stats {
             Stats() : _nscanned(0), _matchTested(0), _geoMatchTested(0), _numShells(0),
-                      _keyGeoSkip(0), _returnSkip(0), _btreeDups(0), _inAnnulusTested(0),
+                      _keyGeoSkip(0), _cellSkip(0), _returnSkip(0), _btreeDups(0), _inAnnulusTested(0),
                       _numReturned(0) {}
             // Stat counters/debug information goes below.
             // How many items did we look at in the btree?
@@ -153,6 +174,8 @@ namespace mongo {
             long long _numShells;
             // How many did we skip due to key-geo check?
             long long _keyGeoSkip;
+            // How many cells in annulus coverings had already been scanned?
+            long long _cellSkip;
             long long _returnSkip;
             long long _btreeDups;
             long long _inAnnulusTested;
@@ -19,6 +19,7 @@
 #include "mongo/db/btreecursor.h"
 #include "mongo/db/index/index_cursor.h"
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index/s2_covering_cache.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/queryutil.h"
 #include "third_party/s2/s2regionintersection.h"
@@ -64,14 +65,14 @@ namespace mongo {
         S2RegionCoverer coverer;
 
         for (size_t i = 0; i < _fields.size(); ++i) {
-            vector<S2CellId> cover;
             double area = _fields[i].getRegion().GetRectBound().Area();
             S2SearchUtil::setCoverLimitsBasedOnArea(area, &coverer, _params.coarsestIndexedLevel);
-            coverer.GetCovering(_fields[i].getRegion(), &cover);
-            uassert(16759, "No cover ARGH?!", cover.size() > 0);
-            _cellsInCover = cover.size();
-            BSONObj fieldRange = S2SearchUtil::coverAsBSON(cover, _fields[i].getField(),
-                    _params.coarsestIndexedLevel);
+            size_t cellsInCover;
+            BSONObj fieldRange = S2CoveringCache::get().coverAsBSON(_fields[i].getRegion(),
+                    _fields[i].getGeometry(), _fields[i].getField(), &coverer,
+                    _params.coarsestIndexedLevel, &cellsInCover);
+            uassert(16759, "No cover ARGH?!", !fieldRange.isEmpty());
+            _cellsInCover = cellsInCover;
             frsObjBuilder.appendElements(fieldRange);
         }
 
@@ -36,10 +36,12 @@
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/db.h"
+#include "mongo/db/databaseholder.h"
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/dur_commitjob.h"
 #include "mongo/db/dur_journal.h"
 #include "mongo/db/dur_recover.h"
+#include "mongo/db/index_names.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/introspect.h"
 #include "mongo/db/json.h"
@@ -529,6 +531,46 @@ namespace mongo {
         delete database; // closes files
     }
 
+    /** @return true if a write to ns touches nothing outside of the collection's own records,
+        btree indexes and (via Database::allocExtent) new extents, so that a
+        Lock::CollectionWrite is sufficient.  must be called with that lock held.
+    */
+    static bool collectionLockSufficient(const char *ns) {
+        if ( NamespaceString(ns).isSystem() || NamespaceString::special(ns) )
+            return false;
+
+        // the database must already be open: opening it changes the db holder
+        Database *db = dbHolder().get(ns, dbpath);
+        if ( !db )
+            return false;
+
+        // a missing collection is implicitly created, which changes the namespace index
+        NamespaceDetails *d = db->namespaceIndex.details(ns);
+        if ( !d || d->isCapped() || d->indexBuildsInProgress )
+            return false;
+
+        // plugin indexes (geo, text, kdtree) may keep state outside of the collection
+        NamespaceDetails::IndexIterator i = d->ii();
+        while ( i.more() ) {
+            const string plugin = IndexNames::findPluginName(i.next().keyPattern());
+            if ( !plugin.empty() && plugin != IndexNames::HASHED )
+                return false;
+        }
+        return true;
+    }
+
+    Lock::ScopedLock* lockForWrite(const char *ns) {
+        if ( Lock::collectionLevelLockingEnabled() && NamespaceString::normal(ns) ) {
+            StringData db = nsToDatabaseSubstring(ns);
+            if ( db != "local" && db != "admin" ) {
+                auto_ptr<Lock::CollectionWrite> lk( new Lock::CollectionWrite(ns) );
+                if ( collectionLockSufficient(ns) )
+                    return lk.release();
+            }
+        }
+        return new Lock::DBWrite(ns);
+    }
+
     void receivedUpdate(Message& m, CurOp& op) {
         DbMessage d(m);
         const char *ns = d.getns();
@@ -555,7 +597,7 @@ namespace mongo {
         PageFaultRetryableSection s;
         while ( 1 ) {
             try {
-                Lock::DBWrite lk(ns);
+                scoped_ptr<Lock::ScopedLock> lk( lockForWrite(ns) );
                 
                 // void ReplSetImpl::relinquish() uses big write lock so 
                 // this is thus synchronized given our lock above.
@@ -597,7 +639,7 @@ namespace mongo {
         PageFaultRetryableSection s;
         while ( 1 ) {
             try {
-                Lock::DBWrite lk(ns);
+                scoped_ptr<Lock::ScopedLock> lk( lockForWrite(ns) );
                 
                 // writelock is used to synchronize stepdowns w/ writes
                 uassert( 10056 ,  "not master", isMasterNs( ns ) );
@@ -836,7 +878,7 @@ namespace mongo {
         PageFaultRetryableSection s;
         while ( true ) {
             try {
-                Lock::DBWrite lk(ns);
+                scoped_ptr<Lock::ScopedLock> lk( lockForWrite(ns) );
                 
                 // CONCURRENCY TODO: is being read locked in big log sufficient here?
                 // writelock is used to synchronize stepdowns w/ writes
@@ -70,6 +70,12 @@ namespace mongo {
 
     void assembleResponse( Message &m, DbResponse &dbresponse, const HostAndPort &client );
 
+    /** @return a Lock::CollectionWrite on ns if the write touches nothing outside of the
+        collection (see collectionLockSufficient() in instance.cpp), otherwise a Lock::DBWrite on
+        its database.  The caller owns the lock.
+    */
+    Lock::ScopedLock* lockForWrite( const char *ns );
+
     void getDatabaseNames( vector< string > &names , const string& usePath = dbpath );
 
     /* returns true if there is no data on this server.  useful when starting replication.
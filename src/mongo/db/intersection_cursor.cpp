@@ -0,0 +1,350 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/db/intersection_cursor.h"
+
+#include <set>
+
+#include "mongo/db/pdfile.h"
+
+namespace mongo {
+
+    IntersectionCursor* IntersectionCursor::make( const vector<shared_ptr<Cursor> >& cursors,
+                                                  bool sortedByLoc,
+                                                  const shared_ptr<Cursor>& firstIndexCursor,
+                                                  size_t maxHashedLocs ) {
+        auto_ptr<IntersectionCursor> ret( new IntersectionCursor( cursors, sortedByLoc,
+                                                                  firstIndexCursor,
+                                                                  maxHashedLocs ) );
+        ret->init();
+        return ret.release();
+    }
+
+    IntersectionCursor::IntersectionCursor( const vector<shared_ptr<Cursor> >& cursors,
+                                            bool sortedByLoc,
+                                            const shared_ptr<Cursor>& firstIndexCursor,
+                                            size_t maxHashedLocs ) :
+        _cursors( cursors ),
+        _sortedByLoc( sortedByLoc ),
+        _allBits(),
+        _exhaustedBits(),
+        _waiting(),
+        _nextCursor(),
+        _firstIndexCursor( firstIndexCursor ),
+        _maxHashedLocs( maxHashedLocs ),
+        _fallingBack() {
+        verify( _cursors.size() > 1 );
+        verify( _sortedByLoc || _firstIndexCursor );
+        verify( _cursors.size() <= sizeof( unsigned ) * 8 );
+        for( size_t i = 0; i < _cursors.size(); ++i ) {
+            _allBits |= 1U << i;
+        }
+    }
+
+    void IntersectionCursor::init() {
+        if ( _sortedByLoc ) {
+            mergeToNextMatch();
+            return;
+        }
+        for( size_t i = 0; i < _cursors.size(); ++i ) {
+            if ( !_cursors[ i ]->ok() ) {
+                noteExhausted( 1U << i );
+            }
+        }
+        hashToNextMatch();
+    }
+
+    bool IntersectionCursor::advance() {
+        if ( !ok() ) {
+            return false;
+        }
+        if ( _sortedByLoc ) {
+            // All the cursors are at _curr.
+            for( vector<shared_ptr<Cursor> >::const_iterator i = _cursors.begin();
+                 i != _cursors.end(); ++i ) {
+                (*i)->advance();
+            }
+            mergeToNextMatch();
+        }
+        else if ( _fallingBack ) {
+            fallbackToNextMatch();
+        }
+        else {
+            hashToNextMatch();
+        }
+        return ok();
+    }
+
+    void IntersectionCursor::mergeToNextMatch() {
+        _curr = DiskLoc();
+        while( 1 ) {
+            DiskLoc last;
+            for( vector<shared_ptr<Cursor> >::const_iterator i = _cursors.begin();
+                 i != _cursors.end(); ++i ) {
+                if ( !(*i)->ok() ) {
+                    return;
+                }
+                if ( last.isNull() || last < (*i)->currLoc() ) {
+                    last = (*i)->currLoc();
+                }
+            }
+
+            bool aligned = true;
+            for( vector<shared_ptr<Cursor> >::const_iterator i = _cursors.begin();
+                 i != _cursors.end(); ++i ) {
+                Cursor& c = **i;
+                while( c.currLoc() < last ) {
+                    if ( !c.advance() ) {
+                        return;
+                    }
+                }
+                if ( last < c.currLoc() ) {
+                    aligned = false;
+                }
+            }
+
+            if ( aligned ) {
+                _curr = last;
+                return;
+            }
+        }
+    }
+
+    void IntersectionCursor::hashToNextMatch() {
+        _curr = DiskLoc();
+        // Until some cursor is exhausted any location may yet be seen by all of them.
+        while( _waiting > 0 || _exhaustedBits == 0 ) {
+            size_t i = _nextCursor;
+            while( _exhaustedBits & ( 1U << i ) ) {
+                i = ( i + 1 ) % _cursors.size();
+            }
+            _nextCursor = ( i + 1 ) % _cursors.size();
+
+            const unsigned bit = 1U << i;
+            Cursor& c = *_cursors[ i ];
+            if ( !c.ok() ) {
+                // Keys may have been removed during a yield.
+                noteExhausted( bit );
+                continue;
+            }
+
+            DiskLoc loc = c.currLoc();
+            if ( !_exhaustedBits && _seen.size() >= _maxHashedLocs && !_seen.count( loc ) ) {
+                // Too many locations to remember.  The first index's documents include all the
+                // rest of the matches, so return those instead of failing the query.
+                startFallback();
+                fallbackToNextMatch();
+                return;
+            }
+            bool found = seenBy( bit, loc );
+            if ( !c.advance() ) {
+                noteExhausted( bit );
+            }
+            if ( found ) {
+                _curr = loc;
+                return;
+            }
+        }
+    }
+
+    bool IntersectionCursor::seenBy( unsigned cursorBit, const DiskLoc& loc ) {
+        LocMap::iterator i = _seen.find( loc );
+        if ( i == _seen.end() ) {
+            if ( _exhaustedBits ) {
+                // An exhausted cursor didn't see it.
+                return false;
+            }
+            _seen[ loc ] = cursorBit;
+            ++_waiting;
+            return false;
+        }
+
+        unsigned& bits = i->second;
+        if ( bits & cursorBit ) {
+            // Seen before in a multikey index, or already returned.
+            return false;
+        }
+        bits |= cursorBit;
+        if ( bits != _allBits ) {
+            return false;
+        }
+        // Only live cursors are scanned, so the location had all the exhausted cursors' bits and
+        // was waiting.
+        --_waiting;
+        return true;
+    }
+
+    void IntersectionCursor::noteExhausted( unsigned cursorBit ) {
+        _exhaustedBits |= cursorBit;
+        _waiting = 0;
+        for( LocMap::const_iterator i = _seen.begin(); i != _seen.end(); ++i ) {
+            if ( ( i->second & _exhaustedBits ) == _exhaustedBits && i->second != _allBits ) {
+                ++_waiting;
+            }
+        }
+    }
+
+    void IntersectionCursor::startFallback() {
+        LOG( 1 ) << "intersecting more than " << _maxHashedLocs << " locations, scanning "
+                 << _firstIndexCursor->toString() << " instead" << endl;
+        _fallingBack = true;
+        for( LocMap::iterator i = _seen.begin(); i != _seen.end(); ) {
+            if ( i->second == _allBits ) {
+                ++i;
+            }
+            else {
+                _seen.erase( i++ );
+            }
+        }
+    }
+
+    void IntersectionCursor::fallbackToNextMatch() {
+        _curr = DiskLoc();
+        Cursor& c = *_firstIndexCursor;
+        for( ; c.ok(); c.advance() ) {
+            DiskLoc loc = c.currLoc();
+            if ( _seen.count( loc ) ) {
+                // Already returned, by the intersection or from a multikey index.
+                continue;
+            }
+            if ( c.isMultiKey() ) {
+                _seen[ loc ] = _allBits;
+            }
+            _curr = loc;
+            c.advance();
+            return;
+        }
+    }
+
+    void IntersectionCursor::aboutToDeleteBucket( const DiskLoc& b ) {
+        for( vector<shared_ptr<Cursor> >::const_iterator i = _cursors.begin();
+             i != _cursors.end(); ++i ) {
+            (*i)->aboutToDeleteBucket( b );
+        }
+        if ( _firstIndexCursor ) {
+            _firstIndexCursor->aboutToDeleteBucket( b );
+        }
+    }
+
+    void IntersectionCursor::noteLocation() {
+        for( vector<shared_ptr<Cursor> >::const_iterator i = _cursors.begin();
+             i != _cursors.end(); ++i ) {
+            (*i)->noteLocation();
+        }
+        if ( _firstIndexCursor ) {
+            _firstIndexCursor->noteLocation();
+        }
+    }
+
+    void IntersectionCursor::checkLocation() {
+        for( vector<shared_ptr<Cursor> >::const_iterator i = _cursors.begin();
+             i != _cursors.end(); ++i ) {
+            (*i)->checkLocation();
+        }
+        if ( _firstIndexCursor ) {
+            _firstIndexCursor->checkLocation();
+        }
+        if ( _sortedByLoc && ok() ) {
+            // A cursor may have moved off a removed key.
+            mergeToNextMatch();
+        }
+    }
+
+    void IntersectionCursor::prepareToTouchEarlierIterate() {
+        for( vector<shared_ptr<Cursor> >::const_iterator i = _cursors.begin();
+             i != _cursors.end(); ++i ) {
+            (*i)->prepareToTouchEarlierIterate();
+        }
+        if ( _firstIndexCursor ) {
+            _firstIndexCursor->prepareToTouchEarlierIterate();
+        }
+    }
+
+    void IntersectionCursor::recoverFromTouchingEarlierIterate() {
+        for( vector<shared_ptr<Cursor> >::const_iterator i = _cursors.begin();
+             i != _cursors.end(); ++i ) {
+            (*i)->recoverFromTouchingEarlierIterate();
+        }
+        if ( _firstIndexCursor ) {
+            _firstIndexCursor->recoverFromTouchingEarlierIterate();
+        }
+        if ( _sortedByLoc && ok() ) {
+            mergeToNextMatch();
+        }
+    }
+
+    void IntersectionCursor::prepareToYield() {
+        for( vector<shared_ptr<Cursor> >::const_iterator i = _cursors.begin();
+             i != _cursors.end(); ++i ) {
+            (*i)->prepareToYield();
+        }
+        if ( _firstIndexCursor ) {
+            _firstIndexCursor->prepareToYield();
+        }
+    }
+
+    void IntersectionCursor::recoverFromYield() {
+        for( vector<shared_ptr<Cursor> >::const_iterator i = _cursors.begin();
+             i != _cursors.end(); ++i ) {
+            (*i)->recoverFromYield();
+        }
+        if ( _firstIndexCursor ) {
+            _firstIndexCursor->recoverFromYield();
+        }
+        if ( _sortedByLoc && ok() ) {
+            mergeToNextMatch();
+        }
+    }
+
+    string IntersectionCursor::toString() {
+        StringBuilder buf;
+        buf << "IntersectionCursor ";
+        for( vector<shared_ptr<Cursor> >::const_iterator i = _cursors.begin();
+             i != _cursors.end(); ++i ) {
+            if ( i != _cursors.begin() ) {
+                buf << ", ";
+            }
+            buf << (*i)->toString();
+        }
+        return buf.str();
+    }
+
+    BSONObj IntersectionCursor::prettyIndexBounds() const {
+        BSONObjBuilder b;
+        std::set<string> fields;
+        for( vector<shared_ptr<Cursor> >::const_iterator i = _cursors.begin();
+             i != _cursors.end(); ++i ) {
+            BSONObjIterator bounds( (*i)->prettyIndexBounds() );
+            while( bounds.more() ) {
+                BSONElement e = bounds.next();
+                if ( fields.insert( e.fieldName() ).second ) {
+                    b.append( e );
+                }
+            }
+        }
+        return b.obj();
+    }
+
+    long long IntersectionCursor::nscanned() {
+        long long ret = 0;
+        for( vector<shared_ptr<Cursor> >::const_iterator i = _cursors.begin();
+             i != _cursors.end(); ++i ) {
+            ret += (*i)->nscanned();
+        }
+        return ret;
+    }
+
+} // namespace mongo
@@ -0,0 +1,166 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/cursor.h"
+#include "mongo/platform/unordered_map.h"
+
+namespace mongo {
+
+    /**
+     * A cursor over the documents found by every one of a set of index cursors, for queries that
+     * constrain several separately indexed fields.  The index keys are scanned and their
+     * locations intersected before any document is loaded.
+     *
+     * When every cursor scans a single point of its index, its locations come back in
+     * ascending DiskLoc order and the cursors are merged by advancing whichever is behind.
+     * Otherwise the cursors are advanced in turn, counting the cursors each location was seen
+     * in, and a location is returned when the last of them finds it.  Once a cursor is
+     * exhausted no location it hasn't seen can be returned, so only the locations waiting on
+     * the remaining cursors are looked for.  If more than maxHashedLocs locations would have to
+     * be remembered, the hashed intersection gives up and returns the rest of the documents
+     * found by a separate cursor over the first index, which must be matched like any others.
+     *
+     * Each cursor must return every document its own index bounds may match; the documents
+     * returned are a superset of the query's matches and must be matched against the query.
+     * There is no index key for a document found by several indexes, so indexKeyPattern() and
+     * currKey() are empty and a covered projection is never used.  Documents are returned in no
+     * particular order, each once.
+     */
+    class IntersectionCursor : public Cursor {
+    public:
+
+        /**
+         * @return a cursor returning the documents found by all of 'cursors'.
+         * @param cursors - At least two index cursors, positioned at their first keys.
+         * @param sortedByLoc - If true, every cursor returns each of its documents once and in
+         *     ascending DiskLoc order.
+         * @param firstIndexCursor - Unless sortedByLoc, another cursor like cursors[ 0 ], at its
+         *     first key, to fall back to when there are too many locations to intersect.
+         * @param maxHashedLocs - The most locations the hashed intersection will remember.
+         */
+        static IntersectionCursor* make( const std::vector<shared_ptr<Cursor> >& cursors,
+                                         bool sortedByLoc,
+                                         const shared_ptr<Cursor>& firstIndexCursor =
+                                                 shared_ptr<Cursor>(),
+                                         size_t maxHashedLocs = MaxHashedLocs );
+
+        /** Virtuals from Cursor. */
+
+        virtual bool ok() { return !_curr.isNull(); }
+
+        virtual Record* _current() { verify( ok() ); return _curr.rec(); }
+
+        virtual BSONObj current() { return BSONObj::make( _current() ); }
+
+        virtual DiskLoc currLoc() { return _curr; }
+
+        virtual bool advance();
+
+        virtual DiskLoc refLoc() { return _curr; }
+
+        virtual void aboutToDeleteBucket( const DiskLoc& b );
+
+        virtual bool supportGetMore() { return true; }
+
+        virtual void noteLocation();
+
+        virtual void checkLocation();
+
+        virtual void prepareToTouchEarlierIterate();
+
+        virtual void recoverFromTouchingEarlierIterate();
+
+        virtual bool supportYields() { return true; }
+
+        virtual void prepareToYield();
+
+        virtual void recoverFromYield();
+
+        virtual string toString();
+
+        /** Each document is returned once, whether or not the indexes are multikey. */
+        virtual bool getsetdup( DiskLoc loc ) { return false; }
+
+        virtual bool isMultiKey() const { return false; }
+
+        virtual bool modifiedKeys() const { return false; }
+
+        virtual BSONObj prettyIndexBounds() const;
+
+        virtual long long nscanned();
+
+        virtual CoveredIndexMatcher* matcher() const { return _matcher.get(); }
+
+        virtual void setMatcher( shared_ptr<CoveredIndexMatcher> matcher ) { _matcher = matcher; }
+
+        virtual const Projection::KeyOnly* keyFieldsOnly() const { return _keyFieldsOnly.get(); }
+
+        virtual void setKeyFieldsOnly( const shared_ptr<Projection::KeyOnly>& keyFieldsOnly ) {
+            _keyFieldsOnly = keyFieldsOnly;
+        }
+
+        /** The most locations the hashed intersection remembers by default. */
+        static const size_t MaxHashedLocs = 1024 * 1024;
+
+    private:
+        IntersectionCursor( const std::vector<shared_ptr<Cursor> >& cursors, bool sortedByLoc,
+                            const shared_ptr<Cursor>& firstIndexCursor, size_t maxHashedLocs );
+
+        void init();
+
+        /** Position at the next location all the cursors are at, if any. */
+        void mergeToNextMatch();
+
+        /** Scan keys until a location has been seen by all the cursors, if any will be. */
+        void hashToNextMatch();
+
+        /** @return true if location 'loc' was just seen by the last of the cursors. */
+        bool seenBy( unsigned cursorBit, const DiskLoc& loc );
+
+        /** Stop remembering new locations, 'cursorBit' having run out of keys. */
+        void noteExhausted( unsigned cursorBit );
+
+        /** Give up intersecting, keeping only the locations already returned. */
+        void startFallback();
+
+        /** Position at the next location of the first index cursor not yet returned, if any. */
+        void fallbackToNextMatch();
+
+        typedef unordered_map<DiskLoc,unsigned,DiskLoc::Hasher> LocMap;
+
+        std::vector<shared_ptr<Cursor> > _cursors;
+        bool _sortedByLoc;
+        DiskLoc _curr;
+
+        // Hashed intersection state.
+        LocMap _seen; // The cursors each location has been seen in, as bits.
+        unsigned _allBits;
+        unsigned _exhaustedBits;
+        long long _waiting; // Locations in _seen that may still be seen by all the cursors.
+        size_t _nextCursor;
+        shared_ptr<Cursor> _firstIndexCursor;
+        size_t _maxHashedLocs;
+        bool _fallingBack; // Returning _firstIndexCursor's locations, not intersecting.
+
+        shared_ptr<CoveredIndexMatcher> _matcher;
+        shared_ptr<Projection::KeyOnly> _keyFieldsOnly;
+    };
+
+} // namespace mongo
@@ -0,0 +1,637 @@
+// key_string.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/db/key_string.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "mongo/platform/float_utils.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/hex.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    namespace {
+        // the first byte of each value, in canonical type order
+        const unsigned char kMinKey = 10;
+        const unsigned char kUndefined = 15;
+        const unsigned char kNull = 20;
+        const unsigned char kNumeric = 30;
+        const unsigned char kString = 40;
+        const unsigned char kObject = 50;
+        const unsigned char kArray = 60;
+        const unsigned char kBinData = 70;
+        const unsigned char kOID = 80;
+        const unsigned char kBool = 90;
+        const unsigned char kDate = 100;
+        const unsigned char kRegEx = 110;
+        const unsigned char kDBRef = 120;
+        const unsigned char kCode = 130;
+        const unsigned char kCodeWScope = 140;
+        const unsigned char kMaxKey = 240;
+
+        // after the last field of a key.  Never inverted, and below every type byte whether
+        // inverted or not, so a key that runs out first is less.
+        const unsigned char kEnd = 4;
+
+        // after the last element of an embedded object or array
+        const unsigned char kObjectEnd = 0;
+
+        // type bits for numbers
+        const int kDouble = 0;
+        const int kInt = 1;
+        const int kLong = 2;
+        const int kNegativeZero = 3;
+
+        // from here up not every long is a double, so a long's difference from the double it
+        // rounds to follows the double
+        const double kTwoTo53 = 9007199254740992.0;
+        const double kTwoTo63 = 9223372036854775808.0;
+
+        const unsigned long long kSignBit = 1ULL << 63;
+
+        unsigned char typeByte( BSONType type ) {
+            switch ( type ) {
+            case MinKey: return kMinKey;
+            case Undefined: return kUndefined;
+            case jstNULL: return kNull;
+            case NumberDouble:
+            case NumberInt:
+            case NumberLong: return kNumeric;
+            case String:
+            case Symbol: return kString;
+            case Object: return kObject;
+            case Array: return kArray;
+            case BinData: return kBinData;
+            case jstOID: return kOID;
+            case Bool: return kBool;
+            case Date:
+            case Timestamp: return kDate;
+            case RegEx: return kRegEx;
+            case DBRef: return kDBRef;
+            case Code: return kCode;
+            case CodeWScope: return kCodeWScope;
+            case MaxKey: return kMaxKey;
+            default:
+                msgasserted( 16843, mongoutils::str::stream() << "can't put type " << type
+                                                              << " in a KeyString" );
+            }
+            return 0;
+        }
+
+        /** @return d's bits, rearranged so that they order like the doubles as integers */
+        unsigned long long encodeDouble( double d ) {
+            unsigned long long bits;
+            memcpy( &bits, &d, sizeof( bits ) );
+            return ( bits & kSignBit ) ? ~bits : bits | kSignBit;
+        }
+
+        double decodeDouble( unsigned long long bits ) {
+            bits = ( bits & kSignBit ) ? bits & ~kSignBit : ~bits;
+            double d;
+            memcpy( &d, &bits, sizeof( d ) );
+            return d;
+        }
+
+        /** @return d, which a long rounded to, as a long: 2^63 wraps to the smallest long */
+        unsigned long long longBase( double d ) {
+            if ( d >= kTwoTo63 )
+                return kSignBit;
+            return static_cast<unsigned long long>( static_cast<long long>( d ) );
+        }
+
+        void appendHeader( BufBuilder& b, BSONType type, const StringData& name ) {
+            b.appendNum( static_cast<char>( type ) );
+            b.appendStr( name );
+        }
+
+        void appendStringValue( BufBuilder& b, const std::string& s ) {
+            b.appendNum( static_cast<int>( s.size() + 1 ) );
+            b.appendStr( s );
+        }
+
+        /** turns a KeyString back into BSON, reading the bytes in the order they were written */
+        class Decoder {
+        public:
+            explicit Decoder( const KeyString& ks )
+                : _pos( reinterpret_cast<const unsigned char*>( ks.getBuffer() ) ),
+                  _end( _pos + ks.getSize() ),
+                  _inverted( false ),
+                  _typeBits( ks.getTypeBits() ) {
+            }
+
+            BSONObj decodeKey( const Ordering& ord ) {
+                BSONObjBuilder builder;
+                BufBuilder& b = builder.bb();
+                unsigned mask = 1;
+                while ( true ) {
+                    massert( 16844, "KeyString ends early", _pos < _end );
+                    if ( *_pos == kEnd )
+                        break;
+                    _inverted = ord.descending( mask );
+                    decodeValue( b, readByte(), "" );
+                    mask <<= 1;
+                }
+                return builder.obj();
+            }
+
+        private:
+            unsigned char readByte() {
+                massert( 16845, "KeyString ends early", _pos < _end );
+                unsigned char c = *_pos++;
+                return _inverted ? ~c : c;
+            }
+
+            unsigned long long readBigEndian( int bytes ) {
+                unsigned long long value = 0;
+                for ( int i = 0; i < bytes; i++ )
+                    value = ( value << 8 ) | readByte();
+                return value;
+            }
+
+            void readBytes( BufBuilder& b, size_t n ) {
+                char* out = b.grow( n );
+                for ( size_t i = 0; i < n; i++ )
+                    out[i] = readByte();
+            }
+
+            /** appends the string with its terminating null */
+            void readCString( BufBuilder& b ) {
+                char c;
+                do {
+                    c = readByte();
+                    b.appendNum( c );
+                } while ( c );
+            }
+
+            std::string readEscaped() {
+                std::string s;
+                while ( true ) {
+                    unsigned char c = readByte();
+                    if ( c != 0 ) {
+                        s.push_back( c );
+                        continue;
+                    }
+                    if ( readByte() == 0 )
+                        return s;
+                    s.push_back( 0 );
+                }
+            }
+
+            void decodeValue( BufBuilder& b, unsigned char type, const StringData& name ) {
+                switch ( type ) {
+                case kMinKey:
+                    appendHeader( b, MinKey, name );
+                    break;
+                case kUndefined:
+                    appendHeader( b, Undefined, name );
+                    break;
+                case kNull:
+                    appendHeader( b, jstNULL, name );
+                    break;
+                case kNumeric:
+                    decodeNumber( b, name );
+                    break;
+                case kString: {
+                    BSONType t = _typeBits.readBit() ? Symbol : String;
+                    appendHeader( b, t, name );
+                    appendStringValue( b, readEscaped() );
+                    break;
+                }
+                case kObject:
+                    appendHeader( b, Object, name );
+                    decodeObject( b, false );
+                    break;
+                case kArray:
+                    appendHeader( b, Array, name );
+                    decodeObject( b, true );
+                    break;
+                case kBinData: {
+                    int len = readBigEndian( 4 );
+                    appendHeader( b, BinData, name );
+                    b.appendNum( len );
+                    b.appendNum( static_cast<char>( readByte() ) );
+                    readBytes( b, len );
+                    break;
+                }
+                case kOID:
+                    appendHeader( b, jstOID, name );
+                    readBytes( b, 12 );
+                    break;
+                case kBool:
+                    appendHeader( b, Bool, name );
+                    b.appendNum( static_cast<char>( readByte() ) );
+                    break;
+                case kDate:
+                    if ( _typeBits.readBit() ) {
+                        appendHeader( b, Timestamp, name );
+                        b.appendNum( readBigEndian( 8 ) );
+                    }
+                    else {
+                        appendHeader( b, Date, name );
+                        b.appendNum( readBigEndian( 8 ) ^ kSignBit );
+                    }
+                    break;
+                case kRegEx:
+                    appendHeader( b, RegEx, name );
+                    readCString( b );
+                    readCString( b );
+                    break;
+                case kDBRef: {
+                    int size = readBigEndian( 4 );
+                    appendHeader( b, DBRef, name );
+                    readBytes( b, size );
+                    break;
+                }
+                case kCode:
+                    appendHeader( b, Code, name );
+                    appendStringValue( b, readEscaped() );
+                    break;
+                case kCodeWScope: {
+                    std::string code = readEscaped();
+                    appendHeader( b, CodeWScope, name );
+                    const int start = b.len();
+                    b.appendNum( 0 ); // patched below
+                    appendStringValue( b, code );
+                    decodeObject( b, false );
+                    *reinterpret_cast<int*>( b.buf() + start ) = b.len() - start;
+                    break;
+                }
+                case kMaxKey:
+                    appendHeader( b, MaxKey, name );
+                    break;
+                default:
+                    msgasserted( 16846, mongoutils::str::stream() << "unknown type "
+                                                                  << int( type )
+                                                                  << " in KeyString" );
+                }
+            }
+
+            void decodeNumber( BufBuilder& b, const StringData& name ) {
+                int kind = _typeBits.readBit() ? 2 : 0;
+                kind |= _typeBits.readBit() ? 1 : 0;
+
+                unsigned long long bits = readBigEndian( 8 );
+                double d = bits == 0 ? std::numeric_limits<double>::quiet_NaN() :
+                                       decodeDouble( bits );
+                long long remainder = 0;
+                if ( std::fabs( d ) >= kTwoTo53 )
+                    remainder = static_cast<long long>( readBigEndian( 2 ) ) - 0x8000;
+
+                switch ( kind ) {
+                case kDouble:
+                    appendHeader( b, NumberDouble, name );
+                    b.appendNum( d );
+                    break;
+                case kNegativeZero:
+                    appendHeader( b, NumberDouble, name );
+                    b.appendNum( -0.0 );
+                    break;
+                case kInt:
+                    appendHeader( b, NumberInt, name );
+                    b.appendNum( static_cast<int>( d ) );
+                    break;
+                case kLong: {
+                    unsigned long long x = longBase( d ) + remainder;
+                    appendHeader( b, NumberLong, name );
+                    b.appendNum( static_cast<long long>( x ) );
+                    break;
+                }
+                }
+            }
+
+            void decodeObject( BufBuilder& b, bool isArray ) {
+                const int start = b.len();
+                b.appendNum( 0 ); // patched below
+                for ( int i = 0; ; i++ ) {
+                    unsigned char type = readByte();
+                    if ( type == kObjectEnd )
+                        break;
+                    if ( isArray ) {
+                        decodeValue( b, type, BSONObjBuilder::numStr( i ) );
+                    }
+                    else {
+                        BufBuilder name;
+                        readCString( name );
+                        decodeValue( b, type, name.buf() );
+                    }
+                }
+                b.appendNum( static_cast<char>( EOO ) );
+                *reinterpret_cast<int*>( b.buf() + start ) = b.len() - start;
+            }
+
+            const unsigned char* _pos;
+            const unsigned char* const _end;
+            bool _inverted;
+            KeyString::TypeBits::Reader _typeBits;
+        };
+    }
+
+    void KeyString::TypeBits::appendBit( bool bit ) {
+        if ( _count % 8 == 0 )
+            _bits.push_back( 0 );
+        if ( bit )
+            _bits[_count / 8] |= 1 << ( _count % 8 );
+        _count++;
+    }
+
+    bool KeyString::TypeBits::Reader::readBit() {
+        massert( 16847, "KeyString type bits end early", _pos < _bits._count );
+        bool bit = _bits._bits[_pos / 8] & ( 1 << ( _pos % 8 ) );
+        _pos++;
+        return bit;
+    }
+
+    void KeyString::resetFromKey( const BSONObj& key, const Ordering& ord ) {
+        _buffer.clear();
+        _typeBits.clear();
+
+        // like BSONObj::woCompare, fields past the ones the Ordering covers are ascending
+        unsigned mask = 1;
+        BSONObjIterator it( key );
+        while ( it.more() ) {
+            const size_t start = _buffer.size();
+            _appendElement( it.next(), false );
+            if ( ord.descending( mask ) )
+                _invert( start );
+            mask <<= 1;
+        }
+        _buffer.push_back( kEnd );
+    }
+
+    BSONObj KeyString::toBson( const Ordering& ord ) const {
+        Decoder decoder( *this );
+        return decoder.decodeKey( ord );
+    }
+
+    int KeyString::compare( const KeyString& other ) const {
+        const size_t common = std::min( _buffer.size(), other._buffer.size() );
+        int res = memcmp( _buffer.data(), other._buffer.data(), common );
+        if ( res )
+            return res;
+        if ( _buffer.size() == other._buffer.size() )
+            return 0;
+        return _buffer.size() < other._buffer.size() ? -1 : 1;
+    }
+
+    void KeyString::serializeForSorter( BufBuilder& buf ) const {
+        buf.appendNum( static_cast<int>( _buffer.size() ) );
+        buf.appendBuf( _buffer.data(), _buffer.size() );
+        buf.appendNum( static_cast<int>( _typeBits._count ) );
+        buf.appendBuf( _typeBits._bits.data(), _typeBits._bits.size() );
+    }
+
+    KeyString KeyString::deserializeForSorter( BufReader& buf,
+                                               const SorterDeserializeSettings& ) {
+        KeyString ks;
+        const int size = buf.read<int>();
+        ks._buffer.assign( static_cast<const char*>( buf.skip( size ) ), size );
+        ks._typeBits._count = buf.read<int>();
+        const unsigned bitBytes = ( ks._typeBits._count + 7 ) / 8;
+        ks._typeBits._bits.assign( static_cast<const char*>( buf.skip( bitBytes ) ), bitBytes );
+        return ks;
+    }
+
+    std::string KeyString::toString() const {
+        return toHex( _buffer.data(), _buffer.size() );
+    }
+
+    void KeyString::_appendElement( const BSONElement& elem, bool withName ) {
+        _buffer.push_back( typeByte( elem.type() ) );
+        if ( withName )
+            _buffer.append( elem.fieldName(), elem.fieldNameSize() );
+        _appendValue( elem );
+    }
+
+    void KeyString::_appendValue( const BSONElement& elem ) {
+        switch ( elem.type() ) {
+        case MinKey:
+        case MaxKey:
+        case Undefined:
+        case jstNULL:
+            break;
+
+        case NumberDouble:
+        case NumberInt:
+        case NumberLong:
+            _appendNumber( elem );
+            break;
+
+        case String:
+        case Symbol:
+            _typeBits.appendBit( elem.type() == Symbol );
+            _appendEscaped( elem.valuestr(), elem.valuestrsize() - 1 );
+            break;
+
+        case Code:
+            _appendEscaped( elem.valuestr(), elem.valuestrsize() - 1 );
+            break;
+
+        case Object:
+            _appendObject( elem.embeddedObject(), false );
+            break;
+
+        case Array:
+            _appendObject( elem.embeddedObject(), true );
+            break;
+
+        case BinData: {
+            // woCompare orders by length, then subtype, then the data
+            int len;
+            const char* data = elem.binData( len );
+            _appendBigEndian( len, 4 );
+            _buffer.push_back( elem.binDataType() );
+            _buffer.append( data, len );
+            break;
+        }
+
+        case jstOID:
+            _buffer.append( elem.value(), 12 );
+            break;
+
+        case Bool:
+            _buffer.push_back( elem.boolean() ? 1 : 0 );
+            break;
+
+        case Date:
+            _typeBits.appendBit( false );
+            _appendBigEndian( elem.date().millis ^ kSignBit, 8 );
+            break;
+
+        case Timestamp:
+            _typeBits.appendBit( true );
+            _appendBigEndian( elem.date().millis, 8 );
+            break;
+
+        case RegEx:
+            _buffer.append( elem.regex(), strlen( elem.regex() ) + 1 );
+            _buffer.append( elem.regexFlags(), strlen( elem.regexFlags() ) + 1 );
+            break;
+
+        case DBRef:
+            // woCompare orders by size, then the bytes
+            _appendBigEndian( elem.valuesize(), 4 );
+            _buffer.append( elem.value(), elem.valuesize() );
+            break;
+
+        case CodeWScope:
+            _appendEscaped( elem.codeWScopeCode(), elem.codeWScopeCodeLen() - 1 );
+            _appendObject( BSONObj( elem.codeWScopeScopeData() ), false );
+            break;
+
+        default:
+            typeByte( elem.type() ); // asserts
+        }
+    }
+
+    void KeyString::_appendObject( const BSONObj& obj, bool isArray ) {
+        // array elements are in order, their names go without saying
+        BSONObjIterator it( obj );
+        while ( it.more() )
+            _appendElement( it.next(), !isArray );
+        _buffer.push_back( kObjectEnd );
+    }
+
+    void KeyString::_appendNumber( const BSONElement& elem ) {
+        double d = elem.number();
+
+        int kind = kDouble;
+        if ( elem.type() == NumberInt )
+            kind = kInt;
+        else if ( elem.type() == NumberLong )
+            kind = kLong;
+        else if ( d == 0 && std::signbit( d ) )
+            kind = kNegativeZero;
+        _typeBits.appendBit( kind & 2 );
+        _typeBits.appendBit( kind & 1 );
+
+        if ( isNaN( d ) ) {
+            // below every other number, and below what encodeDouble() gives -infinity
+            _appendBigEndian( 0, 8 );
+            return;
+        }
+
+        if ( d == 0 ) {
+            // -0 == 0
+            d = 0;
+        }
+        _appendBigEndian( encodeDouble( d ), 8 );
+
+        if ( std::fabs( d ) >= kTwoTo53 ) {
+            // rounding a long to a double never reverses two numbers, so the difference only
+            // matters between those that round alike; it's within 512 either way
+            long long remainder = 0;
+            if ( kind == kLong ) {
+                remainder = static_cast<long long>(
+                    static_cast<unsigned long long>( elem._numberLong() ) - longBase( d ) );
+            }
+            _appendBigEndian( remainder + 0x8000, 2 );
+        }
+    }
+
+    void KeyString::_appendEscaped( const char* str, size_t len ) {
+        // a null is written as 0x00 0xff and the end as 0x00 0x00, so a string that is a prefix
+        // of another is less, as memcmp with the shorter string first would have it
+        const char* const end = str + len;
+        while ( str < end ) {
+            const char* zero = static_cast<const char*>( memchr( str, 0, end - str ) );
+            if ( !zero ) {
+                _buffer.append( str, end - str );
+                break;
+            }
+            _buffer.append( str, zero - str );
+            _buffer.push_back( 0 );
+            _buffer.push_back( static_cast<char>( 0xff ) );
+            str = zero + 1;
+        }
+        _buffer.push_back( 0 );
+        _buffer.push_back( 0 );
+    }
+
+    void KeyString::_appendBigEndian( unsigned long long value, int bytes ) {
+        for ( int shift = ( bytes - 1 ) * 8; shift >= 0; shift -= 8 )
+            _buffer.push_back( static_cast<char>( ( value >> shift ) & 0xff ) );
+    }
+
+    void KeyString::_invert( size_t from ) {
+        for ( size_t i = from; i < _buffer.size(); i++ )
+            _buffer[i] = ~_buffer[i];
+    }
+
+    unsigned long long KeyString::firstFieldPrefix( const BSONObj& key ) {
+        BSONElement e = key.firstElement();
+
+        // canonical types run from -1 (MinKey) to 127 (MaxKey) and are compared first
+        const unsigned long long type =
+            static_cast<unsigned long long>( e.canonicalType() + 1 ) << 56;
+        unsigned long long value = 0;
+
+        switch ( e.type() ) {
+        case NumberDouble:
+        case NumberInt:
+        case NumberLong: {
+            // numbers of different types compare as doubles, and rounding two longs to doubles
+            // can make them equal but never reverses them
+            double d = e.number();
+            if ( isNaN( d ) ) {
+                // NaN is less than all other numbers
+                value = 0;
+                break;
+            }
+            if ( d == 0 ) {
+                // -0 == 0
+                d = 0;
+            }
+            unsigned long long bits;
+            memcpy( &bits, &d, sizeof( bits ) );
+            // make the bits order like the doubles: negatives flipped below the positives
+            bits = ( bits >> 63 ) ? ~bits : bits | ( 1ULL << 63 );
+            value = bits >> 8;
+            break;
+        }
+        case String:
+        case Symbol: {
+            // strings compare with memcmp, shorter first on a tie
+            const unsigned char* s = reinterpret_cast<const unsigned char*>( e.valuestr() );
+            int len = e.valuestrsize() - 1;
+            for ( int i = 0; i < 7; i++ )
+                value = ( value << 8 ) | ( i < len ? s[i] : 0 );
+            break;
+        }
+        case jstOID: {
+            const unsigned char* oid = reinterpret_cast<const unsigned char*>( e.value() );
+            for ( int i = 0; i < 7; i++ )
+                value = ( value << 8 ) | oid[i];
+            break;
+        }
+        case Bool:
+            value = e.boolean() ? 1 : 0;
+            break;
+        default:
+            // compared in full.  this includes dates, which share a canonical type with
+            // timestamps but don't compare like them
+            break;
+        }
+
+        return type | value;
+    }
+
+}
@@ -0,0 +1,129 @@
+// key_string.h
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/util/bufreader.h"
+
+namespace mongo {
+
+    /**
+     * A key encoded as bytes that compare with memcmp the way the keys compare with
+     * BSONObj::woCompare( other, ordering, false ).
+     *
+     * Each field of the key is written as a byte for its canonical type followed by its value,
+     * laid out so that the bytes order like the values: numbers of all types share one
+     * encoding, strings are escaped and terminated, embedded objects and arrays are their
+     * elements in turn.  Fields that sort descending are written with every byte inverted.
+     *
+     * What comparisons can't see - whether a number was an int, a long or a double, a string
+     * or a symbol, and so on - is kept to the side in the TypeBits, so that toBson() gives
+     * back the key that was encoded (with empty field names, like an index key).
+     *
+     * The order is the same as woCompare's except where woCompare isn't a total order: a
+     * NumberLong beyond 2^53 is ordered exactly against a double it rounds to, Dates and
+     * Timestamps aren't compared to each other by value, and the scope of a CodeWScope is
+     * compared as an object.
+     */
+    class KeyString {
+    public:
+        /**
+         * The type information the comparable bytes leave out, a couple of bits per value
+         * that needs them.
+         */
+        class TypeBits {
+        public:
+            TypeBits() : _count( 0 ) {}
+
+            void appendBit( bool bit );
+            void clear() { _bits.clear(); _count = 0; }
+
+            unsigned count() const { return _count; }
+            const std::string& bytes() const { return _bits; }
+
+            class Reader {
+            public:
+                explicit Reader( const TypeBits& bits ) : _bits( bits ), _pos( 0 ) {}
+                bool readBit();
+            private:
+                const TypeBits& _bits;
+                unsigned _pos;
+            };
+
+        private:
+            friend class KeyString;
+            std::string _bits;
+            unsigned _count;
+        };
+
+        struct SorterDeserializeSettings {}; // unused
+
+        KeyString() {}
+
+        KeyString( const BSONObj& key, const Ordering& ord ) {
+            resetFromKey( key, ord );
+        }
+
+        void resetFromKey( const BSONObj& key, const Ordering& ord );
+
+        /** @return the key that was encoded.  ord must be the one it was encoded with. */
+        BSONObj toBson( const Ordering& ord ) const;
+
+        const char* getBuffer() const { return _buffer.data(); }
+        size_t getSize() const { return _buffer.size(); }
+        const TypeBits& getTypeBits() const { return _typeBits; }
+
+        int compare( const KeyString& other ) const;
+
+        bool operator<( const KeyString& other ) const { return compare( other ) < 0; }
+        bool operator==( const KeyString& other ) const { return compare( other ) == 0; }
+
+        // for the sorter, see sorter.h
+        void serializeForSorter( BufBuilder& buf ) const;
+        static KeyString deserializeForSorter( BufReader& buf, const SorterDeserializeSettings& );
+        int memUsageForSorter() const {
+            return sizeof( KeyString ) + _buffer.size() + _typeBits._bits.size();
+        }
+        KeyString getOwned() const { return *this; }
+
+        std::string toString() const;
+
+        /**
+         * @return an integer that orders like the first field of key: for keys with the same
+         * field names, firstFieldPrefix(a) < firstFieldPrefix(b) implies a.woCompare(b) < 0.
+         * Keys that differ may still share a prefix, so callers compare whole keys on a tie.
+         */
+        static unsigned long long firstFieldPrefix( const BSONObj& key );
+
+    private:
+        void _appendElement( const BSONElement& elem, bool withName );
+        void _appendValue( const BSONElement& elem );
+        void _appendObject( const BSONObj& obj, bool isArray );
+        void _appendNumber( const BSONElement& elem );
+        void _appendEscaped( const char* str, size_t len );
+        void _appendBigEndian( unsigned long long value, int bytes );
+        void _invert( size_t from );
+
+        std::string _buffer;
+        TypeBits _typeBits;
+    };
+
+}
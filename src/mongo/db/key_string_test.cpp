@@ -0,0 +1,215 @@
+// key_string_test.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/unittest/unittest.h"
+
+#include "mongo/db/key_string.h"
+
+#include <limits>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    namespace {
+        int sign( int x ) {
+            return x < 0 ? -1 : x > 0 ? 1 : 0;
+        }
+
+        /** one single field key of each kind, some of them alike */
+        std::vector<BSONObj> someValues() {
+            std::vector<BSONObj> values;
+            const double inf = std::numeric_limits<double>::infinity();
+            const OID oid( "512345678901234567890123" );
+
+            values.push_back( BSON( "" << MINKEY ) );
+            values.push_back( BSON( "" << MAXKEY ) );
+            values.push_back( BSON( "" << BSONNULL ) );
+            values.push_back( BSON( "" << BSONUndefined ) );
+            values.push_back( BSON( "" << 0.0 ) );
+            values.push_back( BSON( "" << -0.0 ) );
+            values.push_back( BSON( "" << 1.5 ) );
+            values.push_back( BSON( "" << -1.5 ) );
+            values.push_back( BSON( "" << 1e300 ) );
+            values.push_back( BSON( "" << inf ) );
+            values.push_back( BSON( "" << -inf ) );
+            values.push_back( BSON( "" << 3.0 ) );
+            values.push_back( BSON( "" << 0 ) );
+            values.push_back( BSON( "" << 3 ) );
+            values.push_back( BSON( "" << -1 ) );
+            values.push_back( BSON( "" << std::numeric_limits<int>::min() ) );
+            values.push_back( BSON( "" << 3LL ) );
+            values.push_back( BSON( "" << -5LL ) );
+            values.push_back( BSON( "" << ( 1LL << 62 ) ) );
+            values.push_back( BSON( "" << ( 1LL << 62 ) + 1 ) );
+            values.push_back( BSON( "" << std::numeric_limits<long long>::max() ) );
+            values.push_back( BSON( "" << std::numeric_limits<long long>::min() ) );
+            values.push_back( BSON( "" << "" ) );
+            values.push_back( BSON( "" << "a" ) );
+            values.push_back( BSON( "" << "ab" ) );
+            values.push_back( BSON( "" << string( "a\0b", 3 ) ) );
+            values.push_back( BSON( "" << string( "a\0", 2 ) ) );
+            values.push_back( BSON( "" << "a\x01" ) );
+            values.push_back( BSON( "" << "\xff" ) );
+            values.push_back( BSONObjBuilder().appendSymbol( "", "ab" ).obj() );
+            values.push_back( BSON( "" << BSONObj() ) );
+            values.push_back( BSON( "" << BSON( "a" << 1 ) ) );
+            values.push_back( BSON( "" << BSON( "a" << 1 << "b" << 2 ) ) );
+            values.push_back( BSON( "" << BSON( "a" << 2 ) ) );
+            values.push_back( BSON( "" << BSON( "ab" << 1 ) ) );
+            values.push_back( BSON( "" << BSON( "a" << "x" ) ) );
+            values.push_back( BSON( "" << BSONArray() ) );
+            values.push_back( BSON( "" << BSON_ARRAY( 1 ) ) );
+            values.push_back( BSON( "" << BSON_ARRAY( 1 << 2 ) ) );
+            values.push_back( BSON( "" << BSON_ARRAY( "x" << BSON( "y" << 1 ) ) ) );
+            values.push_back( BSONObjBuilder().appendBinData( "", 3, BinDataGeneral,
+                                                              "abc" ).obj() );
+            values.push_back( BSONObjBuilder().appendBinData( "", 2, BinDataGeneral,
+                                                              "zz" ).obj() );
+            values.push_back( BSONObjBuilder().appendBinData( "", 3, MD5Type, "abc" ).obj() );
+            values.push_back( BSON( "" << oid ) );
+            values.push_back( BSON( "" << OID( "612345678901234567890123" ) ) );
+            values.push_back( BSON( "" << true ) );
+            values.push_back( BSON( "" << false ) );
+            values.push_back( BSON( "" << Date_t( 5 ) ) );
+            values.push_back( BSON( "" << Date_t( static_cast<unsigned long long>( -5LL ) ) ) );
+            values.push_back( BSONObjBuilder().appendRegex( "", "a", "i" ).obj() );
+            values.push_back( BSONObjBuilder().appendRegex( "", "a" ).obj() );
+            values.push_back( BSONObjBuilder().appendRegex( "", "ab" ).obj() );
+            values.push_back( BSONObjBuilder().appendDBRef( "", "ns", oid ).obj() );
+            values.push_back( BSONObjBuilder().appendDBRef( "", "nsx", oid ).obj() );
+            values.push_back( BSONObjBuilder().appendCode( "", "f()" ).obj() );
+            values.push_back( BSONObjBuilder().appendCode( "", "g" ).obj() );
+            values.push_back( BSONObjBuilder().appendCodeWScope( "", "f",
+                                                                 BSON( "x" << 1 ) ).obj() );
+            return values;
+        }
+
+        /** the values, and pairs of them */
+        std::vector<BSONObj> someKeys() {
+            std::vector<BSONObj> values = someValues();
+            std::vector<BSONObj> keys = values;
+            for ( size_t i = 0; i < values.size(); i += 3 ) {
+                for ( size_t j = 0; j < values.size(); j += 5 ) {
+                    BSONObjBuilder b;
+                    b.appendElements( values[i] );
+                    b.appendElements( values[j] );
+                    keys.push_back( b.obj() );
+                }
+            }
+            keys.push_back( BSONObj() );
+            return keys;
+        }
+
+        const BSONObj orderings[] = { BSON( "a" << 1 << "b" << 1 ),
+                                      BSON( "a" << -1 << "b" << 1 ),
+                                      BSON( "a" << 1 << "b" << -1 ),
+                                      BSON( "a" << -1 << "b" << -1 ) };
+    }
+
+    TEST( KeyString, RoundTrip ) {
+        std::vector<BSONObj> keys = someKeys();
+        for ( size_t o = 0; o < sizeof( orderings ) / sizeof( orderings[0] ); o++ ) {
+            Ordering ord = Ordering::make( orderings[o] );
+            for ( size_t i = 0; i < keys.size(); i++ ) {
+                KeyString ks( keys[i], ord );
+                BSONObj back = ks.toBson( ord );
+                if ( !back.binaryEqual( keys[i] ) ) {
+                    log() << "key: " << keys[i] << " decoded: " << back << endl;
+                }
+                ASSERT( back.binaryEqual( keys[i] ) );
+            }
+        }
+    }
+
+    TEST( KeyString, OrdersLikeWoCompare ) {
+        std::vector<BSONObj> keys = someKeys();
+        for ( size_t o = 0; o < sizeof( orderings ) / sizeof( orderings[0] ); o++ ) {
+            Ordering ord = Ordering::make( orderings[o] );
+            std::vector<KeyString> encoded;
+            for ( size_t i = 0; i < keys.size(); i++ )
+                encoded.push_back( KeyString( keys[i], ord ) );
+
+            for ( size_t i = 0; i < keys.size(); i++ ) {
+                for ( size_t j = 0; j < keys.size(); j++ ) {
+                    int expected = sign( keys[i].woCompare( keys[j], ord, false ) );
+                    int actual = sign( encoded[i].compare( encoded[j] ) );
+                    if ( expected != actual ) {
+                        log() << keys[i] << " vs " << keys[j] << " ordering " << orderings[o]
+                              << ": " << encoded[i].toString() << " vs "
+                              << encoded[j].toString() << endl;
+                    }
+                    ASSERT_EQUALS( expected, actual );
+                }
+            }
+        }
+    }
+
+    TEST( KeyString, NumbersOfDifferentTypes ) {
+        Ordering ord = Ordering::make( BSON( "a" << 1 ) );
+        ASSERT( KeyString( BSON( "" << 5 ), ord ) == KeyString( BSON( "" << 5LL ), ord ) );
+        ASSERT( KeyString( BSON( "" << 5 ), ord ) == KeyString( BSON( "" << 5.0 ), ord ) );
+        ASSERT( KeyString( BSON( "" << 0.0 ), ord ) == KeyString( BSON( "" << -0.0 ), ord ) );
+
+        // longs that round to the same double are still ordered
+        long long big = ( 1LL << 62 ) + 1;
+        ASSERT_EQUALS( static_cast<double>( big ), static_cast<double>( big + 1 ) );
+        ASSERT( KeyString( BSON( "" << big ), ord ) < KeyString( BSON( "" << big + 1 ), ord ) );
+
+        // NaN is less than every other number
+        double nan = std::numeric_limits<double>::quiet_NaN();
+        double inf = std::numeric_limits<double>::infinity();
+        ASSERT( KeyString( BSON( "" << nan ), ord ) < KeyString( BSON( "" << -inf ), ord ) );
+    }
+
+    TEST( KeyString, SorterSerialization ) {
+        Ordering ord = Ordering::make( BSON( "a" << 1 << "b" << -1 ) );
+        KeyString ks( BSON( "" << 5LL << "" << "foo" ), ord );
+
+        BufBuilder buf;
+        ks.serializeForSorter( buf );
+        ks.serializeForSorter( buf );
+
+        BufReader reader( buf.buf(), buf.len() );
+        for ( int i = 0; i < 2; i++ ) {
+            KeyString back =
+                KeyString::deserializeForSorter( reader, KeyString::SorterDeserializeSettings() );
+            ASSERT( ks == back );
+            ASSERT_EQUALS( BSON( "" << 5LL << "" << "foo" ), back.toBson( ord ) );
+        }
+        ASSERT( reader.atEof() );
+    }
+
+    TEST( KeyString, FirstFieldPrefixNeverContradictsWoCompare ) {
+        std::vector<BSONObj> keys = someKeys();
+        for ( size_t i = 0; i < keys.size(); i++ ) {
+            for ( size_t j = 0; j < keys.size(); j++ ) {
+                unsigned long long a = KeyString::firstFieldPrefix( keys[i] );
+                unsigned long long b = KeyString::firstFieldPrefix( keys[j] );
+                if ( a < b ) {
+                    ASSERT_LESS_THAN( keys[i].woCompare( keys[j] ), 0 );
+                }
+                if ( keys[i].woCompare( keys[j] ) == 0 ) {
+                    ASSERT_EQUALS( a, b );
+                }
+            }
+        }
+    }
+
+}
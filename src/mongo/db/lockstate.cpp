@@ -36,6 +36,8 @@ namespace mongo {
           _nestableCount(0), 
           _otherCount(0), 
           _otherLock(NULL),
+          _collectionCount(0),
+          _collectionLock(NULL),
           _scopedLk(NULL),
           _lockPending(false),
           _lockPendingParallelWriter(false)
@@ -58,13 +60,29 @@ namespace mongo {
         return _threadState == 'w' || _threadState == 'W';
     }
 
+    /** @return true if ns is coll or one of its index (coll.$x) or $extra namespaces */
+    static bool isCollectionOrChild( const StringData& ns , const string& coll ) {
+        if ( !ns.startsWith( coll ) )
+            return false;
+        if ( ns.size() == coll.size() || ns[coll.size()] == '$' )
+            return true;
+        return ns.size() > coll.size() + 1 && ns[coll.size()] == '.' && ns[coll.size() + 1] == '$';
+    }
+
     bool LockState::isLocked( const StringData& ns ) {
         char db[MaxDatabaseNameLen];
         nsToDatabase(ns, db);
         
         DEV verify( _otherName.find( '.' ) == string::npos ); // XXX this shouldn't be here, but somewhere
-        if ( _otherCount && db == _otherName )
-            return true;
+        if ( _otherCount && db == _otherName ) {
+            if ( !_collectionCount )
+                return true;
+            // only intent locked: the database's own structures (asked for by db name) are
+            // ours to use, but of its collections only the one we locked
+            if ( ns.find( '.' ) == string::npos )
+                return true;
+            return isCollectionOrChild( ns , _collectionName );
+        }
 
         if ( _nestableCount ) {
             if ( mongoutils::str::equals( db , "local" ) )
@@ -127,7 +145,15 @@ namespace mongo {
             if( k ) {
                 string s = "^";
                 s += k->name();
-                b.append(s, kind(_otherCount));
+                b.append(s, _collectionCount ? "w" : kind(_otherCount));
+            }
+        }
+        if( _collectionCount ) { 
+            WrapperForRWLock *k = _collectionLock;
+            if( k ) {
+                string s = "^";
+                s += k->name();
+                b.append(s, kind(_collectionCount));
             }
         }
         BSONObj o = b.obj();
@@ -155,6 +181,9 @@ namespace mongo {
             if( _otherCount ) {
                 ss << " otherdb:" << _otherName;
             }
+            if( _collectionCount ) {
+                ss << " collection:" << _collectionName;
+            }
             if( _nestableCount ) {
                 ss << " nestableCount:" << _nestableCount << " which:";
                 if( _whichNestable == Lock::local ) 
@@ -218,10 +247,30 @@ namespace mongo {
         _otherCount = 0;
     }
 
+    void LockState::lockedCollection( int type ) {
+        fassert( 16825 , _collectionCount == 0 );
+        _collectionCount = type;
+    }
+
+    void LockState::lockedCollection( const StringData& ns , int type , WrapperForRWLock* lock ) {
+        fassert( 16826 , _collectionCount == 0 );
+        _collectionName = ns.toString();
+        _collectionCount = type;
+        _collectionLock = lock;
+    }
+
+    void LockState::unlockedCollection() {
+        // as with unlockedOther, the name and lock pointer stay cached
+        _collectionCount = 0;
+    }
+
     LockStat* LockState::getRelevantLockStat() {
         if ( _whichNestable )
             return Lock::nestableLockStat( _whichNestable );
 
+        if ( _collectionCount && _collectionLock )
+            return &_collectionLock->stats;
+
         if ( _otherCount && _otherLock )
             return &_otherLock->stats;
         
@@ -20,6 +20,8 @@
 #pragma once
 
 #include "mongo/db/d_concurrency.h"
+#include "mongo/util/concurrency/qlock.h"
+#include "mongo/util/concurrency/read_mostly_lock.h"
 
 namespace mongo {
 
@@ -79,6 +81,16 @@ namespace mongo {
         void lockedOther( const StringData& db , int type , WrapperForRWLock* lock );
         void lockedOther( int type );  // "same lock as last time" case 
         void unlockedOther();
+
+        /** >0 if we hold a CollectionWrite. the database (otherName) is then only intent locked */
+        int collectionCount() const { return _collectionCount; }
+        const string& collectionName() const { return _collectionName; }
+        WrapperForRWLock* collectionLock() const { return _collectionLock; }
+
+        void lockedCollection( const StringData& ns , int type , WrapperForRWLock* lock );
+        void lockedCollection( int type );  // "same lock as last time" case
+        void unlockedCollection();
+
         bool _batchWriter;
 
         LockStat* getRelevantLockStat();
@@ -99,6 +111,11 @@ namespace mongo {
         string _otherName;             // which database are we locking and working with (besides local/admin) 
         WrapperForRWLock* _otherLock;  // so we don't have to check the map too often (the map has a mutex)
 
+        // collection level locking related
+        int _collectionCount;          // >0 while we hold a CollectionWrite on _collectionName
+        string _collectionName;        // full ns
+        WrapperForRWLock* _collectionLock; // cached like _otherLock
+
         // for temprelease
         // for the nonrecursive case. otherwise there would be many
         // the first lock goes here, which is ok since we can't yield recursive locks
@@ -111,16 +128,33 @@ namespace mongo {
         friend class AcquiringParallelWriter;
     };
 
+    /** lock for a database or a collection.  a QLock rather than a plain rwlock so that a
+        database can also be held in an intent mode (w) while collection locks are taken
+        beneath it: intent writers run concurrently with each other but not with a shared or
+        exclusive holder of the database.
+
+        with the readMostlyDBLocks startup parameter a ReadMostlyLock is used instead, which
+        has the same three modes but doesn't make readers share a cache line.  local and admin
+        are created during static initialization, before parameters are parsed, so they always
+        use the QLock (they are mostly written anyway).
+    */
     class WrapperForRWLock : boost::noncopyable { 
-        SimpleRWLock r;
+        QLock q;
+        scoped_ptr<ReadMostlyLock> rm;
+        const string _name;
     public:
-        string name() const { return r.name; }
+        string name() const { return _name; }
         LockStat stats;
-        WrapperForRWLock(const StringData& name) : r(name) { }
-        void lock()          { r.lock(); }
-        void lock_shared()   { r.lock_shared(); }
-        void unlock()        { r.unlock(); }
-        void unlock_shared() { r.unlock_shared(); }
+        WrapperForRWLock(const StringData& name) : _name(name.toString()) {
+            if( Lock::readMostlyDBLocks() )
+                rm.reset( new ReadMostlyLock() );
+        }
+        void lock()          { if( rm ) rm->lock_W(); else q.lock_W(); }
+        void lock_shared()   { if( rm ) rm->lock_R(); else q.lock_R(); }
+        void lock_intent()   { if( rm ) rm->lock_w(); else q.lock_w(); }
+        void unlock()        { if( rm ) rm->unlock_W(); else q.unlock_W(); }
+        void unlock_shared() { if( rm ) rm->unlock_R(); else q.unlock_R(); }
+        void unlock_intent() { if( rm ) rm->unlock_w(); else q.unlock_w(); }
     };
 
     class ScopedLock;
@@ -0,0 +1,95 @@
+// element_hash_set.cpp
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/db/matcher/element_hash_set.h"
+
+#include <cstring>
+
+#include <third_party/murmurhash3/MurmurHash3.h>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/bsonobjiterator.h"
+
+namespace mongo {
+
+    namespace {
+        unsigned hashBytes( const void* data, int len, unsigned seed ) {
+            unsigned out;
+            MurmurHash3_x86_32( data, len, seed, &out );
+            return out;
+        }
+    }
+
+    unsigned BSONElementValueHasher::hash( const BSONElement& e, unsigned seed ) {
+        // elements of different canonical types are never equal, except numbers (which all
+        // share one)
+        const int canonicalType = e.canonicalType();
+        unsigned h = hashBytes( &canonicalType, sizeof( canonicalType ), seed );
+
+        switch ( e.type() ) {
+        case NumberDouble:
+        case NumberInt:
+        case NumberLong: {
+            // compareElementValues() compares mixed numbers as doubles, and numbers of the same
+            // type are only equal if their doubles are too
+            double d = e.number();
+            if ( d == 0 )
+                d = 0; // -0.0 == 0.0
+            if ( isNaN( d ) )
+                return h; // all NaNs are equal
+            return hashBytes( &d, sizeof( d ), h );
+        }
+
+        case String:
+        case Symbol:
+        case Code:
+            return hashBytes( e.valuestr(), e.valuestrsize(), h );
+
+        case Object:
+        case Array: {
+            // objects compare field by field, names included
+            BSONObjIterator i( e.embeddedObject() );
+            while ( i.more() ) {
+                BSONElement sub = i.next();
+                h = hashBytes( sub.fieldName(), sub.fieldNameSize(), h );
+                h = hash( sub, h );
+            }
+            return h;
+        }
+
+        case Bool:
+        case Date:
+        case Timestamp:
+        case jstOID:
+        case RegEx:
+        case DBRef:
+        case BinData:
+            // compared byte for byte
+            return hashBytes( e.value(), e.valuesize(), h );
+
+        case CodeWScope:
+            // compared with strcmp(); the code alone is enough to hash on
+            return hashBytes( e.codeWScopeCode(), strlen( e.codeWScopeCode() ), h );
+
+        default:
+            // MinKey, MaxKey, null, undefined: the type is the value
+            return h;
+        }
+    }
+
+}
@@ -0,0 +1,65 @@
+// element_hash_set.h
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mongo/bson/bsonelement.h"
+#include "mongo/platform/unordered_set.h"
+
+namespace mongo {
+
+    /**
+     * Hashes the value of an element (not its name) so that elements that are equal by
+     * a.woCompare( b, false ) hash the same.  In particular all numbers hash by their value as
+     * a double, so 5, NumberLong(5) and 5.0 hash alike.
+     */
+    struct BSONElementValueHasher {
+        size_t operator()( const BSONElement& e ) const { return hash( e, 0 ); }
+
+        static unsigned hash( const BSONElement& e, unsigned seed );
+    };
+
+    struct BSONElementValueEq {
+        bool operator()( const BSONElement& l, const BSONElement& r ) const {
+            return l.woCompare( r, false ) == 0;
+        }
+    };
+
+    /**
+     * A set of elements with the same notion of membership as BSONElementSet, for when all that
+     * is needed is to ask whether an element is in it.  Lookups cost one hash and usually one
+     * comparison, instead of a comparison per level of the tree.
+     *
+     * Like BSONElementSet it only points at the elements, whose BSON must outlive the set.
+     */
+    class BSONElementHashSet {
+    public:
+        void insert( const BSONElement& e ) { _set.insert( e ); }
+
+        bool contains( const BSONElement& e ) const { return _set.count( e ) > 0; }
+
+        size_t size() const { return _set.size(); }
+        bool empty() const { return _set.empty(); }
+
+        void clear() { _set.clear(); }
+
+    private:
+        unordered_set<BSONElement, BSONElementValueHasher, BSONElementValueEq> _set;
+    };
+
+}
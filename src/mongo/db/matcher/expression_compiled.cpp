@@ -0,0 +1,335 @@
+// expression_compiled.cpp
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/db/matcher/expression_compiled.h"
+
+#include <cstring>
+#include <memory>
+
+#include "mongo/bson/bsonobjiterator.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/matcher/matchable.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    namespace {
+        // documents are matched with their slots on the stack up to this many fields
+        const size_t MaxStackFields = 16;
+
+        // must agree with compareElementValues() for two numbers
+        int compareNumbers( const BSONElement& l, const BSONElement& r ) {
+            if ( l.type() == r.type() ) {
+                if ( l.type() == NumberInt ) {
+                    int L = l._numberInt();
+                    int R = r._numberInt();
+                    return L < R ? -1 : L == R ? 0 : 1;
+                }
+                if ( l.type() == NumberLong ) {
+                    long long L = l._numberLong();
+                    long long R = r._numberLong();
+                    return L < R ? -1 : L == R ? 0 : 1;
+                }
+            }
+
+            double left = l.number();
+            double right = r.number();
+            if ( left < right )
+                return -1;
+            if ( left == right )
+                return 0;
+            if ( isNaN( left ) )
+                return isNaN( right ) ? 0 : -1;
+            return 1;
+        }
+
+        // must agree with compareElementValues() for two strings
+        int compareStrings( const BSONElement& l, const BSONElement& r ) {
+            int lsz = l.valuestrsize();
+            int rsz = r.valuestrsize();
+            int res = memcmp( l.valuestr(), r.valuestr(), std::min( lsz, rsz ) );
+            if ( res )
+                return res;
+            return lsz - rsz;
+        }
+    }
+
+    CompiledMatchExpression* CompiledMatchExpression::compile( const MatchExpression* root ) {
+        if ( !root )
+            return NULL;
+
+        std::auto_ptr<CompiledMatchExpression> compiled( new CompiledMatchExpression() );
+        compiled->_compile( root );
+
+        if ( compiled->_fields.empty() ) {
+            // everything would go back to the tree
+            return NULL;
+        }
+
+        return compiled.release();
+    }
+
+    void CompiledMatchExpression::_compile( const MatchExpression* expr ) {
+        const size_t pc = _program.size();
+
+        Instruction ins;
+        ins.op = OP_TREE;
+        ins.end = 0;
+        ins.field = -1;
+        ins.dotted = false;
+        ins.cmp = expr->matchType();
+        ins.expr = expr;
+
+        switch ( expr->matchType() ) {
+        case MatchExpression::AND:
+            ins.op = OP_AND;
+            break;
+        case MatchExpression::OR:
+            ins.op = OP_OR;
+            break;
+        case MatchExpression::NOR:
+            ins.op = OP_NOR;
+            break;
+        case MatchExpression::NOT:
+            ins.op = OP_NOT;
+            break;
+
+        case MatchExpression::LTE:
+        case MatchExpression::LT:
+        case MatchExpression::EQ:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+        case MatchExpression::REGEX:
+        case MatchExpression::MOD:
+        case MatchExpression::EXISTS:
+        case MatchExpression::MATCH_IN:
+            _compileLeaf( static_cast<const LeafMatchExpression*>( expr ), &ins );
+            break;
+
+        default:
+            // $type, $where, geo and the array operators walk the document themselves
+            break;
+        }
+
+        _program.push_back( ins );
+
+        if ( ins.op == OP_AND || ins.op == OP_OR || ins.op == OP_NOR || ins.op == OP_NOT ) {
+            for ( size_t i = 0; i < expr->numChildren(); i++ )
+                _compile( expr->getChild( i ) );
+        }
+
+        _program[pc].end = _program.size();
+    }
+
+    void CompiledMatchExpression::_compileLeaf( const LeafMatchExpression* expr,
+                                                Instruction* ins ) {
+        if ( expr->allHaveToMatch() ) {
+            // arrays are matched differently, leave it to the tree
+            return;
+        }
+
+        const StringData path = expr->path();
+        const size_t dot = path.find( '.' );
+        ins->dotted = dot != string::npos;
+        ins->field = _fieldSlot( ins->dotted ? path.substr( 0, dot ) : path );
+        ins->op = OP_LEAF;
+
+        switch ( expr->matchType() ) {
+        case MatchExpression::LTE:
+        case MatchExpression::LT:
+        case MatchExpression::EQ:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+            ins->rhs = static_cast<const ComparisonMatchExpression*>( expr )->getRHS();
+            if ( ins->rhs.isNumber() )
+                ins->op = OP_CMP_NUMBER;
+            else if ( ins->rhs.type() == String )
+                ins->op = OP_CMP_STRING;
+            break;
+        case MatchExpression::EXISTS:
+            if ( !ins->dotted )
+                ins->op = OP_EXISTS;
+            break;
+        default:
+            break;
+        }
+    }
+
+    int CompiledMatchExpression::_fieldSlot( const StringData& name ) {
+        for ( size_t i = 0; i < _fields.size(); i++ ) {
+            if ( name == _fields[i] )
+                return i;
+        }
+        _fields.push_back( name.toString() );
+        return _fields.size() - 1;
+    }
+
+    size_t CompiledMatchExpression::numTreeInstructions() const {
+        size_t n = 0;
+        for ( size_t i = 0; i < _program.size(); i++ ) {
+            if ( _program[i].op == OP_TREE )
+                n++;
+        }
+        return n;
+    }
+
+    bool CompiledMatchExpression::matchesBSON( const BSONObj& doc, MatchDetails* details ) const {
+        const size_t nFields = _fields.size();
+
+        BSONElement stackFields[MaxStackFields];
+        std::vector<BSONElement> heapFields;
+        BSONElement* fields = stackFields;
+        if ( nFields > MaxStackFields ) {
+            heapFields.resize( nFields );
+            fields = &heapFields[0];
+        }
+
+        // one pass over the document fills every slot.  like BSONObj::getField(), the first
+        // field with a name wins.
+        size_t remaining = nFields;
+        BSONObjIterator it( doc );
+        while ( remaining && it.more() ) {
+            BSONElement e = it.next();
+            const char* name = e.fieldName();
+            const size_t nameSize = e.fieldNameSize() - 1;
+
+            for ( size_t i = 0; i < nFields; i++ ) {
+                const string& field = _fields[i];
+                if ( field.size() == nameSize &&
+                     fields[i].eoo() &&
+                     memcmp( field.data(), name, nameSize ) == 0 ) {
+                    fields[i] = e;
+                    remaining--;
+                    break;
+                }
+            }
+        }
+
+        return _run( 0, doc, fields, details );
+    }
+
+    bool CompiledMatchExpression::_run( size_t pc,
+                                        const BSONObj& doc,
+                                        const BSONElement* fields,
+                                        MatchDetails* details ) const {
+        const Instruction& ins = _program[pc];
+
+        // the tree nodes pass details on the same way AndMatchExpression and friends do
+        switch ( ins.op ) {
+        case OP_AND:
+            for ( size_t child = pc + 1; child < ins.end; child = _program[child].end ) {
+                if ( !_run( child, doc, fields, details ) ) {
+                    if ( details )
+                        details->resetOutput();
+                    return false;
+                }
+            }
+            return true;
+
+        case OP_OR:
+            for ( size_t child = pc + 1; child < ins.end; child = _program[child].end ) {
+                if ( _run( child, doc, fields, NULL ) )
+                    return true;
+            }
+            return false;
+
+        case OP_NOR:
+            for ( size_t child = pc + 1; child < ins.end; child = _program[child].end ) {
+                if ( _run( child, doc, fields, NULL ) )
+                    return false;
+            }
+            return true;
+
+        case OP_NOT:
+            return !_run( pc + 1, doc, fields, NULL );
+
+        case OP_TREE: {
+            BSONMatchableDocument mydoc( doc );
+            return ins.expr->matches( &mydoc, details );
+        }
+
+        default:
+            return _runLeaf( ins, doc, fields, details );
+        }
+    }
+
+    bool CompiledMatchExpression::_runLeaf( const Instruction& ins,
+                                            const BSONObj& doc,
+                                            const BSONElement* fields,
+                                            MatchDetails* details ) const {
+        BSONElement e = fields[ins.field];
+
+        if ( ins.dotted ) {
+            if ( e.type() == Object || e.type() == Array ) {
+                BSONMatchableDocument mydoc( doc );
+                return ins.expr->matches( &mydoc, details );
+            }
+            // a path through a missing field or a scalar finds nothing (see
+            // getFieldDottedOrArray())
+            e = BSONElement();
+        }
+        else if ( e.type() == Array ) {
+            // every element may be a match; let the tree deal with it
+            BSONMatchableDocument mydoc( doc );
+            return ins.expr->matches( &mydoc, details );
+        }
+
+        switch ( ins.op ) {
+        case OP_CMP_NUMBER:
+            // other types are never equal or ordered against a number (see
+            // ComparisonMatchExpression::matchesSingleElement())
+            if ( !e.isNumber() )
+                return false;
+            return _satisfies( ins.cmp, compareNumbers( e, ins.rhs ) );
+
+        case OP_CMP_STRING:
+            if ( e.type() != String && e.type() != Symbol )
+                return false;
+            return _satisfies( ins.cmp, compareStrings( e, ins.rhs ) );
+
+        case OP_EXISTS:
+            return !e.eoo();
+
+        case OP_LEAF:
+            return ins.expr->matchesSingleElement( e );
+
+        default:
+            verify( 0 );
+            return false;
+        }
+    }
+
+    bool CompiledMatchExpression::_satisfies( MatchExpression::MatchType cmp, int x ) {
+        switch ( cmp ) {
+        case MatchExpression::LT:
+            return x < 0;
+        case MatchExpression::LTE:
+            return x <= 0;
+        case MatchExpression::EQ:
+            return x == 0;
+        case MatchExpression::GT:
+            return x > 0;
+        case MatchExpression::GTE:
+            return x >= 0;
+        default:
+            verify( 0 );
+            return false;
+        }
+    }
+
+}
@@ -0,0 +1,113 @@
+// expression_compiled.h
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/match_details.h"
+
+namespace mongo {
+
+    class LeafMatchExpression;
+
+    /**
+     * A MatchExpression tree flattened into a program that is cheaper to run than the tree.
+     *
+     * Every top level field the predicates look at gets a slot, shared by all predicates on
+     * that field (or on paths under it), and a document's slots are filled by a single pass
+     * over its top level fields.  The program is the tree in pre-order; each instruction
+     * knows where its subtree ends, so $and/$or/$nor/$not short circuit by skipping ahead.
+     * Comparisons against a number or a string are done inline for elements of that type.
+     *
+     * Whatever isn't worth compiling - arrays in the document, paths under an embedded
+     * document, and the operators with no instruction of their own - is handed back to the
+     * tree, so results (and MatchDetails) are always the same as MatchExpression::matches().
+     *
+     * The program points into the tree it was compiled from, which must outlive it.
+     */
+    class CompiledMatchExpression {
+        MONGO_DISALLOW_COPYING( CompiledMatchExpression );
+    public:
+        /**
+         * @return a program for root, or NULL if there would be nothing to gain over running
+         * the tree.  Caller owns the result.
+         */
+        static CompiledMatchExpression* compile( const MatchExpression* root );
+
+        bool matchesBSON( const BSONObj& doc, MatchDetails* details = 0 ) const;
+
+        /** number of distinct top level fields looked at */
+        size_t numFields() const { return _fields.size(); }
+
+        /** number of instructions that go back to the tree */
+        size_t numTreeInstructions() const;
+
+    private:
+        enum OpCode {
+            OP_AND,
+            OP_OR,
+            OP_NOR,
+            OP_NOT,
+
+            OP_CMP_NUMBER,   // comparison with a number
+            OP_CMP_STRING,   // comparison with a string
+            OP_EXISTS,       // non-dotted path
+            OP_LEAF,         // any other LeafMatchExpression: matchesSingleElement()
+
+            OP_TREE          // MatchExpression::matches()
+        };
+
+        struct Instruction {
+            OpCode op;
+            size_t end;                 // index of the first instruction after our subtree
+            int field;                  // slot, for leaves
+            bool dotted;                // path goes below the field
+            MatchExpression::MatchType cmp;
+            BSONElement rhs;            // for OP_CMP_*
+            const MatchExpression* expr;
+        };
+
+        CompiledMatchExpression() {}
+
+        /** append the instructions for expr and its children */
+        void _compile( const MatchExpression* expr );
+        void _compileLeaf( const LeafMatchExpression* expr, Instruction* ins );
+        int _fieldSlot( const StringData& name );
+
+        bool _run( size_t pc,
+                   const BSONObj& doc,
+                   const BSONElement* fields,
+                   MatchDetails* details ) const;
+        bool _runLeaf( const Instruction& ins,
+                       const BSONObj& doc,
+                       const BSONElement* fields,
+                       MatchDetails* details ) const;
+
+        /** @return whether x, the result of comparing an element to the rhs, satisfies cmp */
+        static bool _satisfies( MatchExpression::MatchType cmp, int x );
+
+        std::vector<Instruction> _program;
+        std::vector<std::string> _fields; // top level field name of each slot
+    };
+
+}
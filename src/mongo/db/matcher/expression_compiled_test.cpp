@@ -0,0 +1,136 @@
+// expression_compiled_test.cpp
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/unittest/unittest.h"
+
+#include "mongo/db/matcher/expression_compiled.h"
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_parser.h"
+
+namespace mongo {
+
+    namespace {
+        MatchExpression* parse( const BSONObj& query ) {
+            StatusWithMatchExpression result = MatchExpressionParser::parse( query );
+            ASSERT_TRUE( result.isOK() );
+            return result.getValue();
+        }
+
+        const char* const docs[] = {
+            "{}",
+            "{a: 1}",
+            "{a: 5, b: 'foo'}",
+            "{a: 5.5, b: 'fo', c: null}",
+            "{a: NumberLong(5), b: 'foo\\u0000bar'}",
+            "{a: 'x', b: 3}",
+            "{a: [1, 5, 9], b: 'foo'}",
+            "{a: {b: 1}, c: 2}",
+            "{a: [{b: 1}, {b: 4}], c: 3}",
+            "{c: 1, a: 2, a: 7}",
+            "{a: null, b: undefined}",
+            "{a: NaN}",
+            "{b: 'bar', a: 4, x: 1, y: 2, z: 3}"
+        };
+
+        const char* const queries[] = {
+            "{a: 5}",
+            "{a: {$gt: 2, $lte: 5}}",
+            "{a: {$lt: 5.5}}",
+            "{a: {$gte: NumberLong(5)}}",
+            "{a: {$ne: 5}}",
+            "{a: null}",
+            "{a: {$gt: NaN}}",
+            "{a: {$gte: NaN}}",
+            "{b: 'foo'}",
+            "{b: {$gt: 'fo'}}",
+            "{b: {$lte: 'foo'}}",
+            "{a: {$exists: true}}",
+            "{a: {$exists: false}}",
+            "{a: {$in: [1, 7, 'x']}}",
+            "{a: {$nin: [1, 7]}}",
+            "{a: {$mod: [2, 1]}}",
+            "{b: /^fo/}",
+            "{'a.b': 1}",
+            "{'a.b': {$exists: false}}",
+            "{'a.b': {$gt: 2}}",
+            "{a: {$gt: 1}, b: 'foo', c: {$exists: false}}",
+            "{$or: [{a: 1}, {b: 'foo'}, {c: 2}]}",
+            "{$nor: [{a: 1}, {b: 'bar'}]}",
+            "{a: {$not: {$gt: 4}}}",
+            "{$and: [{a: {$gte: 1}}, {$or: [{b: 3}, {c: {$lt: 3}}]}]}",
+            "{a: {$type: 1}}",
+            "{a: {$size: 3}}",
+            "{a: {$all: [1, 5]}}",
+            "{a: {$elemMatch: {b: 4}}}"
+        };
+    }
+
+    TEST( CompiledMatchExpression, SameAsTree ) {
+        for ( size_t q = 0; q < sizeof( queries ) / sizeof( queries[0] ); q++ ) {
+            boost::scoped_ptr<MatchExpression> expr( parse( fromjson( queries[q] ) ) );
+            boost::scoped_ptr<CompiledMatchExpression> compiled(
+                CompiledMatchExpression::compile( expr.get() ) );
+            if ( !compiled )
+                continue;
+
+            for ( size_t d = 0; d < sizeof( docs ) / sizeof( docs[0] ); d++ ) {
+                BSONObj doc = fromjson( docs[d] );
+
+                MatchDetails treeDetails;
+                treeDetails.requestElemMatchKey();
+                MatchDetails compiledDetails;
+                compiledDetails.requestElemMatchKey();
+
+                bool tree = expr->matchesBSON( doc, &treeDetails );
+                bool fast = compiled->matchesBSON( doc, &compiledDetails );
+                if ( tree != fast ) {
+                    log() << "query: " << queries[q] << " doc: " << docs[d]
+                          << " tree: " << tree << " compiled: " << fast << endl;
+                }
+                ASSERT_EQUALS( tree, fast );
+                ASSERT_EQUALS( treeDetails.hasElemMatchKey(),
+                               compiledDetails.hasElemMatchKey() );
+                if ( treeDetails.hasElemMatchKey() ) {
+                    ASSERT_EQUALS( treeDetails.elemMatchKey(),
+                                   compiledDetails.elemMatchKey() );
+                }
+            }
+        }
+    }
+
+    TEST( CompiledMatchExpression, SharedFields ) {
+        boost::scoped_ptr<MatchExpression> expr(
+            parse( fromjson( "{a: {$gt: 1, $lt: 9}, 'a.b': 1, b: 2, $or: [{b: 3}, {c: 4}]}" ) ) );
+        boost::scoped_ptr<CompiledMatchExpression> compiled(
+            CompiledMatchExpression::compile( expr.get() ) );
+        ASSERT( compiled );
+        ASSERT_EQUALS( 3U, compiled->numFields() );
+        ASSERT_EQUALS( 0U, compiled->numTreeInstructions() );
+    }
+
+    TEST( CompiledMatchExpression, NothingToCompile ) {
+        boost::scoped_ptr<MatchExpression> expr( parse( fromjson( "{a: {$size: 1}}" ) ) );
+        ASSERT( !CompiledMatchExpression::compile( expr.get() ) );
+    }
+
+}
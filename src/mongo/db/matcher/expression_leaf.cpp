@@ -467,10 +467,25 @@ namespace mongo {
         if ( e.type() == Array && e.Obj().isEmpty() )
             _hasEmptyArray = true;
 
-        _equalities.insert( e );
+        _addEquality( e );
         return Status::OK();
     }
 
+    void ArrayFilterEntries::_addEquality( const BSONElement& e ) {
+        _equalities.insert( e );
+
+        if ( !_hashedEqualities.empty() ) {
+            _hashedEqualities.insert( e );
+        }
+        else if ( _equalities.size() >= MinHashedEqualities ) {
+            for ( BSONElementSet::const_iterator i = _equalities.begin();
+                  i != _equalities.end();
+                  ++i ) {
+                _hashedEqualities.insert( *i );
+            }
+        }
+    }
+
     Status ArrayFilterEntries::addRegex( RegexMatchExpression* expr ) {
         _regexes.push_back( expr );
         return Status::OK();
@@ -492,7 +507,8 @@ namespace mongo {
     void ArrayFilterEntries::copyTo( ArrayFilterEntries& toFillIn ) const {
         toFillIn._hasNull = _hasNull;
         toFillIn._hasEmptyArray = _hasEmptyArray;
-        toFillIn._equalities = _equalities;
+        for ( BSONElementSet::const_iterator i = _equalities.begin(); i != _equalities.end(); ++i )
+            toFillIn._addEquality( *i );
         for ( unsigned i = 0; i < _regexes.size(); i++ )
             toFillIn._regexes.push_back( static_cast<RegexMatchExpression*>(_regexes[i]->shallowClone()) );
     }
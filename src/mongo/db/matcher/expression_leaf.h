@@ -24,6 +24,7 @@
 
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonmisc.h"
+#include "mongo/db/matcher/element_hash_set.h"
 #include "mongo/db/matcher/expression.h"
 
 namespace mongo {
@@ -251,7 +252,11 @@ namespace mongo {
         Status addRegex( RegexMatchExpression* expr );
 
         const BSONElementSet& equalities() const { return _equalities; }
-        bool contains( const BSONElement& elem ) const { return _equalities.count(elem) > 0; }
+        bool contains( const BSONElement& elem ) const {
+            if ( !_hashedEqualities.empty() )
+                return _hashedEqualities.contains( elem );
+            return _equalities.count(elem) > 0;
+        }
 
         size_t numRegexes() const { return _regexes.size(); }
         RegexMatchExpression* regex( int idx ) const { return _regexes[idx]; }
@@ -264,10 +269,19 @@ namespace mongo {
         bool equivalent( const ArrayFilterEntries& other ) const;
 
         void copyTo( ArrayFilterEntries& toFillIn ) const;
+        /**
+         * With at least this many equalities, contains() looks them up in a hash set rather
+         * than searching the ordered set.
+         */
+        static const size_t MinHashedEqualities = 16;
+
     private:
+        void _addEquality( const BSONElement& e );
+
         bool _hasNull; // if _equalities has a jstNULL element in it
         bool _hasEmptyArray;
         BSONElementSet _equalities;
+        BSONElementHashSet _hashedEqualities; // empty until there are MinHashedEqualities
         std::vector<RegexMatchExpression*> _regexes;
     };
 
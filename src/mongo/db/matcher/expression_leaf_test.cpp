@@ -1294,6 +1294,58 @@ namespace mongo {
     }
 
 
+    TEST( InMatchExpression, MatchesElementHashed ) {
+        BSONArrayBuilder operandBuilder;
+        for ( int i = 0; i < 100; i++ )
+            operandBuilder.append( i * 2 );
+        operandBuilder.append( "r" );
+        operandBuilder.append( BSON( "x" << 1 << "y" << 2.5 ) );
+        operandBuilder.appendNull();
+        BSONObj operand = operandBuilder.arr();
+
+        InMatchExpression in;
+        BSONObjIterator i( operand );
+        while ( i.more() )
+            in.getArrayFilterEntries()->addEquality( i.next() );
+        ASSERT( in.getArrayFilterEntries()->size() >
+                static_cast<int>( ArrayFilterEntries::MinHashedEqualities ) );
+
+        // numbers of any type that are equal to a member
+        ASSERT( in.matchesSingleElement( BSON( "a" << 4 ).firstElement() ) );
+        ASSERT( in.matchesSingleElement( BSON( "a" << 4LL ).firstElement() ) );
+        ASSERT( in.matchesSingleElement( BSON( "a" << 4.0 ).firstElement() ) );
+        ASSERT( in.matchesSingleElement( BSON( "a" << -0.0 ).firstElement() ) );
+        ASSERT( !in.matchesSingleElement( BSON( "a" << 4.5 ).firstElement() ) );
+        ASSERT( !in.matchesSingleElement( BSON( "a" << 5 ).firstElement() ) );
+        ASSERT( !in.matchesSingleElement( BSON( "a" << "4" ).firstElement() ) );
+
+        ASSERT( in.matchesSingleElement( BSON( "a" << "r" ).firstElement() ) );
+        ASSERT( !in.matchesSingleElement( BSON( "a" << "s" ).firstElement() ) );
+        ASSERT( in.matchesSingleElement(
+                    BSON( "a" << BSON( "x" << 1.0 << "y" << 2.5 ) ).firstElement() ) );
+        ASSERT( !in.matchesSingleElement(
+                    BSON( "a" << BSON( "y" << 2.5 << "x" << 1 ) ).firstElement() ) );
+        ASSERT( in.matchesSingleElement( BSON( "a" << BSONNULL ).firstElement() ) );
+        ASSERT( !in.matchesSingleElement( BSON( "a" << BSONUndefined ).firstElement() ) );
+
+        InMatchExpression copy;
+        in.copyTo( &copy );
+        ASSERT( copy.matchesSingleElement( BSON( "a" << 198LL ).firstElement() ) );
+        ASSERT( !copy.matchesSingleElement( BSON( "a" << 199 ).firstElement() ) );
+    }
+
+    TEST( BSONElementValueHasher, EqualElementsHashAlike ) {
+        BSONObj same = BSON( "a" << 7 << "b" << 7LL << "c" << 7.0 );
+        BSONElementValueHasher hasher;
+        ASSERT_EQUALS( hasher( same["a"] ), hasher( same["b"] ) );
+        ASSERT_EQUALS( hasher( same["a"] ), hasher( same["c"] ) );
+
+        BSONObj objects = BSON( "a" << BSON( "x" << BSON_ARRAY( 1 << 2LL ) )
+                             << "b" << BSON( "x" << BSON_ARRAY( 1.0 << 2 ) ) );
+        ASSERT_EQUALS( 0, objects["a"].woCompare( objects["b"], false ) );
+        ASSERT_EQUALS( hasher( objects["a"] ), hasher( objects["b"] ) );
+    }
+
     TEST( InMatchExpression, MatchesScalar ) {
         BSONObj operand = BSON_ARRAY( 5 );
         InMatchExpression in;
@@ -117,6 +117,7 @@ namespace mongo {
                  result.isOK() );
 
         _expression.reset( result.getValue() );
+        _compiled.reset( CompiledMatchExpression::compile( _expression.get() ) );
     }
 
     Matcher2::Matcher2( const Matcher2 &docMatcher, const BSONObj &constrainIndexKey )
@@ -134,8 +135,11 @@ namespace mongo {
         if ( !_expression )
             return true;
 
-        if ( _indexKey.isEmpty() )
+        if ( _indexKey.isEmpty() ) {
+            if ( _compiled )
+                return _compiled->matchesBSON( doc, details );
             return _expression->matchesBSON( doc, details );
+        }
 
         if ( !doc.isEmpty() && doc.firstElement().fieldName()[0] )
             return _expression->matchesBSON( doc, details );
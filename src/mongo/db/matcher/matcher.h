@@ -24,6 +24,7 @@
 #include "mongo/base/status.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_compiled.h"
 #include "mongo/db/matcher/match_details.h"
 
 namespace mongo {
@@ -81,6 +82,9 @@ namespace mongo {
 
         boost::scoped_ptr<MatchExpression> _expression;
 
+        // _expression compiled for matching whole documents, if worth it
+        boost::scoped_ptr<CompiledMatchExpression> _compiled;
+
         IndexSpliceInfo _spliceInfo;
 
         static MatchExpression* _spliceForIndex( const set<std::string>& keys,
@@ -29,6 +29,7 @@
 #include "client.h"
 
 #include "pdfile.h"
+#include "mongo/db/matcher/expression_leaf.h"
 
 namespace {
     inline pcrecpp::RE_Options flags2options(const char* flags) {
@@ -205,6 +206,13 @@ namespace mongo {
                 uassert( 13020 , "with $all, can't mix $elemMatch and others" , _myset->size() == 0 && !_myregex.get());
             }
 
+            if ( ( op == BSONObj::opIN || op == BSONObj::NIN ) &&
+                 _myset->size() >= ArrayFilterEntries::MinHashedEqualities ) {
+                _myHashedSet.reset( new BSONElementHashSet() );
+                for( set<BSONElement,element_lt>::const_iterator j = _myset->begin(); j != _myset->end(); ++j )
+                    _myHashedSet->insert( *j );
+            }
+
         }
 
         int ElementMatcher::inverseOfNegativeCompareOp() const {
@@ -605,9 +613,15 @@ namespace mongo {
 
         if ( op == BSONObj::opIN ) {
             // { $in : [1,2,3] }
-            int count = bm._myset->count(l);
-            if ( count )
-                return count;
+            if ( bm._myHashedSet ) {
+                if ( bm._myHashedSet->contains(l) )
+                    return 1;
+            }
+            else {
+                int count = bm._myset->count(l);
+                if ( count )
+                    return count;
+            }
             if ( bm._myregex.get() ) {
                 for( vector<RegexMatcher>::const_iterator i = bm._myregex->begin(); i != bm._myregex->end(); ++i ) {
                     if ( regexMatches( *i, l ) ) {
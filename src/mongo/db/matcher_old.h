@@ -22,6 +22,7 @@
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/geo/geoquery.h"
+#include "mongo/db/matcher/element_hash_set.h"
 #include "mongo/db/matcher/match_details.h"
 
 namespace mongo {
@@ -98,6 +99,7 @@ namespace mongo {
             int _compareOp;
             bool _isNot;
             shared_ptr< set<BSONElement,element_lt> > _myset;
+            shared_ptr< BSONElementHashSet > _myHashedSet; // _myset again, if it is large
             shared_ptr< vector<RegexMatcher> > _myregex;
 
             // these are for specific operators
@@ -714,13 +714,38 @@ namespace mongo {
     // that is NOT handled here yet!  TODO
     // repair may not use nsdt though not sure.  anyway, requires work.
     NamespaceDetailsTransient::NamespaceDetailsTransient(Database *db, const string& ns) : 
-        _ns(ns), _keysComputed(false), _qcWriteCount() 
+        _ns(ns), _keysComputed(false), _qcWriteCount(), _qcReplans() 
     {
         dassert(db);
     }
 
     NamespaceDetailsTransient::~NamespaceDetailsTransient() { 
     }
+
+    void NamespaceDetailsTransient::registerCachedQueryPlanRun( const QueryPattern &pattern,
+                                                                const BSONObj &indexKey,
+                                                                long long nScanned ) {
+        map<QueryPattern,CachedQueryPlan>::iterator i = _qcCache.find( pattern );
+        if ( i == _qcCache.end() || i->second.indexKey().woCompare( indexKey ) != 0 ) {
+            // replaced or cleared while the query ran
+            return;
+        }
+        i->second.recordRun( nScanned );
+    }
+
+    void NamespaceDetailsTransient::appendQueryCacheInfo( BSONObjBuilder* out ) const {
+        BSONArrayBuilder plans( out->subarrayStart( "plans" ) );
+        for ( map<QueryPattern,CachedQueryPlan>::const_iterator i = _qcCache.begin();
+              i != _qcCache.end(); ++i ) {
+            BSONObjBuilder b( plans.subobjStart() );
+            b.append( "pattern", i->first.toBSON() );
+            b.appendElements( i->second.toBSON() );
+            b.done();
+        }
+        plans.done();
+        out->append( "writes", _qcWriteCount );
+        out->append( "replans", _qcReplans );
+    }
     
     void NamespaceDetailsTransient::resetCollection(const string& ns ) {
         SimpleMutex::scoped_lock lk(_qcMutex);
@@ -499,7 +499,8 @@ namespace mongo {
 
         /* query cache (for query optimizer) ------------------------------------- */
     private:
-        int _qcWriteCount;
+        long long _qcWriteCount;
+        long long _qcReplans;
         map<QueryPattern,CachedQueryPlan> _qcCache;
         static NamespaceDetailsTransient& make_inlock(const string& ns);
         static CMap& get_cmap_inlock(const string& ns);
@@ -523,21 +524,34 @@ namespace mongo {
         void clearQueryCache() {
             _qcCache.clear();
             _qcWriteCount = 0;
+            _qcReplans = 0;
         }
-        /* you must notify the cache if you are doing writes, as query plan utility will change */
+        /* you must notify the cache if you are doing writes.  Cached plans are no longer dropped
+           after a number of writes: a plan that does much worse than when it was recorded is
+           replaced by running all the candidates again (see QueryPlanRunnerQueue), which
+           catches plans the writes have made worse without racing the ones they haven't.
+        */
         void notifyOfWriteOp() {
             if ( _qcCache.empty() )
                 return;
-            if ( ++_qcWriteCount >= 100 )
-                clearQueryCache();
+            ++_qcWriteCount;
         }
         CachedQueryPlan cachedQueryPlanForPattern( const QueryPattern &pattern ) {
-            return _qcCache[ pattern ];
+            map<QueryPattern,CachedQueryPlan>::const_iterator i = _qcCache.find( pattern );
+            return i == _qcCache.end() ? CachedQueryPlan() : i->second;
         }
         void registerCachedQueryPlanForPattern( const QueryPattern &pattern,
                                                const CachedQueryPlan &cachedQueryPlan ) {
             _qcCache[ pattern ] = cachedQueryPlan;
         }
+        /** Record a completed run of the cached plan for pattern, if it is still the one cached. */
+        void registerCachedQueryPlanRun( const QueryPattern &pattern,
+                                         const BSONObj &indexKey,
+                                         long long nScanned );
+        /** A cached plan scanned too much and the candidate plans are being run again. */
+        void notifyOfReplan() { ++_qcReplans; }
+        /** Describe the query cache, for the planCache command. */
+        void appendQueryCacheInfo( BSONObjBuilder* out ) const;
 
     }; /* NamespaceDetailsTransient */
 
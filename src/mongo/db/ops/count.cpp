@@ -21,6 +21,7 @@
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/client.h"
 #include "mongo/db/clientcursor.h"
+#include "mongo/db/parallel_collection_scan.h"
 #include "mongo/db/query_optimizer.h"
 #include "mongo/db/queryutil.h"
 #include "mongo/util/elapsed_tracker.h"
@@ -52,6 +53,34 @@ namespace mongo {
 
         } _countPlanPolicies;
 
+        /** Counts the documents one scanning thread matches. */
+        class CountSink : public ParallelCollectionScan::Sink {
+        public:
+            CountSink() : _count() {}
+            virtual bool consume( const BSONObj& obj ) {
+                ++_count;
+                return true;
+            }
+            long long count() const { return _count; }
+        private:
+            long long _count;
+        };
+
+        /** @return the number of documents matching 'query', counted on 'nThreads' threads. */
+        long long parallelCount( NamespaceDetails* d, const BSONObj& query, int nThreads ) {
+            OwnedPointerVector<ParallelCollectionScan::Sink> sinks;
+            for( int i = 0; i < nThreads; ++i ) {
+                sinks.mutableVector().push_back( new CountSink() );
+            }
+            ParallelCollectionScan scan( d, query );
+            scan.run( sinks.vector() );
+            long long count = 0;
+            for( int i = 0; i < nThreads; ++i ) {
+                count += static_cast<CountSink*>( sinks.vector()[ i ] )->count();
+            }
+            return count;
+        }
+
     }
     
     long long runCount( const char *ns, const BSONObj &cmd, string &err, int &errCode ) {
@@ -80,6 +109,15 @@ namespace mongo {
         ClientCursor::Holder ccPointer;
         ElapsedTracker timeToStartYielding( 256, 20 );
         try {
+            // A collection scan without a limit to stop early at may be split among threads.
+            if ( limit == 0 && dynamic_cast<BasicCursor*>( cursor.get() ) ) {
+                int nThreads = ParallelCollectionScan::threadsFor( d, query );
+                if ( nThreads > 0 ) {
+                    cursor.reset();
+                    return applySkipLimit( parallelCount( d, query, nThreads ), cmd );
+                }
+            }
+
             while( cursor->ok() ) {
                 if ( !ccPointer ) {
                     if ( timeToStartYielding.intervalHasElapsed() ) {
@@ -45,9 +45,9 @@ namespace mongo {
     */
     const int32_t MaxBytesToReturnToClientAtOnce = 4 * 1024 * 1024;
 
-    bool runCommands(const char *ns, BSONObj& jsobj, CurOp& curop, BufBuilder &b, BSONObjBuilder& anObjBuilder, bool fromRepl, int queryOptions) {
+    bool runCommands(const char *ns, BSONObj& jsobj, CurOp& curop, BSONObjBuilder& anObjBuilder, bool fromRepl, int queryOptions) {
         try {
-            return _runCommands(ns, jsobj, b, anObjBuilder, fromRepl, queryOptions);
+            return _runCommands(ns, jsobj, anObjBuilder, fromRepl, queryOptions);
         }
         catch( SendStaleConfigException& ){
             throw;
@@ -60,8 +60,6 @@ namespace mongo {
         }
         anObjBuilder.append("errmsg", "db assertion failure");
         anObjBuilder.append("ok", 0.0);
-        BSONObj x = anObjBuilder.done();
-        b.appendBuf((void*) x.objdata(), x.objsize());
         return true;
     }
 
@@ -949,24 +947,13 @@ namespace mongo {
         
         if ( pq.couldBeCommand() ) {
             curop.markCommand();
-            BufBuilder bb;
-            bb.skip(sizeof(QueryResult));
             BSONObjBuilder cmdResBuf;
-            if ( runCommands(ns, jsobj, curop, bb, cmdResBuf, false, queryOptions) ) {
+            if ( runCommands(ns, jsobj, curop, cmdResBuf, false, queryOptions) ) {
                 curop.debug().iscommand = true;
                 curop.debug().query = jsobj;
 
-                auto_ptr< QueryResult > qr;
-                qr.reset( (QueryResult *) bb.buf() );
-                bb.decouple();
-                qr->setResultFlagsToOk();
-                qr->len = bb.len();
-                curop.debug().responseLength = bb.len();
-                qr->setOperation(opReply);
-                qr->cursorId = 0;
-                qr->startingFrom = 0;
-                qr->nReturned = 1;
-                result.setData( qr.release(), true );
+                replyToQuery( ResultFlag_AwaitCapable, result, cmdResBuf.obj() );
+                curop.debug().responseLength = result.size();
             }
             else {
                 uasserted(13530, "bad or malformed command request?");
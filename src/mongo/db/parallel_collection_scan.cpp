@@ -0,0 +1,250 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/db/parallel_collection_scan.h"
+
+#include <boost/bind.hpp>
+
+#include "mongo/db/client.h"
+#include "mongo/db/kill_current_op.h"
+#include "mongo/db/matcher.h"
+#include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    // Threads an unindexed count or aggregation scans a large collection with.  Scanning threads
+    // hold off writers for the whole scan, so 0 or 1 keeps to the yielding single threaded scan.
+    static int parallelCollectionScanThreads = 0;
+    static ExportedServerParameter<int> ParallelCollectionScanThreadsSetting(
+            ServerParameterSet::getGlobal(), "parallelCollectionScanThreads",
+            &parallelCollectionScanThreads, true, true );
+
+    namespace {
+
+        /** @return true if 'query' has a $where clause at any level. */
+        bool hasWhere( const BSONObj& query ) {
+            BSONForEach( e, query ) {
+                if ( str::equals( e.fieldName(), "$where" ) ) {
+                    return true;
+                }
+                if ( e.type() == Array && ( str::equals( e.fieldName(), "$and" ) ||
+                                            str::equals( e.fieldName(), "$or" ) ||
+                                            str::equals( e.fieldName(), "$nor" ) ) ) {
+                    BSONForEach( clause, e.embeddedObject() ) {
+                        if ( clause.isABSONObj() && hasWhere( clause.embeddedObject() ) ) {
+                            return true;
+                        }
+                    }
+                }
+            }
+            return false;
+        }
+
+    } // namespace
+
+    /** Passes a thread's matches to the scan's buffer a batch at a time. */
+    class ParallelCollectionScan::BufferSink : public Sink {
+    public:
+        BufferSink( ParallelCollectionScan* scan ) : _scan( scan ) {}
+        virtual bool consume( const BSONObj& obj ) {
+            _batch.push_back( obj );
+            return _batch.size() < BatchSize || _scan->pushBatch( &_batch );
+        }
+        virtual void done() {
+            if ( !_batch.empty() ) {
+                _scan->pushBatch( &_batch );
+            }
+        }
+    private:
+        static const size_t BatchSize = 100;
+        ParallelCollectionScan* _scan;
+        vector<BSONObj> _batch;
+    };
+
+    int ParallelCollectionScan::threadsFor( NamespaceDetails* d, const BSONObj& query ) {
+        if ( parallelCollectionScanThreads < 2 ||
+             d->stats.datasize < MinParallelDataSize ||
+             hasWhere( query ) ) {
+            return 0;
+        }
+        return parallelCollectionScanThreads;
+    }
+
+    ParallelCollectionScan::ParallelCollectionScan( NamespaceDetails* d, const BSONObj& query ) :
+        _query( query.getOwned() ),
+        _mutex( "ParallelCollectionScan" ),
+        _nextExtent(),
+        _running(),
+        _nscanned(),
+        _stop() {
+        // Find the extents here, the scanning threads having no database context.
+        for( Extent* e = d->firstExtent.isNull() ? 0 : d->firstExtent.ext(); e;
+             e = e->getNextExtent() ) {
+            _extents.push_back( e );
+        }
+    }
+
+    ParallelCollectionScan::~ParallelCollectionScan() {
+        stop();
+    }
+
+    void ParallelCollectionScan::run( const vector<Sink*>& sinks ) {
+        startThreads( sinks );
+        scoped_lock lk( _mutex );
+        while( _running > 0 ) {
+            waitForChange( lk );
+        }
+        checkFailed();
+    }
+
+    void ParallelCollectionScan::start( int nThreads ) {
+        for( int i = 0; i < nThreads; ++i ) {
+            _bufferSinks.mutableVector().push_back( new BufferSink( this ) );
+        }
+        startThreads( _bufferSinks.vector() );
+    }
+
+    bool ParallelCollectionScan::next( BSONObj* obj ) {
+        scoped_lock lk( _mutex );
+        while( 1 ) {
+            checkFailed();
+            if ( !_buffer.empty() ) {
+                *obj = _buffer.front();
+                _buffer.pop_front();
+                if ( _buffer.size() == MaxBufferedDocs / 2 ) {
+                    // Let threads waiting on a full buffer continue.
+                    _changed.notify_all();
+                }
+                return true;
+            }
+            if ( _running == 0 ) {
+                return false;
+            }
+            waitForChange( lk );
+        }
+    }
+
+    long long ParallelCollectionScan::nscanned() const {
+        scoped_lock lk( _mutex );
+        return _nscanned;
+    }
+
+    void ParallelCollectionScan::startThreads( const vector<Sink*>& sinks ) {
+        verify( _running == 0 );
+        int nThreads = std::min( sinks.size(), _extents.size() );
+        LOG(1) << "scanning " << _extents.size() << " extents on " << nThreads << " threads"
+               << endl;
+        for( int i = 0; i < nThreads; ++i ) {
+            {
+                scoped_lock lk( _mutex );
+                ++_running;
+            }
+            _threads.create_thread( boost::bind( &ParallelCollectionScan::scanThread, this,
+                                                 sinks[ i ] ) );
+        }
+    }
+
+    void ParallelCollectionScan::scanThread( Sink* sink ) {
+        Client::initThread( "parallelCollectionScan" );
+
+        long long nscanned = 0;
+        string errmsg;
+        try {
+            Matcher matcher( _query );
+            Extent* e;
+            bool more = true;
+            while( more && nextExtent( &e ) ) {
+                for( DiskLoc loc = e->firstRecord; !loc.isNull() && !_stop; ) {
+                    Record* r = e->getRecord( loc );
+                    BSONObj obj = BSONObj::make( r );
+                    ++nscanned;
+                    if ( matcher.matches( obj ) && !sink->consume( obj ) ) {
+                        more = false;
+                        break;
+                    }
+                    loc = r->nextInExtent( loc );
+                }
+            }
+            sink->done();
+        }
+        catch ( DBException& e ) {
+            errmsg = e.toString();
+        }
+        catch ( std::exception& e ) {
+            errmsg = e.what();
+        }
+
+        {
+            scoped_lock lk( _mutex );
+            if ( !errmsg.empty() ) {
+                if ( _errmsg.empty() ) {
+                    _errmsg = errmsg;
+                }
+                _stop = true;
+            }
+            _nscanned += nscanned;
+            --_running;
+            _changed.notify_all();
+        }
+
+        cc().shutdown();
+    }
+
+    bool ParallelCollectionScan::nextExtent( Extent** extent ) {
+        scoped_lock lk( _mutex );
+        if ( _stop || _nextExtent == _extents.size() ) {
+            return false;
+        }
+        *extent = _extents[ _nextExtent++ ];
+        return true;
+    }
+
+    bool ParallelCollectionScan::pushBatch( vector<BSONObj>* batch ) {
+        scoped_lock lk( _mutex );
+        while( _buffer.size() >= MaxBufferedDocs && !_stop ) {
+            _changed.wait( lk.boost() );
+        }
+        if ( _stop ) {
+            return false;
+        }
+        _buffer.insert( _buffer.end(), batch->begin(), batch->end() );
+        batch->clear();
+        _changed.notify_all();
+        return true;
+    }
+
+    void ParallelCollectionScan::waitForChange( scoped_lock& lk ) {
+        _changed.timed_wait( lk.boost(), boost::posix_time::milliseconds( 100 ) );
+        killCurrentOp.checkForInterrupt();
+    }
+
+    void ParallelCollectionScan::checkFailed() const {
+        uassert( 16849, str::stream() << "parallel collection scan failed: " << _errmsg,
+                 _errmsg.empty() );
+    }
+
+    void ParallelCollectionScan::stop() {
+        {
+            scoped_lock lk( _mutex );
+            _stop = true;
+            _changed.notify_all();
+        }
+        _threads.join_all();
+    }
+
+} // namespace mongo
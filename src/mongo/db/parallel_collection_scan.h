@@ -0,0 +1,146 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    class Extent;
+    class NamespaceDetails;
+
+    /**
+     * Scans a collection on several threads at once, for operations over an unindexed query that
+     * need the matching documents in no particular order.
+     *
+     * The collection's extents are handed out to the scanning threads one at a time, and each
+     * thread matches the documents of its extents against a Matcher of its own.  The scanning
+     * threads take no locks: the caller must hold a read lock on the collection from the time the
+     * scan is constructed until it is destroyed, and the scan never yields.
+     *
+     * The matching documents go either to a Sink per thread, which may aggregate them on the
+     * scanning thread for the caller to combine afterwards (see run()), or to a bounded buffer
+     * the caller reads from as they are found (see start() and next()).
+     */
+    class ParallelCollectionScan : boost::noncopyable {
+    public:
+
+        /** Receives the documents matched by one scanning thread. */
+        class Sink {
+        public:
+            virtual ~Sink() {}
+            /**
+             * Called on the scanning thread with each matching document.
+             * @return false to stop this thread's scan.
+             */
+            virtual bool consume( const BSONObj& obj ) = 0;
+            /** Called on the scanning thread once its scan is over. */
+            virtual void done() {}
+        };
+
+        /**
+         * @return the number of threads to scan collection 'd' for 'query' with, or 0 if the
+         * collection should be scanned on the calling thread.  Scans are only parallelized when
+         * the parallelCollectionScanThreads server parameter is set above 1 and the collection
+         * is at least MinParallelDataSize.  Queries with $where need the calling thread's
+         * javascript context and are never parallelized.
+         */
+        static int threadsFor( NamespaceDetails* d, const BSONObj& query );
+
+        /** Smaller collections are not worth starting threads for. */
+        static const long long MinParallelDataSize = 16 * 1024 * 1024;
+
+        /** The most matching documents next() buffers ahead of its caller. */
+        static const size_t MaxBufferedDocs = 10000;
+
+        ParallelCollectionScan( NamespaceDetails* d, const BSONObj& query );
+
+        /** Stops any scanning threads and waits for them. */
+        ~ParallelCollectionScan();
+
+        /**
+         * Scan the whole collection on a thread per sink, passing each thread's matches to its
+         * own sink.  Returns when every thread is done, so the sinks' results may be combined.
+         * Throws if the operation is interrupted or a scanning thread fails.
+         */
+        void run( const std::vector<Sink*>& sinks );
+
+        /** Start scanning the collection on 'nThreads' threads, buffering matches for next(). */
+        void start( int nThreads );
+
+        /**
+         * Waits for a matching document from the scan started by start().  The document points
+         * into the collection and is valid while the read lock is held.
+         * @return false once every document has been returned.  Throws if the operation is
+         * interrupted or a scanning thread fails.
+         */
+        bool next( BSONObj* obj );
+
+        /** @return the number of documents the scanning threads have examined. */
+        long long nscanned() const;
+
+    private:
+        class BufferSink;
+        friend class BufferSink;
+
+        void startThreads( const std::vector<Sink*>& sinks );
+
+        /** Scanning thread body. */
+        void scanThread( Sink* sink );
+
+        /** @return false when no extents are left or the scan is stopping. */
+        bool nextExtent( Extent** extent );
+
+        /**
+         * Add 'batch' to the buffer, waiting for room.
+         * @return false if the scan is stopping.
+         */
+        bool pushBatch( std::vector<BSONObj>* batch );
+
+        /** Wait for a change in the state of the scan, checking for interrupts. */
+        void waitForChange( scoped_lock& lk );
+
+        /** Throw the first failure of a scanning thread, if any. */
+        void checkFailed() const;
+
+        void stop();
+
+        const BSONObj _query;
+        std::vector<Extent*> _extents;
+
+        mutable mongo::mutex _mutex;
+        boost::condition _changed; // Signaled when the buffer or the running threads change.
+        size_t _nextExtent;
+        int _running;
+        long long _nscanned;
+        std::deque<BSONObj> _buffer;
+        OwnedPointerVector<Sink> _bufferSinks;
+        string _errmsg; // The first failure of a scanning thread.
+        volatile bool _stop;
+
+        boost::thread_group _threads;
+    };
+
+} // namespace mongo
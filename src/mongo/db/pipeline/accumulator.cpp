@@ -33,7 +33,38 @@ namespace mongo {
     }
 
     Accumulator::Accumulator():
-        ExpressionNary() {
+        ExpressionNary(),
+        memUsageBytes(0) {
+    }
+
+    void Accumulator::accumulate(AccumulatorState *pState,
+                                 const Document& input) const {
+        verify(false); // only for accumulators with hasInlineState()
+    }
+
+    Value Accumulator::getStateValue(const AccumulatorState& state) const {
+        verify(false); // only for accumulators with hasInlineState()
+    }
+
+    AccumulatorState::AccumulatorState():
+        longTotal(0),
+        doubleTotal(0),
+        count(0),
+        totalType(NumberInt),
+        haveFirst(false) {
+    }
+
+    AccumulatorInline::AccumulatorInline():
+        Accumulator() {
+    }
+
+    Value AccumulatorInline::evaluate(const Document& pDocument) const {
+        accumulate(&state, pDocument);
+        return Value();
+    }
+
+    Value AccumulatorInline::getValue() const {
+        return getStateValue(state);
     }
 
     void Accumulator::opToBson(BSONObjBuilder *pBuilder, StringData opName,
@@ -26,6 +26,24 @@
 namespace mongo {
     class ExpressionContext;
 
+    /*
+      The whole state of an accumulator whose state has a fixed size
+      ($sum, $avg, $min, $max, $first and $last).  $group keeps these in
+      the rows of its hash table rather than allocating an Accumulator
+      for each group; see Accumulator::hasInlineState().
+     */
+    struct AccumulatorState {
+        AccumulatorState();
+
+        Value value; // $min, $max, $first, $last
+        long long longTotal; // $sum, $avg
+        double doubleTotal;
+        // count is only used by AccumulatorAvg, but lives here to avoid counting non-numeric values
+        long long count;
+        BSONType totalType;
+        bool haveFirst; // $first
+    };
+
     class Accumulator :
         public ExpressionNary {
     public:
@@ -43,9 +61,37 @@ namespace mongo {
          */
         virtual Value getValue() const = 0;
 
+        /*
+          Get the approximate amount of memory held by the values collected
+          so far, beyond the accumulator itself.  $group uses this to decide
+          when to spill.
+         */
+        size_t getMemoryUsage() const { return memUsageBytes; }
+
+        /*
+          If this returns true, the accumulator can also work on state kept
+          outside of it, with accumulate() and getStateValue() below, so a
+          single Accumulator can serve any number of groups.
+         */
+        virtual bool hasInlineState() const { return false; }
+
+        /*
+          Like evaluate(), but accumulates into pState rather than this.
+          Only for accumulators with hasInlineState().
+         */
+        virtual void accumulate(AccumulatorState *pState,
+                                const Document& input) const;
+
+        /*
+          Like getValue(), for state built by accumulate().
+         */
+        virtual Value getStateValue(const AccumulatorState& state) const;
+
     protected:
         Accumulator();
 
+        mutable size_t memUsageBytes;
+
         /*
           Convenience method for doing this for accumulators.  The pattern
           is always the same, so a common implementation works, but requires
@@ -87,21 +133,40 @@ namespace mongo {
 
 
     /*
-      This isn't a finished accumulator, but rather a convenient base class
-      for others such as $first, $last, $max, $min, and similar.  It just
-      provides a holder for a single Value, and the getter for that.  The
-      holder is protected so derived classes can manipulate it.
+      A base class for the accumulators with an AccumulatorState.  Derived
+      classes implement accumulate() and getStateValue(); evaluate() and
+      getValue() apply those to the accumulator's own state.
      */
-    class AccumulatorSingleValue :
+    class AccumulatorInline :
         public Accumulator {
     public:
         // virtuals from Expression
+        virtual Value evaluate(const Document& pDocument) const;
+
+        // virtuals from Accumulator
         virtual Value getValue() const;
+        virtual bool hasInlineState() const { return true; }
 
     protected:
-        AccumulatorSingleValue();
+        AccumulatorInline();
 
-        mutable Value pValue; /* current min/max */
+        mutable AccumulatorState state;
+    };
+
+
+    /*
+      This isn't a finished accumulator, but rather a convenient base class
+      for others such as $first, $last, $max, $min, and similar.  It just
+      provides the getter for the single Value they hold in their state.
+     */
+    class AccumulatorSingleValue :
+        public AccumulatorInline {
+    public:
+        // virtuals from Accumulator
+        virtual Value getStateValue(const AccumulatorState& state) const;
+
+    protected:
+        AccumulatorSingleValue();
     };
 
 
@@ -109,9 +174,12 @@ namespace mongo {
         public AccumulatorSingleValue {
     public:
         // virtuals from Expression
-        virtual Value evaluate(const Document& pDocument) const;
         virtual const char *getOpName() const;
 
+        // virtuals from Accumulator
+        virtual void accumulate(AccumulatorState *pState,
+                                const Document& input) const;
+
         /*
           Create the accumulator.
 
@@ -121,7 +189,6 @@ namespace mongo {
             const intrusive_ptr<ExpressionContext> &pCtx);
 
     private:
-        mutable bool _haveFirst;
         AccumulatorFirst();
     };
 
@@ -130,9 +197,12 @@ namespace mongo {
         public AccumulatorSingleValue {
     public:
         // virtuals from Expression
-        virtual Value evaluate(const Document& pDocument) const;
         virtual const char *getOpName() const;
 
+        // virtuals from Accumulator
+        virtual void accumulate(AccumulatorState *pState,
+                                const Document& input) const;
+
         /*
           Create the accumulator.
 
@@ -147,11 +217,12 @@ namespace mongo {
 
 
     class AccumulatorSum :
-        public Accumulator {
+        public AccumulatorInline {
     public:
         // virtuals from Accumulator
-        virtual Value evaluate(const Document& pDocument) const;
-        virtual Value getValue() const;
+        virtual void accumulate(AccumulatorState *pState,
+                                const Document& input) const;
+        virtual Value getStateValue(const AccumulatorState& state) const;
         virtual const char *getOpName() const;
 
         /*
@@ -165,12 +236,6 @@ namespace mongo {
 
     protected: /* reused by AccumulatorAvg */
         AccumulatorSum();
-
-        mutable BSONType totalType;
-        mutable long long longTotal;
-        mutable double doubleTotal;
-        // count is only used by AccumulatorAvg, but lives here to avoid counting non-numeric values
-        mutable long long count;
     };
 
 
@@ -178,9 +243,12 @@ namespace mongo {
         public AccumulatorSingleValue {
     public:
         // virtuals from Expression
-        virtual Value evaluate(const Document& pDocument) const;
         virtual const char *getOpName() const;
 
+        // virtuals from Accumulator
+        virtual void accumulate(AccumulatorState *pState,
+                                const Document& input) const;
+
         /*
           Create either the max or min accumulator.
 
@@ -228,8 +296,9 @@ namespace mongo {
         typedef AccumulatorSum Super;
     public:
         // virtuals from Accumulator
-        virtual Value evaluate(const Document& pDocument) const;
-        virtual Value getValue() const;
+        virtual void accumulate(AccumulatorState *pState,
+                                const Document& input) const;
+        virtual Value getStateValue(const AccumulatorState& state) const;
         virtual const char *getOpName() const;
 
         /*
@@ -26,9 +26,10 @@ namespace mongo {
     const char AccumulatorAvg::subTotalName[] = "subTotal";
     const char AccumulatorAvg::countName[] = "count";
 
-    Value AccumulatorAvg::evaluate(const Document& pDocument) const {
+    void AccumulatorAvg::accumulate(AccumulatorState *pState,
+                                    const Document& input) const {
         if (!pCtx->getDoingMerge()) {
-            Super::evaluate(pDocument);
+            Super::accumulate(pState, input);
         }
         else {
             /*
@@ -36,19 +37,17 @@ namespace mongo {
               both a subtotal and a count.  This is what getValue() produced
               below.
              */
-            Value shardOut = vpOperand[0]->evaluate(pDocument);
+            Value shardOut = vpOperand[0]->evaluate(input);
             verify(shardOut.getType() == Object);
 
             Value subTotal = shardOut[subTotalName];
             verify(!subTotal.missing());
-            doubleTotal += subTotal.getDouble();
+            pState->doubleTotal += subTotal.getDouble();
                 
             Value subCount = shardOut[countName];
             verify(!subCount.missing());
-            count += subCount.getLong();
+            pState->count += subCount.getLong();
         }
-
-        return Value();
     }
 
     intrusive_ptr<Accumulator> AccumulatorAvg::create(
@@ -57,18 +56,18 @@ namespace mongo {
         return pA;
     }
 
-    Value AccumulatorAvg::getValue() const {
+    Value AccumulatorAvg::getStateValue(const AccumulatorState& state) const {
         if (!pCtx->getInShard()) {
             double avg = 0;
-            if (count)
-                avg = doubleTotal / static_cast<double>(count);
+            if (state.count)
+                avg = state.doubleTotal / static_cast<double>(state.count);
 
             return Value::createDouble(avg);
         }
 
         MutableDocument out;
-        out.addField(subTotalName, Value::createDouble(doubleTotal));
-        out.addField(countName, Value::createLong(count));
+        out.addField(subTotalName, Value::createDouble(state.doubleTotal));
+        out.addField(countName, Value::createLong(state.count));
 
         return Value::createDocument(out.freeze());
     }
@@ -21,22 +21,20 @@
 
 namespace mongo {
 
-    Value AccumulatorFirst::evaluate(const Document& pDocument) const {
+    void AccumulatorFirst::accumulate(AccumulatorState *pState,
+                                      const Document& input) const {
         verify(vpOperand.size() == 1);
 
         /* only remember the first value seen */
-        if (!_haveFirst) {
-            // can't use pValue.missing() since we want the first value even if missing
-            _haveFirst = true;
-            pValue = vpOperand[0]->evaluate(pDocument);
+        if (!pState->haveFirst) {
+            // can't use value.missing() since we want the first value even if missing
+            pState->haveFirst = true;
+            pState->value = vpOperand[0]->evaluate(input);
         }
-
-        return pValue;
     }
 
     AccumulatorFirst::AccumulatorFirst()
         : AccumulatorSingleValue()
-        , _haveFirst(false)
     {}
 
     intrusive_ptr<Accumulator> AccumulatorFirst::create(
@@ -21,13 +21,12 @@
 
 namespace mongo {
 
-    Value AccumulatorLast::evaluate(const Document& pDocument) const {
+    void AccumulatorLast::accumulate(AccumulatorState *pState,
+                                     const Document& input) const {
         verify(vpOperand.size() == 1);
 
         /* always remember the last value seen */
-        pValue = vpOperand[0]->evaluate(pDocument);
-
-        return pValue;
+        pState->value = vpOperand[0]->evaluate(input);
     }
 
     AccumulatorLast::AccumulatorLast():
@@ -21,19 +21,18 @@
 
 namespace mongo {
 
-    Value AccumulatorMinMax::evaluate(const Document& pDocument) const {
+    void AccumulatorMinMax::accumulate(AccumulatorState *pState,
+                                       const Document& input) const {
         verify(vpOperand.size() == 1);
-        Value prhs(vpOperand[0]->evaluate(pDocument));
+        Value prhs(vpOperand[0]->evaluate(input));
 
         // nullish values should have no impact on result
         if (!prhs.nullish()) {
             /* compare with the current value; swap if appropriate */
-            int cmp = Value::compare(pValue, prhs) * sense;
-            if (cmp > 0 || pValue.missing()) // missing is lower than all other values
-                pValue = prhs;
+            int cmp = Value::compare(pState->value, prhs) * sense;
+            if (cmp > 0 || pState->value.missing()) // missing is lower than all other values
+                pState->value = prhs;
         }
-
-        return Value();
     }
 
     AccumulatorMinMax::AccumulatorMinMax(int theSense):
@@ -21,12 +21,12 @@
 
 namespace mongo {
 
-    Value AccumulatorSingleValue::getValue() const {
-        return pValue;
+    Value AccumulatorSingleValue::getStateValue(const AccumulatorState& state) const {
+        return state.value;
     }
 
     AccumulatorSingleValue::AccumulatorSingleValue():
-        pValue(Value()) {
+        AccumulatorInline() {
     }
 
 }
@@ -21,34 +21,33 @@
 
 namespace mongo {
 
-    Value AccumulatorSum::evaluate(const Document& pDocument) const {
+    void AccumulatorSum::accumulate(AccumulatorState *pState,
+                                    const Document& input) const {
         verify(vpOperand.size() == 1);
-        Value rhs = vpOperand[0]->evaluate(pDocument);
+        Value rhs = vpOperand[0]->evaluate(input);
 
         // do nothing with non numeric types
         if (!rhs.numeric())
-            return Value();
+            return;
 
         // upgrade to the widest type required to hold the result
-        totalType = Value::getWidestNumeric(totalType, rhs.getType());
+        pState->totalType = Value::getWidestNumeric(pState->totalType, rhs.getType());
 
-        if (totalType == NumberInt || totalType == NumberLong) {
+        if (pState->totalType == NumberInt || pState->totalType == NumberLong) {
             long long v = rhs.coerceToLong();
-            longTotal += v;
-            doubleTotal += v;
+            pState->longTotal += v;
+            pState->doubleTotal += v;
         }
-        else if (totalType == NumberDouble) {
+        else if (pState->totalType == NumberDouble) {
             double v = rhs.coerceToDouble();
-            doubleTotal += v;
+            pState->doubleTotal += v;
         }
         else {
             // non numerics should have returned above so we should never get here
             verify(false);
         }
 
-        count++;
-
-        return Value();
+        pState->count++;
     }
 
     intrusive_ptr<Accumulator> AccumulatorSum::create(
@@ -57,15 +56,15 @@ namespace mongo {
         return pSummer;
     }
 
-    Value AccumulatorSum::getValue() const {
-        if (totalType == NumberLong) {
-            return Value::createLong(longTotal);
+    Value AccumulatorSum::getStateValue(const AccumulatorState& state) const {
+        if (state.totalType == NumberLong) {
+            return Value::createLong(state.longTotal);
         }
-        else if (totalType == NumberDouble) {
-            return Value::createDouble(doubleTotal);
+        else if (state.totalType == NumberDouble) {
+            return Value::createDouble(state.doubleTotal);
         }
-        else if (totalType == NumberInt) {
-            return Value::createIntOrLong(longTotal);
+        else if (state.totalType == NumberInt) {
+            return Value::createIntOrLong(state.longTotal);
         }
         else {
             massert(16000, "$sum resulted in a non-numeric type", false);
@@ -73,11 +72,7 @@ namespace mongo {
     }
 
     AccumulatorSum::AccumulatorSum():
-        Accumulator(),
-        totalType(NumberInt),
-        longTotal(0),
-        doubleTotal(0),
-        count(0) {
+        AccumulatorInline() {
     }
 
     const char *AccumulatorSum::getOpName() const {
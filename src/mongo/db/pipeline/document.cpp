@@ -27,6 +27,203 @@
 namespace mongo {
     using namespace mongoutils;
 
+    /** The state of a lazy DocumentStorage (see Document::fromBsonLazy()).
+     *
+     *  The first lookup indexes where each field of bson starts.  Fields are then converted
+     *  to Values one at a time as they are looked up, and remembered here until
+     *  DocumentStorage::loadLazyFields() moves all of them into the storage proper.
+     *
+     *  bson is owned by this storage alone: a lazy sub-document gets its own copy of its
+     *  bytes, so that it neither keeps its parent's BSON alive nor hides it from
+     *  Document::getApproximateSize().
+     */
+    struct LazyBson {
+        struct Field {
+            const char* element; // in bson
+            int nameLen;
+            bool loaded;
+            Value value; // only if loaded
+        };
+
+        LazyBson() :indexed(false), hashTabMask(0) {}
+
+        void buildIndex();
+
+        /// Index into fields of the first field with this name, or -1.
+        int find(StringData name) const;
+
+        BSONObj bson; // owned
+
+        bool indexed;
+        vector<Field> fields; // in order
+        vector<int> hashTab; // only for larger documents
+        unsigned hashTabMask;
+
+        enum { HASH_TAB_MIN = 8 }; // scan smaller documents
+    };
+
+    namespace {
+        unsigned hashFieldName(const char* name, int len) {
+            unsigned out;
+            MurmurHash3_x86_32(name, len, 0, &out);
+            return out;
+        }
+
+        Document lazyDocument(const BSONObj& bson) {
+            intrusive_ptr<DocumentStorage> storage (new DocumentStorage);
+            storage->makeLazy(bson);
+            return Document(storage.get());
+        }
+
+        Value lazyValue(const BSONElement& elem);
+
+        Value lazyArray(const BSONObj& array) {
+            vector<Value> values;
+            BSONForEach(elem, array) {
+                values.push_back(lazyValue(elem));
+            }
+            return Value(values);
+        }
+
+        Value lazyValue(const BSONElement& elem) {
+            switch (elem.type()) {
+            case Object:
+                // copied, so the sub-document doesn't pin the whole of its parent
+                return Value(lazyDocument(elem.embeddedObject().getOwned()));
+            case Array:
+                return lazyArray(elem.embeddedObject());
+            default:
+                return Value(elem);
+            }
+        }
+    }
+
+    void LazyBson::buildIndex() {
+        BSONObjIterator it(bson);
+        while (it.more()) {
+            BSONElement elem = it.next();
+            Field field;
+            field.element = elem.rawdata();
+            field.nameLen = elem.fieldNameSize() - 1;
+            field.loaded = false;
+            fields.push_back(field);
+        }
+
+        if (fields.size() >= HASH_TAB_MIN) {
+            unsigned buckets = HASH_TAB_MIN;
+            while (buckets < fields.size() * 2)
+                buckets *= 2;
+            hashTabMask = buckets - 1;
+            hashTab.assign(buckets, -1);
+
+            // insert in order with linear probing: a field with a duplicate name probes past
+            // the earlier one, so lookups find the first of duplicate names
+            for (size_t i = 0; i < fields.size(); i++) {
+                const char* name = fields[i].element + 1;
+                unsigned bucket = hashFieldName(name, fields[i].nameLen) & hashTabMask;
+                while (hashTab[bucket] != -1)
+                    bucket = (bucket + 1) & hashTabMask;
+                hashTab[bucket] = i;
+            }
+        }
+
+        indexed = true;
+    }
+
+    int LazyBson::find(StringData name) const {
+        const int nameLen = name.size();
+
+        if (hashTab.empty()) {
+            for (size_t i = 0; i < fields.size(); i++) {
+                if (fields[i].nameLen == nameLen
+                    && memcmp(name.rawData(), fields[i].element + 1, nameLen) == 0) {
+                    return i;
+                }
+            }
+            return -1;
+        }
+
+        unsigned bucket = hashFieldName(name.rawData(), nameLen) & hashTabMask;
+        for (int i = hashTab[bucket]; i != -1; i = hashTab[bucket]) {
+            if (fields[i].nameLen == nameLen
+                && memcmp(name.rawData(), fields[i].element + 1, nameLen) == 0) {
+                return i;
+            }
+            bucket = (bucket + 1) & hashTabMask;
+        }
+        return -1;
+    }
+
+    void DocumentStorage::makeLazy(const BSONObj& bson) {
+        verify(!_buffer && !_lazy);
+        dassert(bson.isOwned());
+
+        _lazy = new LazyBson;
+        _lazy->bson = bson;
+        _lazyFieldsPending = true;
+    }
+
+    Value DocumentStorage::getLazyField(StringData name) const {
+        LazyBson& lazy = *_lazy;
+        if (!lazy.indexed)
+            lazy.buildIndex();
+
+        const int i = lazy.find(name);
+        if (i < 0)
+            return Value();
+
+        LazyBson::Field& field = lazy.fields[i];
+        if (!field.loaded) {
+            field.value = lazyValue(BSONElement(field.element));
+            field.loaded = true;
+        }
+        return field.value;
+    }
+
+    void DocumentStorage::loadLazyFieldsSlow() {
+        LazyBson& lazy = *_lazy;
+        _lazyFieldsPending = false;
+
+        if (lazy.indexed) {
+            if (lazy.fields.size())
+                reserveFields(lazy.fields.size());
+
+            for (size_t i = 0; i < lazy.fields.size(); i++) {
+                const LazyBson::Field& field = lazy.fields[i];
+                appendField(StringData(field.element + 1, field.nameLen)) =
+                    field.loaded ? field.value : lazyValue(BSONElement(field.element));
+            }
+
+            vector<LazyBson::Field>().swap(lazy.fields);
+            vector<int>().swap(lazy.hashTab);
+            lazy.indexed = false;
+        }
+        else {
+            BSONForEach(elem, lazy.bson) {
+                appendField(StringData(elem.fieldName(), elem.fieldNameSize()-1)) =
+                    lazyValue(elem);
+            }
+        }
+    }
+
+    void DocumentStorage::dropLazyBson() {
+        loadLazyFields();
+        delete _lazy;
+        _lazy = NULL;
+    }
+
+    bool DocumentStorage::appendUnmodifiedBson(BSONObjBuilder* pBuilder) const {
+        if (!_lazy)
+            return false;
+
+        pBuilder->appendElements(_lazy->bson);
+        return true;
+    }
+
+    size_t DocumentStorage::lazyBsonBytes() const {
+        return _lazy ? _lazy->bson.objsize() : 0;
+    }
+
     Position DocumentStorage::findField(StringData requested) const {
         int reqSize = requested.size(); // get size calculation out of the way if needed
 
@@ -170,6 +367,8 @@ namespace mongo {
     }
 
     intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
+        loadLazyFields();
+
         intrusive_ptr<DocumentStorage> out (new DocumentStorage());
 
         // Make a copy of the buffer.
@@ -194,6 +393,7 @@ namespace mongo {
 
     DocumentStorage::~DocumentStorage() {
         boost::scoped_array<char> deleteBufferAtScopeEnd (_buffer);
+        delete _lazy;
 
         for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
             it->val.~Value(); // explicit destructor call
@@ -212,6 +412,10 @@ namespace mongo {
         *this = md.freeze();
     }
 
+    Document Document::fromBsonLazy(const BSONObj& bson) {
+        return lazyDocument(bson);
+    }
+
     BSONObjBuilder& operator << (BSONObjBuilderValueStream& builder, const Document& doc) {
         BSONObjBuilder subobj(builder.subobjStart());
         doc.toBson(&subobj);
@@ -220,6 +424,9 @@ namespace mongo {
     }
 
     void Document::toBson(BSONObjBuilder* pBuilder) const {
+        if (lazyStorage().appendUnmodifiedBson(pBuilder))
+            return;
+
         for (DocumentStorageIterator it = storage().iterator(); !it.atEnd(); it.advance()) {
             *pBuilder << it->nameSD() << it->val;
         }
@@ -296,12 +503,23 @@ namespace mongo {
         return getNestedFieldHelper(*this, fieldNames, positions, 0);
     }
 
+    void Document::serializeForSorter(BufBuilder& buf) const {
+        BSONObjBuilder bob;
+        toBson(&bob);
+        bob.done().serializeForSorter(buf);
+    }
+
+    Document Document::deserializeForSorter(BufReader& buf, const SorterDeserializeSettings&) {
+        return Document(BSONObj::deserializeForSorter(buf, BSONObj::SorterDeserializeSettings()));
+    }
+
     size_t Document::getApproximateSize() const {
         if (!_storage)
             return 0; // we've allocated no memory
 
         size_t size = sizeof(DocumentStorage);
         size += storage().allocatedBytes();
+        size += storage().lazyBsonBytes();
 
         for (DocumentStorageIterator it = storage().iterator(); !it.atEnd(); it.advance()) {
             size += it->val.getApproximateSize();
@@ -59,11 +59,26 @@ namespace mongo {
         /// Create a new Document deep-converted from the given BSONObj.
         explicit Document(const BSONObj& bson);
 
+        /** Create a Document that keeps bson and only converts a field to a Value when it is
+         *  looked up by name.  An index of where each field starts is built on the first
+         *  lookup.  Sub-documents are lazy as well, and as long as it isn't modified the
+         *  Document is written back out (toBson) by copying the original BSON.
+         *
+         *  Anything that needs the fields in order, such as iterating, comparing or
+         *  getting a Position, converts all of them first.
+         *
+         *  Sub-documents copy their own part of bson when they are looked up, so a Value
+         *  taken from one doesn't keep the rest of bson alive.
+         *
+         *  @param bson must be owned (see BSONObj::getOwned()); the Document keeps a reference
+         */
+        static Document fromBsonLazy(const BSONObj& bson);
+
         void swap(Document& rhs) { _storage.swap(rhs._storage); }
 
         /// Look up a field by key name. Returns Value() if no such field. O(1)
         const Value operator[] (StringData key) const { return getField(key); }
-        const Value getField(StringData key) const { return storage().getField(key); }
+        const Value getField(StringData key) const { return lazyStorage().getField(key); }
 
         /// Look up a field by Position. See positionOf and getNestedField.
         const Value operator[] (Position pos) const { return getField(pos); }
@@ -124,6 +139,13 @@ namespace mongo {
         /// Add this document to the BSONObj under construction with the given BSONObjBuilder.
         void toBson(BSONObjBuilder *pBsonObjBuilder) const;
 
+        /// members for Sorter
+        struct SorterDeserializeSettings {}; // unused
+        void serializeForSorter(BufBuilder& buf) const;
+        static Document deserializeForSorter(BufReader& buf, const SorterDeserializeSettings&);
+        int memUsageForSorter() const { return getApproximateSize(); }
+        Document getOwned() const { return *this; }
+
         // Support BSONObjBuilder and BSONArrayBuilder "stream" API
         friend BSONObjBuilder& operator << (BSONObjBuilderValueStream& builder, const Document& d);
 
@@ -164,6 +186,13 @@ namespace mongo {
         friend class MutableDocument;
 
         const DocumentStorage& storage() const {
+            const DocumentStorage& s = lazyStorage();
+            s.loadLazyFields();
+            return s;
+        }
+
+        /// Storage whose fields may not be loaded yet. Only getField(StringData) works on it.
+        const DocumentStorage& lazyStorage() const {
             return (_storage ? *_storage : DocumentStorage::emptyDoc());
         }
         intrusive_ptr<const DocumentStorage> _storage;
@@ -348,7 +377,9 @@ namespace mongo {
                 return clonedStorage();
 
             // This function exists to ensure this is safe
-            return const_cast<DocumentStorage&>(*storagePtr());
+            DocumentStorage& ds = const_cast<DocumentStorage&>(*storagePtr());
+            ds.prepareForWrite();
+            return ds;
         }
         DocumentStorage& newStorage() {
             reset(new DocumentStorage);
@@ -22,6 +22,11 @@
 #include "mongo/db/pipeline/value.h"
 
 namespace mongo {
+    class BSONObj;
+    class BSONObjBuilder;
+    class Document;
+    struct LazyBson;
+
     /** Helper class to make the position in a document abstract
      *  Warning: This is NOT guaranteed to be the ordered position.
      *           eg. the first field may not be at Position(0)
@@ -154,6 +159,8 @@ namespace mongo {
                           , _usedBytes(0)
                           , _numFields(0)
                           , _hashTabMask(0)
+                          , _lazy(NULL)
+                          , _lazyFieldsPending(false)
         {}
         ~DocumentStorage();
 
@@ -182,6 +189,9 @@ namespace mongo {
             return *(_firstElement->plusBytes(pos.index));
         }
         Value getField(StringData name) const {
+            if (MONGO_unlikely( _lazyFieldsPending ))
+                return getLazyField(name);
+
             Position pos = findField(name);
             if (!pos.found())
                 return Value();
@@ -221,12 +231,46 @@ namespace mongo {
         /// Shallow copy of this. Caller owns memory.
         intrusive_ptr<DocumentStorage> clone() const;
 
+        /** Make this empty storage a view of bson whose fields are only converted to Values
+         *  as they are asked for.  See Document::fromBsonLazy().
+         *
+         *  @param bson must be owned; this storage keeps a reference
+         */
+        void makeLazy(const BSONObj& bson);
+
+        /** Until this is called, a lazy storage's fields may only be read with
+         *  getField(StringData).  Everything that needs the fields in order or their
+         *  Positions calls this first; it converts all the remaining fields.
+         */
+        void loadLazyFields() const {
+            if (MONGO_unlikely( _lazyFieldsPending ))
+                const_cast<DocumentStorage*>(this)->loadLazyFieldsSlow();
+        }
+
+        /// Call before modifying: after a change the original BSON no longer matches.
+        void prepareForWrite() {
+            if (MONGO_unlikely( _lazy != NULL ))
+                dropLazyBson();
+        }
+
+        /** If this is still an unmodified view of a BSONObj, append that object's elements
+         *  to pBuilder as they are and return true.
+         */
+        bool appendUnmodifiedBson(BSONObjBuilder* pBuilder) const;
+
+        /// bytes of BSON held by this storage
+        size_t lazyBsonBytes() const;
+
         size_t allocatedBytes() const {
             return !_buffer ? 0 : (_bufferEnd - _buffer + hashTabBytes());
         }
 
     private:
 
+        Value getLazyField(StringData name) const;
+        void loadLazyFieldsSlow();
+        void dropLazyBson();
+
         /// Same as lastElement->next() or firstElement() if empty.
         const ValueElement* end() const { return _firstElement->plusBytes(_usedBytes); }
 
@@ -293,6 +337,12 @@ namespace mongo {
         unsigned _usedBytes; // position where next field would start
         unsigned _numFields; // this includes removed fields
         unsigned _hashTabMask; // equal to hashTabBuckets()-1 but used more often
+
+        // Set by makeLazy(): the BSON we came from, and the fields looked up in it so far.
+        // Loading fields lazily changes a storage that is logically const, so like the rest
+        // of Document this must not be shared between threads.
+        LazyBson* _lazy;
+        bool _lazyFieldsPending; // some fields are still only in _lazy's BSON
         // When adding a field, make sure to update clone() method
     };
 }
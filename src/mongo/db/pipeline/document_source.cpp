@@ -18,9 +18,32 @@
 
 #include "db/pipeline/document_source.h"
 #include "db/pipeline/expression_context.h"
+#include "mongo/db/server_parameters.h"
 
 namespace mongo {
 
+    int aggregationMaxMemoryUsageBytes = 100*1024*1024;
+
+    namespace {
+        /** The limit must be positive: 0 would spill every document, and a negative limit none. */
+        class AggregationMaxMemoryUsageBytesParameter : public ExportedServerParameter<int> {
+        public:
+            AggregationMaxMemoryUsageBytesParameter()
+                : ExportedServerParameter<int>(ServerParameterSet::getGlobal(),
+                                               "aggregationMaxMemoryUsageBytes",
+                                               &aggregationMaxMemoryUsageBytes, true, true) {
+            }
+
+            virtual Status validate(const int& potentialNewValue) {
+                if (potentialNewValue <= 0) {
+                    return Status(ErrorCodes::BadValue,
+                                  "aggregationMaxMemoryUsageBytes must be greater than 0");
+                }
+                return Status::OK();
+            }
+        } aggregationMaxMemoryUsageBytesParameter;
+    }
+
     DocumentSource::DocumentSource(
         const intrusive_ptr<ExpressionContext> &pCtx):
         pSource(NULL),
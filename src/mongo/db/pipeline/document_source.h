@@ -23,6 +23,7 @@
 #include "db/clientcursor.h"
 #include "db/jsobj.h"
 #include "db/matcher.h"
+#include "mongo/db/parallel_collection_scan.h"
 #include "db/pipeline/document.h"
 #include "db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
@@ -40,6 +41,15 @@ namespace mongo {
     class ExpressionFieldPath;
     class ExpressionObject;
     class DocumentSourceLimit;
+    class GroupTable;
+    template <typename Key, typename Value> class SortIteratorInterface;
+
+    /*
+      With allowDiskUse, $sort and $group write what they hold to disk once
+      it takes more than this many bytes.  Settable as the
+      aggregationMaxMemoryUsageBytes server parameter.
+     */
+    extern int aggregationMaxMemoryUsageBytes;
 
     class DocumentSource :
         public IntrusiveCounterUnsigned,
@@ -380,6 +390,9 @@ namespace mongo {
             Client::ReadContext _readContext;
             shared_ptr<ShardChunkManager> _chunkMgr;
             ClientCursor::Holder _cursor;
+            // If set, documents come from this scan rather than from _cursor.  The scan is
+            // stopped before the read lock is released.
+            scoped_ptr<ParallelCollectionScan> _parallelScan;
         };
 
         // virtuals from DocumentSource
@@ -454,6 +467,9 @@ namespace mongo {
 
         void findNext();
 
+        /** @return the document to return for 'next', a matching document. */
+        Document documentFromBson(const BSONObj& next);
+
         bool unstarted;
         bool hasCurrent;
         Document pCurrent;
@@ -689,9 +705,11 @@ namespace mongo {
 
         intrusive_ptr<Expression> pIdExpression;
 
-        typedef boost::unordered_map<Value,
-            vector<intrusive_ptr<Accumulator> >, Value::Hash> GroupsType;
-        GroupsType groups;
+        /*
+          The groups, by _id.  Created by populate() once we know how wide
+          the rows are.
+         */
+        boost::scoped_ptr<GroupTable> groups;
 
         /*
           The field names for the result documents and the accumulator
@@ -710,10 +728,60 @@ namespace mongo {
             const intrusive_ptr<ExpressionContext> &)> vpAccumulatorFactory;
         vector<intrusive_ptr<Expression> > vpExpression;
 
+        /*
+          Where each field's accumulator lives, also parallel to the above.
+
+          If a field's accumulator hasInlineState(), vpInlineAccumulator
+          has the one Accumulator for it, which works on the
+          AccumulatorState at index vAccumulatorIndex in each group's row.
+
+          Otherwise each group has its own Accumulator for the field, at
+          index vAccumulatorIndex among the group's nGroupAccumulators
+          accumulators in groupAccumulators.
+         */
+        vector<intrusive_ptr<Accumulator> > vpInlineAccumulator;
+        vector<size_t> vAccumulatorIndex;
+        size_t nGroupAccumulators;
+        deque<intrusive_ptr<Accumulator> > groupAccumulators;
+
+        /* the value of field i for the group in row */
+        Value getAccumulatedValue(size_t row, size_t i);
+
+        Document makeDocument(size_t row);
+        Document makeDocument(const Value& id,
+                              const vector<intrusive_ptr<Accumulator> >& accumulators);
 
-        Document makeDocument(const GroupsType::iterator &rIter);
+        size_t groupsRow; // the next group to return
 
-        GroupsType::iterator groupsIterator;
+        /*
+          With allowDiskUse, once the groups take more than
+          aggregationMaxMemoryUsageBytes
+          they are written out as a sorted run of partial results (what a shard
+          would send the router), and populating starts over with no groups.
+          At the end the runs are merged by _id, and the partial results for
+          each _id are combined by a second set of accumulators, as the router
+          does.
+
+          The accumulators are made with pSpillCtx, a copy of pExpCtx that we
+          switch to shard mode while spilling so getValue() returns partial
+          results.  The merging accumulators are made with pMergeCtx, which is
+          in merge mode.
+         */
+        void spill();
+        bool mergeNext(); // sets spilledCurrent to the next merged group
+
+        intrusive_ptr<ExpressionContext> pSpillCtx;
+        intrusive_ptr<ExpressionContext> pMergeCtx;
+        vector<intrusive_ptr<Expression> > vpMergeExpression;
+        size_t memoryUsageBytes;
+
+        typedef SortIteratorInterface<Value, Document> SpillIterator;
+        vector<boost::shared_ptr<SpillIterator> > spilledRuns;
+        boost::scoped_ptr<SpillIterator> spilledGroups; // the runs merged
+        pair<Value, Document> nextPartial; // read ahead from spilledGroups
+        bool haveNextPartial;
+        Document spilledCurrent;
+        bool spilledEof;
     };
 
 
@@ -918,6 +986,20 @@ namespace mongo {
 
         intrusive_ptr<DocumentSourceLimit> getLimitSrc() const { return limitSrc; }
 
+        /**
+          Orders (key, document) pairs for the Sorter the way $sort orders
+          documents.  If there is more than one sort field the key is an array
+          with one element per field.
+         */
+        class KeyComparator {
+        public:
+            explicit KeyComparator(const vector<char>& ascending): _ascending(ascending) {}
+            int operator()(const pair<Value, Document>& lhs,
+                           const pair<Value, Document>& rhs) const;
+        private:
+            vector<char> _ascending;
+        };
+
         static const char sortName[];
     protected:
         // virtuals from DocumentSource
@@ -949,6 +1031,7 @@ namespace mongo {
 
         struct KeyAndDoc {
             explicit KeyAndDoc(const Document& d, const SortPaths& sp); // extracts sort key
+            KeyAndDoc(const Value& k, const Document& d) : key(k), doc(d) {}
             Value key; // array of keys if vSortKey.size() > 1
             Document doc;
         };
@@ -973,6 +1056,14 @@ namespace mongo {
 
         deque<KeyAndDoc> documents;
 
+        /*
+          With allowDiskUse, populateAll() hands the documents to a Sorter
+          that may spill them to disk.  Its output is then read one document
+          at a time into documents.
+         */
+        void populateAllExternal();
+        boost::scoped_ptr<SortIteratorInterface<Value, Document> > sortedOutput;
+
         intrusive_ptr<DocumentSourceLimit> limitSrc;
     };
     inline void swap(DocumentSourceSort::KeyAndDoc& l, DocumentSourceSort::KeyAndDoc& r) {
@@ -104,6 +104,23 @@ namespace mongo {
             return;
         }
 
+        if ( _cursorWithContext->_parallelScan ) {
+            BSONObj next;
+            while ( _cursorWithContext->_parallelScan->next( &next ) ) {
+                if (chunkMgr() && ! chunkMgr()->belongsToMe(next))
+                    continue;
+
+                pCurrent = documentFromBson(next);
+                hasCurrent = true;
+                return;
+            }
+
+            dispose();
+            pCurrent = Document();
+            hasCurrent = false;
+            return;
+        }
+
         for( ; cursor()->ok(); cursor()->advance() ) {
 
             yieldSometimes();
@@ -129,37 +146,7 @@ namespace mongo {
                 if (chunkMgr() && ! chunkMgr()->belongsToMe(next))
                     continue;
 
-                if (!_projection) {
-                    pCurrent = Document(next);
-                }
-                else {
-                    pCurrent = documentFromBsonWithDeps(next, _dependencies);
-
-                    if (debug && !_dependencies.empty()) {
-                        // Make sure we behave the same as Projection.  Projection doesn't have a
-                        // way to specify "no fields needed" so we skip the test in that case.
-
-                        MutableDocument byAggo(pCurrent);
-                        MutableDocument byProj(Document(_projection->transform(next)));
-
-                        if (_dependencies["_id"].getType() == Object) {
-                            // We handle subfields of _id identically to other fields.
-                            // Projection doesn't handle them correctly.
-
-                            byAggo.remove("_id");
-                            byProj.remove("_id");
-                        }
-
-                        if (Document::compare(byAggo.peek(), byProj.peek()) != 0) {
-                            PRINT(next);
-                            PRINT(_dependencies);
-                            PRINT(_projection->getSpec());
-                            PRINT(byAggo.peek());
-                            PRINT(byProj.peek());
-                            verify(false);
-                        }
-                    }
-                }
+                pCurrent = documentFromBson(next);
             }
 
             hasCurrent = true;
@@ -175,6 +162,40 @@ namespace mongo {
         hasCurrent = false;
     }
 
+    Document DocumentSourceCursor::documentFromBson(const BSONObj& next) {
+        if (!_projection)
+            return Document::fromBsonLazy(next.getOwned());
+
+        Document doc = documentFromBsonWithDeps(next, _dependencies);
+
+        if (debug && !_dependencies.empty()) {
+            // Make sure we behave the same as Projection.  Projection doesn't have a
+            // way to specify "no fields needed" so we skip the test in that case.
+
+            MutableDocument byAggo(doc);
+            MutableDocument byProj(Document(_projection->transform(next)));
+
+            if (_dependencies["_id"].getType() == Object) {
+                // We handle subfields of _id identically to other fields.
+                // Projection doesn't handle them correctly.
+
+                byAggo.remove("_id");
+                byProj.remove("_id");
+            }
+
+            if (Document::compare(byAggo.peek(), byProj.peek()) != 0) {
+                PRINT(next);
+                PRINT(_dependencies);
+                PRINT(_projection->getSpec());
+                PRINT(byAggo.peek());
+                PRINT(byProj.peek());
+                verify(false);
+            }
+        }
+
+        return doc;
+    }
+
     void DocumentSourceCursor::setSource(DocumentSource *pSource) {
         /* this doesn't take a source */
         verify(false);
@@ -23,11 +23,34 @@
 #include "db/pipeline/document.h"
 #include "db/pipeline/expression.h"
 #include "db/pipeline/expression_context.h"
+#include "db/pipeline/group_table.h"
 #include "db/pipeline/value.h"
+#include "mongo/db/sorter/sorter.h"
 
 namespace mongo {
     const char DocumentSourceGroup::groupName[] = "$group";
 
+    namespace {
+        // rough cost of a group's accumulator, on top of what it has collected
+        const size_t accumulatorOverheadBytes = 64;
+
+        // how many input documents populate() hashes at a time
+        const size_t batchSize = 64;
+
+        struct GroupIdLess {
+            explicit GroupIdLess(const GroupTable& theGroups): groups(theGroups) {}
+            bool operator()(size_t lhs, size_t rhs) const {
+                return Value::compare(groups.getKey(lhs), groups.getKey(rhs)) < 0;
+            }
+            const GroupTable& groups;
+        };
+
+        // we return null rather than missing so return objects are predictable
+        Value nullIfMissing(const Value& value) {
+            return value.missing() ? Value(BSONNULL) : value;
+        }
+    }
+
     DocumentSourceGroup::~DocumentSourceGroup() {
     }
 
@@ -39,7 +62,10 @@ namespace mongo {
         if (!populated)
             populate();
 
-        return (groupsIterator == groups.end());
+        if (spilledGroups)
+            return spilledEof;
+
+        return (groupsRow == groups->size());
     }
 
     bool DocumentSourceGroup::advance() {
@@ -48,10 +74,20 @@ namespace mongo {
         if (!populated)
             populate();
 
-        verify(groupsIterator != groups.end());
+        if (spilledGroups) {
+            verify(!spilledEof);
+            spilledEof = !mergeNext();
+            if (spilledEof) {
+                dispose();
+                return false;
+            }
+            return true;
+        }
 
-        ++groupsIterator;
-        if (groupsIterator == groups.end()) {
+        verify(groupsRow < groups->size());
+
+        ++groupsRow;
+        if (groupsRow == groups->size()) {
             dispose();
             return false;
         }
@@ -63,12 +99,23 @@ namespace mongo {
         if (!populated)
             populate();
 
-        return makeDocument(groupsIterator);
+        if (spilledGroups)
+            return spilledCurrent;
+
+        return makeDocument(groupsRow);
     }
 
     void DocumentSourceGroup::dispose() {
-        GroupsType().swap(groups);
-        groupsIterator = groups.end();
+        if (groups)
+            groups->clear();
+        groupAccumulators.clear();
+        groupsRow = 0;
+
+        spilledGroups.reset();
+        spilledRuns.clear();
+        haveNextPartial = false;
+        nextPartial = pair<Value, Document>();
+        spilledCurrent = Document();
 
         pSource->dispose();
     }
@@ -121,7 +168,12 @@ namespace mongo {
         groups(),
         vFieldName(),
         vpAccumulatorFactory(),
-        vpExpression() {
+        vpExpression(),
+        nGroupAccumulators(0),
+        groupsRow(0),
+        memoryUsageBytes(0),
+        haveNextPartial(false),
+        spilledEof(false) {
     }
 
     void DocumentSourceGroup::addAccumulator(
@@ -290,66 +342,224 @@ namespace mongo {
         const size_t numAccumulators = vpAccumulatorFactory.size();
         dassert(numAccumulators == vpExpression.size());
 
-        for (bool hasNext = !pSource->eof(); hasNext; hasNext = pSource->advance()) {
-            Document input  = pSource->getCurrent();
-
-            /* get the _id value */
-            Value id = pIdExpression->evaluate(input);
+        /* mongos has nowhere to spill to */
+        const bool canSpill = pExpCtx->getExtSortAllowed() && !pExpCtx->getInRouter();
+        if (canSpill) {
+            pSpillCtx = pExpCtx->clone();
+            pMergeCtx = pExpCtx->clone();
+            pMergeCtx->setDoingMerge(true);
+        }
+        const intrusive_ptr<ExpressionContext>& pAccumCtx = canSpill ? pSpillCtx : pExpCtx;
+
+        /*
+          One Accumulator serves every group for each field whose state
+          fits in an AccumulatorState; only the others need one per group.
+         */
+        size_t nInline = 0;
+        nGroupAccumulators = 0;
+        vpInlineAccumulator.assign(numAccumulators, intrusive_ptr<Accumulator>());
+        vAccumulatorIndex.resize(numAccumulators);
+        for (size_t i = 0; i < numAccumulators; i++) {
+            intrusive_ptr<Accumulator> accum = (*vpAccumulatorFactory[i])(pAccumCtx);
+            if (accum->hasInlineState()) {
+                accum->addOperand(vpExpression[i]);
+                vpInlineAccumulator[i] = accum;
+                vAccumulatorIndex[i] = nInline++;
+            }
+            else {
+                vAccumulatorIndex[i] = nGroupAccumulators++;
+            }
+        }
+        groups.reset(new GroupTable(nInline));
+
+        const size_t newGroupBytes = nInline * sizeof(AccumulatorState)
+                                   + nGroupAccumulators * accumulatorOverheadBytes;
+
+        vector<Document> inputs;
+        vector<Value> ids;
+        vector<size_t> hashes;
+        inputs.reserve(batchSize);
+        ids.reserve(batchSize);
+        hashes.reserve(batchSize);
+
+        bool hasNext = !pSource->eof();
+        while (hasNext) {
+            /* get a batch of documents and their _id values */
+            inputs.clear();
+            ids.clear();
+            for (; hasNext && inputs.size() < batchSize; hasNext = pSource->advance()) {
+                inputs.push_back(pSource->getCurrent());
+                ids.push_back(pIdExpression->evaluate(inputs.back()));
+
+                /* treat missing values the same as NULL SERVER-4674 */
+                if (ids.back().missing())
+                    ids.back() = Value(BSONNULL);
+            }
 
-            /* treat missing values the same as NULL SERVER-4674 */
-            if (id.missing())
-                id = Value(BSONNULL);
+            hashes.resize(ids.size());
+            groups->hashBatch(&ids[0], ids.size(), &hashes[0]);
 
-            /*
-              Look for the _id value in the map; if it's not there, add a
-              new entry with a blank accumulator.
-            */
-            vector<intrusive_ptr<Accumulator> >& group = groups[id];
+            for (size_t j = 0; j < inputs.size(); j++) {
+                const Document& input = inputs[j];
 
-            if (numAccumulators == 0)
-                continue; // we are basically building a set
+                /*
+                  Look for the _id value in the table; if it's not there,
+                  add a new group with blank accumulators.
+                */
+                bool inserted;
+                const size_t row = groups->findOrInsert(ids[j], hashes[j], &inserted);
+                if (inserted) {
+                    memoryUsageBytes += ids[j].getApproximateSize() + newGroupBytes;
+
+                    for (size_t i = 0; i < numAccumulators; i++) {
+                        if (vpInlineAccumulator[i])
+                            continue;
+                        intrusive_ptr<Accumulator> accum =
+                            (*vpAccumulatorFactory[i])(pAccumCtx);
+                        accum->addOperand(vpExpression[i]);
+                        groupAccumulators.push_back(accum);
+                    }
+                }
 
-            if (group.empty()) {
-                /* add the accumulators */
-                group.reserve(numAccumulators);
+                /* tickle all the accumulators for the group we found */
+                AccumulatorState *pStates = groups->getStates(row);
                 for (size_t i = 0; i < numAccumulators; i++) {
-                    intrusive_ptr<Accumulator> accum = (*vpAccumulatorFactory[i])(pExpCtx);
-                    accum->addOperand(vpExpression[i]);
-                    group.push_back(accum);
+                    if (vpInlineAccumulator[i]) {
+                        vpInlineAccumulator[i]->accumulate(pStates + vAccumulatorIndex[i],
+                                                           input);
+                        continue;
+                    }
+
+                    Accumulator *pAccum = groupAccumulators[
+                        row * nGroupAccumulators + vAccumulatorIndex[i]].get();
+                    const size_t before = pAccum->getMemoryUsage();
+                    pAccum->evaluate(input);
+                    memoryUsageBytes += pAccum->getMemoryUsage() - before;
                 }
+
+                if (canSpill &&
+                    memoryUsageBytes > static_cast<size_t>(aggregationMaxMemoryUsageBytes))
+                    spill();
             }
+        }
 
-            /* tickle all the accumulators for the group we found */
-            dassert(numAccumulators == group.size());
-            for (size_t i = 0; i < numAccumulators; i++)
-                group[i]->evaluate(input);
+        if (!spilledRuns.empty()) {
+            /* what's left goes to disk too, then everything is merged back by _id */
+            if (!groups->empty())
+                spill();
+
+            /* the merge keeps equal _ids in the order they were spilled */
+            spilledGroups.reset(SpillIterator::merge(spilledRuns, SortOptions(),
+                                                     DocumentSourceSort::KeyComparator(
+                                                         vector<char>(1, true))));
+            haveNextPartial = spilledGroups->more();
+            if (haveNextPartial)
+                nextPartial = spilledGroups->next();
+
+            spilledEof = !mergeNext();
         }
 
         /* start the group iterator */
-        groupsIterator = groups.begin();
+        groupsRow = 0;
         populated = true;
     }
 
+    void DocumentSourceGroup::spill() {
+        /* the Sorter wants each run in order */
+        vector<size_t> sorted(groups->size());
+        for (size_t row = 0; row < sorted.size(); row++)
+            sorted[row] = row;
+        std::sort(sorted.begin(), sorted.end(), GroupIdLess(*groups));
+
+        /* have the accumulators give us the partial results a shard would */
+        pSpillCtx->setInShard(true);
+
+        const size_t numAccumulators = vFieldName.size();
+        SortedFileWriter<Value, Document> writer;
+        for (size_t i = 0; i < sorted.size(); i++) {
+            MutableDocument partials (numAccumulators);
+            for (size_t j = 0; j < numAccumulators; j++)
+                partials.addField(vFieldName[j], getAccumulatedValue(sorted[i], j));
+
+            writer.addAlreadySorted(groups->getKey(sorted[i]), partials.freeze());
+        }
+
+        pSpillCtx->setInShard(pExpCtx->getInShard());
+
+        spilledRuns.push_back(boost::shared_ptr<SpillIterator>(writer.done()));
+
+        groups->clear();
+        groupAccumulators.clear();
+        memoryUsageBytes = 0;
+    }
+
+    bool DocumentSourceGroup::mergeNext() {
+        if (!haveNextPartial)
+            return false;
+
+        const size_t numAccumulators = vFieldName.size();
+        if (vpMergeExpression.empty()) {
+            for (size_t i = 0; i < numAccumulators; i++)
+                vpMergeExpression.push_back(ExpressionFieldPath::create(vFieldName[i]));
+        }
+
+        vector<intrusive_ptr<Accumulator> > accumulators;
+        accumulators.reserve(numAccumulators);
+        for (size_t i = 0; i < numAccumulators; i++) {
+            intrusive_ptr<Accumulator> accum = (*vpAccumulatorFactory[i])(pMergeCtx);
+            accum->addOperand(vpMergeExpression[i]);
+            accumulators.push_back(accum);
+        }
+
+        /* combine every run's partial results for this _id */
+        const Value id = nextPartial.first;
+        do {
+            for (size_t i = 0; i < numAccumulators; i++)
+                accumulators[i]->evaluate(nextPartial.second);
+
+            haveNextPartial = spilledGroups->more();
+            if (haveNextPartial)
+                nextPartial = spilledGroups->next();
+        } while (haveNextPartial && Value::compare(nextPartial.first, id) == 0);
+
+        spilledCurrent = makeDocument(id, accumulators);
+        return true;
+    }
+
+    Value DocumentSourceGroup::getAccumulatedValue(size_t row, size_t i) {
+        if (vpInlineAccumulator[i]) {
+            return vpInlineAccumulator[i]->getStateValue(
+                groups->getStates(row)[vAccumulatorIndex[i]]);
+        }
+
+        return groupAccumulators[row * nGroupAccumulators + vAccumulatorIndex[i]]->getValue();
+    }
+
+    Document DocumentSourceGroup::makeDocument(size_t row) {
+        const size_t n = vFieldName.size();
+        MutableDocument out (1 + n);
+
+        /* add the _id field */
+        out.addField("_id", groups->getKey(row));
+
+        /* add the rest of the fields */
+        for(size_t i = 0; i < n; ++i)
+            out.addField(vFieldName[i], nullIfMissing(getAccumulatedValue(row, i)));
+
+        return out.freeze();
+    }
+
     Document DocumentSourceGroup::makeDocument(
-        const GroupsType::iterator &rIter) {
-        vector<intrusive_ptr<Accumulator> > *pGroup = &rIter->second;
+        const Value& id, const vector<intrusive_ptr<Accumulator> >& accumulators) {
         const size_t n = vFieldName.size();
         MutableDocument out (1 + n);
 
         /* add the _id field */
-        out.addField("_id", rIter->first);
+        out.addField("_id", id);
 
         /* add the rest of the fields */
-        for(size_t i = 0; i < n; ++i) {
-            Value pValue((*pGroup)[i]->getValue());
-            if (pValue.missing()) {
-                // we return null in this case so return objects are predictable
-                out.addField(vFieldName[i], Value(BSONNULL));
-            }
-            else {
-                out.addField(vFieldName[i], pValue);
-            }
-        }
+        for(size_t i = 0; i < n; ++i)
+            out.addField(vFieldName[i], nullIfMissing(accumulators[i]->getValue()));
 
         return out.freeze();
     }
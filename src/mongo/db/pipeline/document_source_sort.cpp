@@ -24,6 +24,7 @@
 #include "db/pipeline/expression.h"
 #include "db/pipeline/expression_context.h"
 #include "db/pipeline/value.h"
+#include "mongo/db/sorter/sorter.h"
 
 namespace mongo {
     const char DocumentSourceSort::sortName[] = "$sort";
@@ -51,6 +52,11 @@ namespace mongo {
         if (!documents.empty())
             documents.pop_front(); // this way we release memory as we go
 
+        if (documents.empty() && sortedOutput && sortedOutput->more()) {
+            const pair<Value, Document> next = sortedOutput->next();
+            documents.push_back(KeyAndDoc(next.first, next.second));
+        }
+
         return !documents.empty();
     }
 
@@ -90,6 +96,7 @@ namespace mongo {
 
     void DocumentSourceSort::dispose() {
         documents.clear();
+        sortedOutput.reset();
         pSource->dispose();
     }
 
@@ -207,6 +214,12 @@ namespace mongo {
     }
 
     void DocumentSourceSort::populateAll() {
+        /* mongos has nowhere to spill to */
+        if (pExpCtx->getExtSortAllowed() && !pExpCtx->getInRouter()) {
+            populateAllExternal();
+            return;
+        }
+
         /* track and warn about how much physical memory has been used */
         DocMemMonitor dmm(this);
 
@@ -221,6 +234,25 @@ namespace mongo {
         sort(documents.begin(), documents.end(), comparator);
     }
 
+    void DocumentSourceSort::populateAllExternal() {
+        boost::scoped_ptr<Sorter<Value, Document> > sorter(
+            Sorter<Value, Document>::make(SortOptions()
+                                              .MaxMemoryUsageBytes(aggregationMaxMemoryUsageBytes)
+                                              .ExtSortAllowed(),
+                                          KeyComparator(vAscending)));
+
+        for (bool hasNext = !pSource->eof(); hasNext; hasNext = pSource->advance()) {
+            KeyAndDoc kd (pSource->getCurrent(), vSortKey);
+            sorter->add(kd.key, kd.doc);
+        }
+
+        sortedOutput.reset(sorter->done());
+        if (sortedOutput->more()) {
+            const pair<Value, Document> first = sortedOutput->next();
+            documents.push_back(KeyAndDoc(first.first, first.second));
+        }
+    }
+
     void DocumentSourceSort::populateOne() {
         if (pSource->eof())
             return;
@@ -324,4 +356,27 @@ namespace mongo {
         */
         return 0;
     }
+
+    int DocumentSourceSort::KeyComparator::operator()(const pair<Value, Document>& lhs,
+                                                      const pair<Value, Document>& rhs) const {
+        // same ordering as DocumentSourceSort::compare()
+        const size_t n = _ascending.size();
+        if (n == 1) {
+            if (_ascending[0])
+                return  Value::compare(lhs.first, rhs.first);
+            else
+                return -Value::compare(lhs.first, rhs.first);
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            int cmp = Value::compare(lhs.first[i], rhs.first[i]);
+            if (cmp)
+                return _ascending[i] ? cmp : -cmp;
+        }
+
+        return 0;
+    }
 }
+
+#include "mongo/db/sorter/sorter.cpp"
+MONGO_CREATE_SORTER(mongo::Value, mongo::Document, mongo::DocumentSourceSort::KeyComparator);
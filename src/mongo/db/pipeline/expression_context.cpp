@@ -28,6 +28,7 @@ namespace mongo {
         doingMerge(false),
         inShard(false),
         inRouter(false),
+        extSortAllowed(false),
         intCheckCounter(1),
         pStatus(pS) {
     }
@@ -47,6 +48,7 @@ namespace mongo {
         newContext->setDoingMerge(getDoingMerge());
         newContext->setInShard(getInShard());
         newContext->setInRouter(getInRouter());
+        newContext->setExtSortAllowed(getExtSortAllowed());
         return newContext;
     }
 
@@ -32,11 +32,15 @@ namespace mongo {
         void setDoingMerge(bool b);
         void setInShard(bool b);
         void setInRouter(bool b);
+        void setExtSortAllowed(bool b);
 
         bool getDoingMerge() const;
         bool getInShard() const;
         bool getInRouter() const;
 
+        /** true if stages that run out of memory may spill to disk (the allowDiskUse option) */
+        bool getExtSortAllowed() const;
+
         /**
            Used by a pipeline to check for interrupts so that killOp() works.
 
@@ -54,6 +58,7 @@ namespace mongo {
         bool doingMerge;
         bool inShard;
         bool inRouter;
+        bool extSortAllowed;
         unsigned intCheckCounter; // interrupt check counter
         InterruptStatus *const pStatus;
     };
@@ -76,6 +81,10 @@ namespace mongo {
         inRouter = b;
     }
 
+    inline void ExpressionContext::setExtSortAllowed(bool b) {
+        extSortAllowed = b;
+    }
+
     inline bool ExpressionContext::getDoingMerge() const {
         return doingMerge;
     }
@@ -88,4 +97,8 @@ namespace mongo {
         return inRouter;
     }
 
+    inline bool ExpressionContext::getExtSortAllowed() const {
+        return extSortAllowed;
+    }
+
 };
@@ -0,0 +1,127 @@
+/**
+ * Copyright (c) 2013 10gen Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pch.h"
+
+#include "db/pipeline/group_table.h"
+
+namespace mongo {
+
+    namespace {
+        const size_t initialSlots = 16;
+    }
+
+    GroupTable::GroupTable(size_t theRowWidth):
+        rowWidth(theRowWidth),
+        slotMask(0),
+        keys(1),
+        states(theRowWidth) {
+        clear();
+    }
+
+    size_t GroupTable::hash(const Value& key) {
+        size_t h = Value::Hash()(key);
+
+        /*
+          Value's hashes of small integers are nearly sequential, and we
+          only use the low bits, so mix the high bits in (murmur3's fmix).
+         */
+        unsigned long long x = h;
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return static_cast<size_t>(x);
+    }
+
+    void GroupTable::hashBatch(const Value *pKeys, size_t n, size_t *hashes) {
+        for (size_t i = 0; i < n; i++) {
+            hashes[i] = hash(pKeys[i]);
+            prefetch(&slots[hashes[i] & slotMask]);
+        }
+    }
+
+    size_t GroupTable::findOrInsert(const Value& key, size_t hash, bool *pInserted) {
+        const unsigned shortHash = static_cast<unsigned>(hash);
+        for (size_t i = shortHash & slotMask; ; i = (i + 1) & slotMask) {
+            Slot& slot = slots[i];
+            if (slot.row == emptySlot)
+                break;
+
+            if (slot.hash == shortHash && Value::compare(*keys.at(slot.row), key) == 0) {
+                *pInserted = false;
+                return slot.row;
+            }
+        }
+
+        uassert(16842, "too many groups for $group", size() < emptySlot);
+
+        /* keep the table at most half full so probe sequences stay short */
+        if ((size() + 1) * 2 > slots.size())
+            grow();
+
+        const size_t row = size();
+        *keys.push() = key;
+        states.push();
+
+        size_t i = shortHash & slotMask;
+        while (slots[i].row != emptySlot)
+            i = (i + 1) & slotMask;
+        slots[i].hash = shortHash;
+        slots[i].row = row;
+
+        *pInserted = true;
+        return row;
+    }
+
+    void GroupTable::grow() {
+        vector<Slot> old;
+        old.swap(slots);
+
+        Slot empty;
+        empty.hash = 0;
+        empty.row = emptySlot;
+        slots.assign(old.size() * 2, empty);
+        slotMask = slots.size() - 1;
+
+        /*
+          We only kept the low 32 bits of each hash, which is plenty to
+          place it in any table we can index with a row number.
+         */
+        for (size_t j = 0; j < old.size(); j++) {
+            if (old[j].row == emptySlot)
+                continue;
+
+            size_t i = old[j].hash & slotMask;
+            while (slots[i].row != emptySlot)
+                i = (i + 1) & slotMask;
+            slots[i] = old[j];
+        }
+    }
+
+    void GroupTable::clear() {
+        keys.clear();
+        states.clear();
+
+        Slot empty;
+        empty.hash = 0;
+        empty.row = emptySlot;
+        vector<Slot>(initialSlots, empty).swap(slots);
+        slotMask = initialSlots - 1;
+    }
+
+}
@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2013 10gen Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mongo/pch.h"
+
+#include <boost/shared_array.hpp>
+
+#include "db/pipeline/accumulator.h"
+#include "db/pipeline/value.h"
+
+namespace mongo {
+
+    /*
+      The hash table $group collects its groups in.
+
+      Each group is a row: its _id, and a fixed number of AccumulatorStates
+      for the accumulators that keep their state inline.  Rows are numbered
+      in the order they were added, and live in blocks of many rows, so
+      adding a group allocates nothing most of the time and never moves the
+      other groups.
+
+      The table is a flat array of (hash, row) slots with linear probing,
+      so a lookup usually reads one slot and compares one key.  hashBatch()
+      hashes a batch of keys at once and prefetches their slots, so that
+      the findOrInsert() calls that follow rarely wait on memory.
+     */
+    class GroupTable :
+        boost::noncopyable {
+    public:
+        /*
+          @param rowWidth the number of AccumulatorStates in each row
+         */
+        explicit GroupTable(size_t rowWidth);
+
+        size_t size() const { return keys.size(); }
+        bool empty() const { return keys.size() == 0; }
+
+        static size_t hash(const Value& key);
+
+        /*
+          Hash pKeys[0..n) into hashes[0..n), and prefetch the slots they
+          will be looked up in.
+         */
+        void hashBatch(const Value *pKeys, size_t n, size_t *hashes);
+
+        /*
+          Find the group for a key, adding one if there isn't one yet.  A
+          new group's AccumulatorStates are default constructed.
+
+          @param key the group's _id
+          @param hash hash(key)
+          @param pInserted set to whether the group is new
+          @returns the group's row
+         */
+        size_t findOrInsert(const Value& key, size_t hash, bool *pInserted);
+
+        const Value& getKey(size_t row) const { return *keys.at(row); }
+        AccumulatorState *getStates(size_t row) { return states.at(row); }
+
+        /* drop all the groups and free their memory */
+        void clear();
+
+    private:
+        /*
+          Fixed width rows of T, allocated rowsPerBlock rows at a time.
+          Rows never move once added.
+         */
+        template <typename T>
+        class BlockArray {
+        public:
+            explicit BlockArray(size_t theWidth): width(theWidth), count(0) {}
+
+            size_t size() const { return count; }
+
+            T *at(size_t row) const {
+                return blocks[row / rowsPerBlock].get() + (row % rowsPerBlock) * width;
+            }
+
+            T *push() {
+                if (count % rowsPerBlock == 0)
+                    blocks.push_back(boost::shared_array<T>(new T[rowsPerBlock * width]));
+                return at(count++);
+            }
+
+            void clear() {
+                blocks.clear();
+                count = 0;
+            }
+
+        private:
+            static const size_t rowsPerBlock = 256;
+
+            const size_t width;
+            size_t count;
+            vector<boost::shared_array<T> > blocks;
+        };
+
+        struct Slot {
+            unsigned hash; // low bits of the key's hash
+            unsigned row;  // emptySlot if unused
+        };
+        static const unsigned emptySlot = 0xffffffff;
+
+        void grow();
+
+        const size_t rowWidth;
+        vector<Slot> slots; // size is a power of 2
+        size_t slotMask;
+        BlockArray<Value> keys;
+        BlockArray<AccumulatorState> states;
+    };
+
+}
@@ -30,6 +30,7 @@ namespace mongo {
     const char Pipeline::commandName[] = "aggregate";
     const char Pipeline::pipelineName[] = "pipeline";
     const char Pipeline::explainName[] = "explain";
+    const char Pipeline::allowDiskUseName[] = "allowDiskUse";
     const char Pipeline::fromRouterName[] = "fromRouter";
     const char Pipeline::splitMongodPipelineName[] = "splitMongodPipeline";
     const char Pipeline::serverPipelineName[] = "serverPipeline";
@@ -122,6 +123,12 @@ namespace mongo {
                 continue;
             }
 
+            /* let $sort and $group spill to disk rather than fail when out of memory */
+            if (!strcmp(pFieldName, allowDiskUseName)) {
+                pCtx->setExtSortAllowed(cmdElement.trueValue());
+                continue;
+            }
+
             /* if the request came from the router, we're in a shard */
             if (!strcmp(pFieldName, fromRouterName)) {
                 pCtx->setInShard(cmdElement.Bool());
@@ -369,6 +376,10 @@ namespace mongo {
             pBuilder->append(explainName, explain);
         }
 
+        if (pCtx->getExtSortAllowed()) {
+            pBuilder->append(allowDiskUseName, true);
+        }
+
         bool btemp;
         if ((btemp = getSplitMongodPipeline())) {
             pBuilder->append(splitMongodPipelineName, btemp);
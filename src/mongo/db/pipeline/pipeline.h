@@ -143,6 +143,7 @@ namespace mongo {
     private:
         static const char pipelineName[];
         static const char explainName[];
+        static const char allowDiskUseName[];
         static const char fromRouterName[];
         static const char splitMongodPipelineName[];
         static const char serverPipelineName[];
@@ -22,6 +22,7 @@
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/cursor.h"
 #include "mongo/db/instance.h"
+#include "mongo/db/parallel_collection_scan.h"
 #include "mongo/db/parsed_query.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/query_optimizer.h"
@@ -198,6 +199,16 @@ namespace mongo {
         cursorWithContext->_cursor.reset
                 ( new ClientCursor( QueryOption_NoCursorTimeout, pCursor, fullName ) );
 
+        // A collection scan that needn't keep a sort order may be split among threads.
+        if (!initSort && !pPipeline->isExplain() && dynamic_cast<BasicCursor*>(pCursor.get())) {
+            NamespaceDetails* d = nsdetails(fullName);
+            int nThreads = d ? ParallelCollectionScan::threadsFor(d, queryObj) : 0;
+            if (nThreads > 0) {
+                cursorWithContext->_parallelScan.reset(new ParallelCollectionScan(d, queryObj));
+                cursorWithContext->_parallelScan->start(nThreads);
+            }
+        }
+
         /* wrap the cursor with a DocumentSource and return that */
         intrusive_ptr<DocumentSourceCursor> pSource(
             DocumentSourceCursor::create( cursorWithContext, pExpCtx ) );
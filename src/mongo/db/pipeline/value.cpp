@@ -315,6 +315,45 @@ namespace mongo {
         }
     }
 
+    void Value::serializeForSorter(BufBuilder& buf) const {
+        // arrays are written element by element, since sort keys are arrays that may have
+        // missing elements, which BSON can't hold
+        const BSONType type = missing() ? EOO : getType();
+        buf.appendChar(type);
+        if (type == EOO)
+            return;
+
+        if (type == Array) {
+            const vector<Value>& array = getArray();
+            buf.appendNum(static_cast<int>(array.size()));
+            for (size_t i = 0; i < array.size(); i++)
+                array[i].serializeForSorter(buf);
+            return;
+        }
+
+        BSONObjBuilder bob;
+        addToBsonObj(&bob, "");
+        bob.done().serializeForSorter(buf);
+    }
+
+    Value Value::deserializeForSorter(BufReader& buf, const SorterDeserializeSettings& settings) {
+        const BSONType type = static_cast<BSONType>(buf.read<char>());
+        if (type == EOO)
+            return Value();
+
+        if (type == Array) {
+            const int n = buf.read<int>();
+            vector<Value> array;
+            array.reserve(n);
+            for (int i = 0; i < n; i++)
+                array.push_back(deserializeForSorter(buf, settings));
+            return Value(array);
+        }
+
+        BSONObj wrapper = BSONObj::deserializeForSorter(buf, BSONObj::SorterDeserializeSettings());
+        return Value(wrapper.firstElement());
+    }
+
     bool Value::coerceToBool() const {
         // TODO Unify the implementation with BSONElement::trueValue().
         switch(getType()) {
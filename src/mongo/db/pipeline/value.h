@@ -21,6 +21,7 @@
 namespace mongo {
     class BSONElement;
     class Builder;
+    class BufReader;
 
     /** A variant type that can hold any type of data representable in BSON
      *
@@ -224,6 +225,13 @@ namespace mongo {
         /// Call this after memcpying to update ref counts if needed
         void memcpyed() const { _storage.memcpyed(); }
 
+        /// members for Sorter
+        struct SorterDeserializeSettings {}; // unused
+        void serializeForSorter(BufBuilder& buf) const;
+        static Value deserializeForSorter(BufReader& buf, const SorterDeserializeSettings&);
+        int memUsageForSorter() const { return getApproximateSize(); }
+        Value getOwned() const { return *this; }
+
         // LEGACY creation functions
         static Value createFromBsonElement(const BSONElement* pBsonElement);
         static Value createInt(int value) { return Value(value); }
@@ -495,9 +495,38 @@ namespace mongo {
             ++i ) {
             _qps.addCandidatePlan( *i );
         }        
+
+        addIntersectionPlan( d, plans );
         
         _qps.addCandidatePlan( newPlan( d, -1 ) );
     }
+
+    void QueryPlanGenerator::addIntersectionPlan( NamespaceDetails* d,
+                                                  const vector<shared_ptr<QueryPlan> >& plans ) {
+        // Intersected documents are returned in no particular order.
+        if ( !_qps.order().isEmpty() ) {
+            return;
+        }
+
+        // Each index must narrow down a different field.  Helpful plans constrain the first field
+        // of their index.
+        vector<int> idxNos;
+        set<string> firstFields;
+        for( vector<shared_ptr<QueryPlan> >::const_iterator i = plans.begin();
+             i != plans.end() && idxNos.size() < MaxIntersectedIndexes; ++i ) {
+            if ( (*i)->utility() != QueryPlan::Helpful ) {
+                continue;
+            }
+            if ( firstFields.insert( (*i)->indexKey().firstElementFieldName() ).second ) {
+                idxNos.push_back( (*i)->idxNo() );
+            }
+        }
+
+        if ( idxNos.size() < 2 ) {
+            return;
+        }
+        _qps.addCandidatePlan( newIntersectionPlan( d, idxNos ) );
+    }
     
     bool QueryPlanGenerator::addShortCircuitPlan( NamespaceDetails* d ) {
         return
@@ -613,6 +642,17 @@ namespace mongo {
         if ( str::equals( bestIndex.firstElementFieldName(), "$natural" ) ) {
             p = newPlan( d, -1 );
         }
+
+        if ( str::equals( bestIndex.firstElementFieldName(), "$intersect" ) ) {
+            vector<int> idxNos;
+            BSONForEach( key, bestIndex.firstElement().embeddedObject() ) {
+                int idxNo = d->findIndexByKeyPattern( key.embeddedObject() );
+                massert( 16850, "Unable to locate previously recorded intersected index",
+                         idxNo >= 0 );
+                idxNos.push_back( idxNo );
+            }
+            p = newIntersectionPlan( d, idxNos );
+        }
         
         NamespaceDetails::IndexIterator i = d->ii();
         while( i.more() ) {
@@ -660,6 +700,18 @@ namespace mongo {
         return ret;
     }
 
+    shared_ptr<QueryPlan> QueryPlanGenerator::newIntersectionPlan( NamespaceDetails* d,
+                                                                   const vector<int>& idxNos )
+            const {
+        shared_ptr<QueryPlan> ret( QueryPlan::makeIntersection( d,
+                                                                idxNos,
+                                                                _qps.frsp(),
+                                                                _originalFrsp.get(),
+                                                                _qps.originalQuery(),
+                                                                _parsedQuery ) );
+        return ret;
+    }
+
     bool QueryPlanGenerator::setUnindexedPlanIf( bool set, NamespaceDetails* d ) {
         if ( set ) {
             setSingleUnindexedPlan( d );
@@ -801,7 +853,7 @@ namespace mongo {
     void QueryPlanSet::addCandidatePlan( const QueryPlanPtr& plan ) {
         // If _plans is nonempty, the new plan may be supplementing a recorded plan at the first
         // position of _plans.  It must not duplicate the first plan.
-        if ( nPlans() > 0 && plan->indexKey() == firstPlan()->indexKey() ) {
+        if ( nPlans() > 0 && plan->cacheKey() == firstPlan()->cacheKey() ) {
             return;
         }
         pushPlan( plan );
@@ -1047,6 +1099,9 @@ namespace mongo {
                 runner.queryPlan().registerSelf( runner.nscanned(),
                                                  _plans.characterizeCandidatePlans() );
             }
+            else if ( _plans.usingCachedPlan() && runner.mayRecordPlan() ) {
+                runner.queryPlan().registerRun( runner.nscanned() );
+            }
             _done = true;
             return holder._runner;
         }
@@ -1054,8 +1109,9 @@ namespace mongo {
             return holder._runner;
         }
         if ( _plans.hasPossiblyExcludedPlans() &&
-            runner.nscanned() > _plans.oldNScanned() * 10 ) {
+            runner.nscanned() > _plans.oldNScanned() * ReplanNScannedRatio ) {
             verify( _plans.nPlans() == 1 && _plans.firstPlan()->special().empty() );
+            runner.queryPlan().registerReplan();
             holder._offset = -runner.nscanned();
             _plans.addFallbackPlans();
             QueryPlanSet::PlanVector::const_iterator i = _plans.plans().begin();
@@ -1211,6 +1267,11 @@ namespace mongo {
         if ( clausePlan.willScanTable() ) {
             _tableScanned = true;   
         }
+        else if ( clausePlan.isIntersection() ) {
+            // Documents in the first index's bounds were not all examined, only those matching
+            // the whole clause.
+            _org->popOrClause( clausePlan.nsd(), -1, BSONObj() );
+        }
         else {
             _org->popOrClause( clausePlan.nsd(),
                                clausePlan.idxNo(),
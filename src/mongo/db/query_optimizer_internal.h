@@ -312,6 +312,9 @@ namespace mongo {
         /** Supplement a cached plan provided earlier by adding additional query plans. */
         void addFallbackPlans();
 
+        /** The most indexes an intersection plan will scan. */
+        static const size_t MaxIntersectedIndexes = 4;
+
     private:
 
         bool addShortCircuitPlan( NamespaceDetails* d );
@@ -324,12 +327,19 @@ namespace mongo {
 
         bool addCachedPlan( NamespaceDetails* d );
 
+        /** Add a plan intersecting the candidate 'plans' indexes, if it may help. */
+        void addIntersectionPlan( NamespaceDetails* d,
+                                  const vector<shared_ptr<QueryPlan> >& plans );
+
         shared_ptr<QueryPlan> newPlan( NamespaceDetails* d,
                                        int idxNo,
                                        const BSONObj& min = BSONObj(),
                                        const BSONObj& max = BSONObj(),
                                        const string& special = "" ) const;
 
+        shared_ptr<QueryPlan> newIntersectionPlan( NamespaceDetails* d,
+                                                   const vector<int>& idxNos ) const;
+
         bool setUnindexedPlanIf( bool set, NamespaceDetails* d );
 
         void setSingleUnindexedPlan( NamespaceDetails* d );
@@ -420,7 +430,7 @@ namespace mongo {
 
         bool mayRecordPlan() const { return _mayRecordPlan; }
 
-        int oldNScanned() const { return _oldNScanned; }
+        long long oldNScanned() const { return _oldNScanned; }
 
         void addFallbackPlans();
 
@@ -496,6 +506,12 @@ namespace mongo {
             return _explainClauseInfo;
         }
 
+        /**
+         * A plan from the cache is raced against the other candidates again once it has scanned
+         * this many times the nscanned it was recorded with.
+         */
+        static const long long ReplanNScannedRatio = 10;
+
     private:
         const QueryPlanRunner& _prototypeRunner;
         QueryPlanSet& _plans;
@@ -23,6 +23,7 @@
 #include "mongo/db/index/emulated_cursor.h"
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/intersection_cursor.h"
 #include "mongo/db/intervalbtreecursor.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/parsed_query.h"
@@ -66,6 +67,34 @@ namespace mongo {
         ret->init( originalFrsp, startKey, endKey );
         return ret.release();
     }
+
+    QueryPlan* QueryPlan::makeIntersection( NamespaceDetails* d,
+                                            const vector<int>& idxNos,
+                                            const FieldRangeSetPair& frsp,
+                                            const FieldRangeSetPair* originalFrsp,
+                                            const BSONObj& originalQuery,
+                                            const shared_ptr<const ParsedQuery>& parsedQuery ) {
+        verify( idxNos.size() > 1 );
+        auto_ptr<QueryPlan> ret( make( d, idxNos[ 0 ], frsp, originalFrsp, originalQuery,
+                                       BSONObj(), parsedQuery ) );
+        ret->_intersectSortedByLoc = true;
+        for( vector<int>::const_iterator i = idxNos.begin(); i != idxNos.end(); ++i ) {
+            shared_ptr<QueryPlan> plan( make( d, *i, frsp, originalFrsp, originalQuery, BSONObj(),
+                                              parsedQuery ) );
+            if ( plan->utility() != Helpful || !plan->special().empty() ) {
+                // A recorded intersection may not suit every query of its pattern.
+                ret->_utility = Disallowed;
+            }
+            if ( !plan->scansSinglePoint() ) {
+                ret->_intersectSortedByLoc = false;
+            }
+            ret->_intersected.push_back( plan );
+        }
+        // Documents found in several indexes are always loaded and matched.
+        ret->_matcherNecessary = true;
+        ret->_keyFieldsOnly.reset();
+        return ret.release();
+    }
     
     QueryPlan::QueryPlan( NamespaceDetails* d,
                           int idxNo,
@@ -88,7 +117,8 @@ namespace mongo {
         _endKeyInclusive(),
         _utility( Helpful ),
         _special( special ),
-        _startOrEndSpec() {
+        _startOrEndSpec(),
+        _intersectSortedByLoc() {
     }
     
     void QueryPlan::init( const FieldRangeSetPair* originalFrsp,
@@ -260,6 +290,20 @@ doneCheckOrder:
                                                            descriptor->keyPattern()));
         }
 
+        if ( isIntersection() ) {
+            vector<shared_ptr<Cursor> > cursors;
+            for( vector<shared_ptr<QueryPlan> >::const_iterator i = _intersected.begin();
+                 i != _intersected.end(); ++i ) {
+                cursors.push_back( (*i)->newCursor() );
+            }
+            shared_ptr<Cursor> firstIndexCursor;
+            if ( !_intersectSortedByLoc ) {
+                firstIndexCursor = _intersected.front()->newCursor();
+            }
+            return shared_ptr<Cursor>( IntersectionCursor::make( cursors, _intersectSortedByLoc,
+                                                                 firstIndexCursor ) );
+        }
+
         if ( _utility == Impossible ) {
             // Dummy table scan cursor returning no results.  Allowed in --notablescan mode.
             return shared_ptr<Cursor>( new BasicCursor( DiskLoc() ) );
@@ -338,6 +382,17 @@ doneCheckOrder:
         return _index->keyPattern();
     }
 
+    BSONObj QueryPlan::cacheKey() const {
+        if ( !isIntersection() )
+            return indexKey();
+        BSONArrayBuilder keys;
+        for( vector<shared_ptr<QueryPlan> >::const_iterator i = _intersected.begin();
+             i != _intersected.end(); ++i ) {
+            keys.append( (*i)->indexKey() );
+        }
+        return BSON( "$intersect" << keys.arr() );
+    }
+
     const char* QueryPlan::ns() const {
         return _frs.ns();
     }
@@ -352,10 +407,22 @@ doneCheckOrder:
 
         SimpleMutex::scoped_lock lk( NamespaceDetailsTransient::_qcMutex );
         QueryPattern queryPattern = _frs.pattern( _order );
-        CachedQueryPlan queryPlanToCache( indexKey(), nScanned, candidatePlans );
+        CachedQueryPlan queryPlanToCache( cacheKey(), nScanned, candidatePlans );
         NamespaceDetailsTransient &nsdt = NamespaceDetailsTransient::get_inlock( ns() );
         nsdt.registerCachedQueryPlanForPattern( queryPattern, queryPlanToCache );
     }
+
+    void QueryPlan::registerRun( long long nScanned ) const {
+        SimpleMutex::scoped_lock lk( NamespaceDetailsTransient::_qcMutex );
+        QueryPattern queryPattern = _frs.pattern( _order );
+        NamespaceDetailsTransient &nsdt = NamespaceDetailsTransient::get_inlock( ns() );
+        nsdt.registerCachedQueryPlanRun( queryPattern, cacheKey(), nScanned );
+    }
+
+    void QueryPlan::registerReplan() const {
+        SimpleMutex::scoped_lock lk( NamespaceDetailsTransient::_qcMutex );
+        NamespaceDetailsTransient::get_inlock( ns() ).notifyOfReplan();
+    }
     
     void QueryPlan::checkTableScanAllowed() const {
         if ( likely( !cmdLine.noTableScan ) )
@@ -395,6 +462,18 @@ doneCheckOrder:
     bool QueryPlan::hasPossibleExistsFalsePredicate() const {
         return matcher()->docMatcher().hasExistsFalse();
     }
+
+    bool QueryPlan::scansSinglePoint() const {
+        // Keys that are equal are ordered by their record locations.
+        return
+            _frv &&
+            !_startOrEndSpec &&
+            _direction >= 0 &&
+            _frv->isSingleInterval() &&
+            _frv->startKeyInclusive() &&
+            _frv->endKeyInclusive() &&
+            _frv->startKey().woCompare( _frv->endKey(), BSONObj(), false ) == 0;
+    }
     
     bool QueryPlan::queryBoundsExactOrderSuffix() const {
         if ( !indexed() ||
@@ -459,6 +538,11 @@ doneCheckOrder:
     bool QueryPlan::isMultiKey() const {
         if ( _idxNo < 0 )
             return false;
+        for( vector<shared_ptr<QueryPlan> >::const_iterator i = _intersected.begin();
+             i != _intersected.end(); ++i ) {
+            if ( (*i)->isMultiKey() )
+                return true;
+        }
         return _d->isMultikey( _idxNo );
     }
 
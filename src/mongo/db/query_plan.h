@@ -56,6 +56,18 @@ namespace mongo {
                                 const BSONObj& endKey = BSONObj(),
                                 const std::string& special = "" );
 
+        /**
+         * @return a plan that scans each of the indexes 'idxNos' and returns only the documents
+         * found by all of them.  There must be no sort.  The plan is Disallowed unless every
+         * index gives a Helpful plan for the query.
+         */
+        static QueryPlan* makeIntersection( NamespaceDetails* d,
+                                            const vector<int>& idxNos,
+                                            const FieldRangeSetPair& frsp,
+                                            const FieldRangeSetPair* originalFrsp,
+                                            const BSONObj& originalQuery,
+                                            const shared_ptr<const ParsedQuery>& parsedQuery );
+
         /** Categorical classification of a QueryPlan's utility. */
         enum Utility {
             Impossible, // Cannot produce any matches, so the query must have an empty result set.
@@ -101,10 +113,29 @@ namespace mongo {
         /** Register this plan as a winner for its QueryPattern, with specified 'nscanned'. */
         void registerSelf( long long nScanned, CandidatePlanCharacter candidatePlans ) const;
 
+        /** Record a completed run of this plan, taken from the cache, with specified 'nscanned'. */
+        void registerRun( long long nScanned ) const;
+
+        /** Record that this plan, taken from the cache, scanned too much and is being raced. */
+        void registerReplan() const;
+
         int direction() const { return _direction; }
 
+        /**
+         * @return the key pattern of the plan's index.  For an intersection plan, the first index
+         * scanned, whose bounds stand for the plan's in $or clause handling.
+         */
         BSONObj indexKey() const;
 
+        /**
+         * @return the key the plan is recorded under in the query cache: indexKey(), or
+         * { $intersect:[ <key pattern>, ... ] } for an intersection plan.
+         */
+        BSONObj cacheKey() const;
+
+        /** @return true if this plan intersects the documents found by several indexes. */
+        bool isIntersection() const { return !_intersected.empty(); }
+
         bool indexed() const { return _index != 0; }
 
         const IndexDetails* index() const { return _index; }
@@ -157,6 +188,9 @@ namespace mongo {
         /** @return true when the plan's query may contains an $exists:false predicate. */
         bool hasPossibleExistsFalsePredicate() const;
 
+        /** @return true if the plan scans a single point of its index, in DiskLoc order. */
+        bool scansSinglePoint() const;
+
         NamespaceDetails* _d;
         int _idxNo;
         const FieldRangeSet& _frs;
@@ -180,6 +214,8 @@ namespace mongo {
         mutable shared_ptr<CoveredIndexMatcher> _matcher; // Lazy initialization.
         auto_ptr<IndexDescriptor> _descriptor;
         string _specialIndexName;
+        vector<shared_ptr<QueryPlan> > _intersected; // One plan per index of an intersection.
+        bool _intersectSortedByLoc;
     };
 
     std::ostream &operator<< ( std::ostream& out, const QueryPlan::Utility& utility );
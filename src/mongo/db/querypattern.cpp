@@ -80,11 +80,15 @@ namespace mongo {
     }
     
     string QueryPattern::toString() const {
+        return toBSON().toString();
+    }
+
+    BSONObj QueryPattern::toBSON() const {
         BSONObjBuilder b;
         for( map<string,Type>::const_iterator i = _fieldTypes.begin(); i != _fieldTypes.end(); ++i ) {
             b << i->first << typeToString( i->second );
         }
-        return BSON( "query" << b.done() << "sort" << _sort ).toString();
+        return BSON( "query" << b.done() << "sort" << _sort );
     }
     
     void QueryPattern::setSort( const BSONObj sort ) {
@@ -110,7 +114,28 @@ namespace mongo {
                                      CandidatePlanCharacter planCharacter ) :
     _indexKey( indexKey ),
     _nScanned( nScanned ),
-    _planCharacter( planCharacter ) {
+    _planCharacter( planCharacter ),
+    _nRuns(),
+    _nScannedTotal(),
+    _nScannedMax() {
+    }
+
+    void CachedQueryPlan::recordRun( long long nScanned ) {
+        ++_nRuns;
+        _nScannedTotal += nScanned;
+        _nScannedMax = std::max( _nScannedMax, nScanned );
+    }
+
+    BSONObj CachedQueryPlan::toBSON() const {
+        BSONObjBuilder b;
+        b.append( "indexKey", _indexKey );
+        b.append( "nscanned", _nScanned );
+        b.append( "runs", _nRuns );
+        if ( _nRuns > 0 ) {
+            b.append( "avgNscanned", _nScannedTotal / _nRuns );
+            b.append( "maxNscanned", _nScannedMax );
+        }
+        return b.obj();
     }
 
     
@@ -49,6 +49,8 @@ namespace mongo {
         bool operator!=( const QueryPattern &other ) const;
         /** for development / debugging */
         string toString() const;
+        /** the field types and sort, as reported by the planCache command */
+        BSONObj toBSON() const;
     private:
         void setSort( const BSONObj sort );
         static BSONObj normalizeSort( const BSONObj &spec );
@@ -76,21 +78,40 @@ namespace mongo {
         bool _mayRunOutOfOrderPlan;
     };
 
-    /** Information about a query plan that ran successfully for a QueryPattern. */
+    /**
+     * Information about a query plan that ran successfully for a QueryPattern, and how it has done
+     * on the runs since it was recorded.
+     */
     class CachedQueryPlan {
     public:
         CachedQueryPlan() :
-        _nScanned() {
+        _nScanned(),
+        _nRuns(),
+        _nScannedTotal(),
+        _nScannedMax() {
         }
         CachedQueryPlan( const BSONObj &indexKey, long long nScanned,
                         CandidatePlanCharacter planCharacter );
         BSONObj indexKey() const { return _indexKey; }
+        /** nscanned when the plan was recorded, which later runs are held to */
         long long nScanned() const { return _nScanned; }
         CandidatePlanCharacter planCharacter() const { return _planCharacter; }
+
+        /** Record a completed run of the plan from the cache. */
+        void recordRun( long long nScanned );
+        long long nRuns() const { return _nRuns; }
+        long long nScannedTotal() const { return _nScannedTotal; }
+        long long nScannedMax() const { return _nScannedMax; }
+
+        /** for the planCache command */
+        BSONObj toBSON() const;
     private:
         BSONObj _indexKey;
         long long _nScanned;
         CandidatePlanCharacter _planCharacter;
+        long long _nRuns;
+        long long _nScannedTotal;
+        long long _nScannedMax;
     };
 
     inline bool QueryPattern::operator<( const QueryPattern &other ) const {
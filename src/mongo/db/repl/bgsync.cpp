@@ -22,6 +22,7 @@
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/rs_sync.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/base/counter.h"
 #include "mongo/db/stats/timer_stats.h"
@@ -31,6 +32,15 @@ namespace replset {
 
     int SleepToAllowBatchingMillis = 2;
     const int BatchIsSmallish = 40000; // bytes
+    // most ops the prefetch stage takes on at once
+    const size_t PrefetchChunkOps = 5000;
+
+    // have sync targets that support it stream their oplog at us instead of waiting for a
+    // getmore per batch
+    static bool replOplogFetchExhaust = true;
+    static ExportedServerParameter<bool> ReplOplogFetchExhaustParameter(
+            ServerParameterSet::getGlobal(), "replOplogFetchExhaust", &replOplogFetchExhaust,
+            true, true);
 
     MONGO_FP_DECLARE(rsBgSyncProduce);
 
@@ -64,6 +74,27 @@ namespace replset {
     static ServerStatusMetricField<int> displayBufferMaxSize( "repl.buffer.maxSizeBytes",
                                                                 &bufferMaxSizeGauge );
 
+    //The count of fetched items waiting to be prefetched
+    static Counter64 fetchBufferCountGauge;
+    static ServerStatusMetricField<Counter64> displayFetchBufferCount(
+                                                    "repl.network.buffer.count",
+                                                    &fetchBufferCountGauge );
+    //The size (bytes) of fetched items waiting to be prefetched
+    static Counter64 fetchBufferSizeGauge;
+    static ServerStatusMetricField<Counter64> displayFetchBufferSize(
+                                                    "repl.network.buffer.sizeBytes",
+                                                    &fetchBufferSizeGauge );
+    //The max size (bytes) of the fetch buffer
+    static int fetchBufferMaxSizeGauge = 64*1024*1024;
+    static ServerStatusMetricField<int> displayFetchBufferMaxSize(
+                                                    "repl.network.buffer.maxSizeBytes",
+                                                    &fetchBufferMaxSizeGauge );
+
+    //The number and time spent prefetching chunks of ops
+    static TimerStats prefetchReplStats;
+    static ServerStatusMetricField<TimerStats> displayPrefetchChunks( "repl.prefetch.batches",
+                                                                      &prefetchReplStats );
+
 
     BackgroundSyncInterface::~BackgroundSyncInterface() {}
 
@@ -71,7 +102,11 @@ namespace replset {
         return o.objsize();
     }
 
-    BackgroundSync::BackgroundSync() : _buffer(bufferMaxSizeGauge, &getSize),
+    BackgroundSync::BackgroundSync() : _fetchBuffer(fetchBufferMaxSizeGauge, &getSize),
+                                       _buffer(bufferMaxSizeGauge, &getSize),
+                                       _opsInPipeline(0),
+                                       _opsPrefetching(0),
+                                       _exhaust(false),
                                        _lastOpTimeFetched(0, 0),
                                        _lastH(0),
                                        _pause(true),
@@ -111,8 +146,10 @@ namespace replset {
         {
             boost::unique_lock<boost::mutex> lock(s_instance->_mutex);
 
-            // If all ops in the buffer have been applied, unblock waitForRepl (if it's waiting)
-            if (s_instance->_buffer.empty()) {
+            // If all ops fetched have been applied, unblock waitForRepl (if it's waiting).  The
+            // applier calls this once a batch is applied, before consuming the next one, so
+            // every op consumed so far has been applied.
+            if (s_instance->_opsInPipeline == 0) {
                 s_instance->_appliedBuffer = true;
                 s_instance->_condvar.notify_all();
             }
@@ -258,6 +295,49 @@ namespace replset {
         cc().shutdown();
     }
 
+    void BackgroundSync::prefetcherThread() {
+        Client::initThread("rsBackgroundPrefetch");
+        replLocalAuth();
+
+        std::deque<BSONObj> ops;
+        while (!inShutdown()) {
+            BSONObj op;
+            // wake up every second to check for shutdown
+            if (!_fetchBuffer.blockingPeek(op, 1)) {
+                continue;
+            }
+
+            {
+                boost::unique_lock<boost::mutex> lock(_mutex);
+                while (ops.size() < PrefetchChunkOps && _fetchBuffer.tryPop(op)) {
+                    ops.push_back(op);
+                    fetchBufferCountGauge.decrement(1);
+                    fetchBufferSizeGauge.decrement(getSize(op));
+                }
+                _opsPrefetching = ops.size();
+            }
+
+            {
+                TimerHolder prefetchTimer(&prefetchReplStats);
+                SyncTail::prefetchOps(ops);
+            }
+
+            for (; !ops.empty(); ops.pop_front()) {
+                // the blocking queue will wait (forever) until there's room for us to push
+                _buffer.push(ops.front());
+                bufferCountGauge.increment();
+                bufferSizeGauge.increment(getSize(ops.front()));
+            }
+
+            {
+                boost::unique_lock<boost::mutex> lock(_mutex);
+                _opsPrefetching = 0;
+            }
+        }
+
+        cc().shutdown();
+    }
+
     void BackgroundSync::_producerThread() {
         MemberState state = theReplSet->state();
 
@@ -324,12 +404,21 @@ namespace replset {
             return;
         }
 
+        bool exhaust = replOplogFetchExhaust && r.exhaustCapable();
+        if (exhaust && !streamFromLastFetched(r)) {
+            return;
+        }
+        {
+            boost::unique_lock<boost::mutex> lock(_mutex);
+            _exhaust = exhaust;
+        }
+
         while (!inShutdown()) {
             while (!inShutdown()) {
 
                 if (!r.moreInCurrentBatch()) {
                     int bs = r.currentBatchMessageSize();
-                    if( bs > 0 && bs < BatchIsSmallish ) {
+                    if( !exhaust && bs > 0 && bs < BatchIsSmallish ) {
                         // on a very low latency network, if we don't wait a little, we'll be 
                         // getting ops to write almost one at a time.  this will both be expensive
                         // for the upstream server as well as postentiallyd efating our parallel 
@@ -373,15 +462,17 @@ namespace replset {
                 {
                     boost::unique_lock<boost::mutex> lock(_mutex);
                     _appliedBuffer = false;
+                    _opsInPipeline++;
                 }
 
                 OCCASIONALLY {
-                    LOG(2) << "bgsync buffer has " << _buffer.size() << " bytes" << rsLog;
+                    LOG(2) << "bgsync buffer has " << _fetchBuffer.size() << " bytes fetched and "
+                           << _buffer.size() << " bytes prefetched" << rsLog;
                 }
                 // the blocking queue will wait (forever) until there's room for us to push
-                _buffer.push(o);
-                bufferCountGauge.increment();
-                bufferSizeGauge.increment(getSize(o));
+                _fetchBuffer.push(o);
+                fetchBufferCountGauge.increment();
+                fetchBufferSizeGauge.increment(getSize(o));
 
                 {
                     boost::unique_lock<boost::mutex> lock(_mutex);
@@ -447,6 +538,9 @@ namespace replset {
         BSONObj op = _buffer.blockingPop();
         bufferCountGauge.decrement(1);
         bufferSizeGauge.decrement(getSize(op));
+
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        _opsInPipeline--;
     }
 
     bool BackgroundSync::isStale(OplogReader& r, BSONObj& remoteOldestOp) {
@@ -573,6 +667,27 @@ namespace replset {
         return false;
     }
 
+    bool BackgroundSync::streamFromLastFetched(OplogReader& r) {
+        // isRollbackRequired() used a plain cursor, as it may need the connection for other
+        // queries.  once past it nothing else is sent on this connection until produce() is
+        // done with it, so the rest can come as a stream.
+        r.resetCursor();
+        r.setTailingQueryOptions(r.getTailingQueryOptions() | QueryOption_Exhaust);
+        {
+            boost::unique_lock<boost::mutex> lock(_mutex);
+            r.tailingQueryGTE(rsoplog, _lastOpTimeFetched);
+        }
+
+        if (!r.haveCursor() || !r.more()) {
+            return false;
+        }
+
+        // the first op is the one we just checked; if it changed underneath us, start over
+        BSONObj o = r.nextSafe();
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        return o["ts"]._opTime() == _lastOpTimeFetched && o["h"].numberLong() == _lastH;
+    }
+
     const Member* BackgroundSync::getSyncTarget() {
         boost::unique_lock<boost::mutex> lock(_mutex);
         return _currentSyncTarget;
@@ -583,13 +698,15 @@ namespace replset {
 
         _pause = true;
         _currentSyncTarget = NULL;
+        _exhaust = false;
         _lastOpTimeFetched = OpTime(0,0);
         _lastH = 0;
         _condvar.notify_all();
     }
 
     void BackgroundSync::start() {
-        massert(16235, "going to start syncing, but buffer is not empty", _buffer.empty());
+        massert(16235, "going to start syncing, but buffer is not empty",
+                _fetchBuffer.empty() && _buffer.empty());
 
         boost::unique_lock<boost::mutex> lock(_mutex);
         _pause = false;
@@ -606,6 +723,38 @@ namespace replset {
         return _assumingPrimary;
     }
 
+    BSONObj BackgroundSync::getCounters() {
+        BSONObjBuilder b;
+        {
+            BSONObjBuilder fetch(b.subobjStart("fetch"));
+            {
+                boost::unique_lock<boost::mutex> lock(_mutex);
+                fetch.append("exhaust", _exhaust);
+            }
+            fetch.append("count", _fetchBuffer.count());
+            fetch.append("sizeBytes", static_cast<long long>(_fetchBuffer.size()));
+            fetch.append("maxSizeBytes", static_cast<long long>(_fetchBuffer.maxSize()));
+            fetch.done();
+        }
+        {
+            BSONObjBuilder prefetch(b.subobjStart("prefetch"));
+            {
+                boost::unique_lock<boost::mutex> lock(_mutex);
+                prefetch.append("count", _opsPrefetching);
+            }
+            prefetch.append("batches", prefetchReplStats.getReport());
+            prefetch.done();
+        }
+        {
+            BSONObjBuilder apply(b.subobjStart("apply"));
+            apply.append("count", _buffer.count());
+            apply.append("sizeBytes", static_cast<long long>(_buffer.size()));
+            apply.append("maxSizeBytes", static_cast<long long>(_buffer.maxSize()));
+            apply.done();
+        }
+        return b.obj();
+    }
+
     void BackgroundSync::stopReplicationAndFlushBuffer() {
         boost::unique_lock<boost::mutex> lck(_mutex);
 
@@ -50,6 +50,15 @@ namespace replset {
 
 
     /**
+     * Ops move through three stages on their way to the applier, each with its own thread and a
+     * bounded queue in front of the next:
+     *
+     *   producerThread()   reads the sync target's oplog (streamed with an exhaust cursor when
+     *                      the target supports it) into _fetchBuffer
+     *   prefetcherThread() takes what has been fetched in chunks, prefetches the pages each op
+     *                      will touch on the prefetch pool, and moves the chunk into _buffer
+     *   SyncTail           peeks/consumes _buffer and applies batches
+     *
      * notifierThread() uses lastOpTimeWritten to inform the sync target where this member is
      * currently synced to.
      *
@@ -67,7 +76,15 @@ namespace replset {
         boost::mutex _mutex;
 
         // Production thread
+        BlockingQueue<BSONObj> _fetchBuffer;
+        // Prefetch thread; ops here are ready to apply
         BlockingQueue<BSONObj> _buffer;
+        // ops fetched but not yet consumed by the applier, in any stage
+        long long _opsInPipeline;
+        // ops taken off _fetchBuffer being prefetched right now
+        int _opsPrefetching;
+        // if the current sync target streams to us with an exhaust cursor
+        bool _exhaust;
 
         OpTime _lastOpTimeFetched;
         long long _lastH;
@@ -99,6 +116,8 @@ namespace replset {
         void produce();
         // Check if rollback is necessary
         bool isRollbackRequired(OplogReader& r);
+        // reissue the query past the op isRollbackRequired() checked as an exhaust cursor
+        bool streamFromLastFetched(OplogReader& r);
         void getOplogReader(OplogReader& r);
         // Evaluate if the current sync target is still good
         bool shouldChangeSyncTarget();
@@ -125,6 +144,8 @@ namespace replset {
 
         // starts the producer thread
         void producerThread();
+        // starts the prefetch stage thread
+        void prefetcherThread();
         // starts the sync target notifying thread
         void notifierThread();
 
@@ -135,7 +156,7 @@ namespace replset {
         virtual const Member* getSyncTarget();
         virtual void waitForMore();
 
-        // For monitoring
+        // For monitoring: the state of each stage, reported in replSetGetStatus
         BSONObj getCounters();
 
         // Wait for replication to finish and buffer to be applied so that the member can become
@@ -465,6 +465,9 @@ namespace mongo {
             (myState != MemberState::RS_SHUNNED) ) {
             b.append("syncingTo", syncTarget->fullName());
         }
+        if ( (myState != MemberState::RS_PRIMARY) && (myState != MemberState::RS_ARBITER) ) {
+            b.append("syncPipeline", replset::BackgroundSync::get()->getCounters());
+        }
         b.append("members", v);
         if( replSetBlind )
             b.append("blind",true); // to avoid confusion if set...normally never set except for testing.
@@ -502,6 +502,7 @@ namespace mongo {
 
         replset::BackgroundSync* sync = replset::BackgroundSync::get();
         boost::thread producer(boost::bind(&replset::BackgroundSync::producerThread, sync));
+        boost::thread prefetcher(boost::bind(&replset::BackgroundSync::prefetcherThread, sync));
         boost::thread notifier(boost::bind(&replset::BackgroundSync::notifierThread, sync));
 
         task::fork(ghost);
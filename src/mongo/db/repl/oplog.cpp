@@ -553,9 +553,8 @@ namespace mongo {
         }
         else if ( *opType == 'c' ) {
             opCounters->gotCommand();
-            BufBuilder bb;
             BSONObjBuilder ob;
-            _runCommands(ns, o, bb, ob, true, 0);
+            _runCommands(ns, o, ob, true, 0);
         }
         else if ( *opType == 'n' ) {
             // no op
@@ -117,6 +117,13 @@ namespace mongo {
             return cursor->hasResultFlag(ResultFlag_AwaitCapable);
         }
 
+        /** @return true if the server can stream query results with QueryOption_Exhaust */
+        bool exhaustCapable() {
+            BSONObj ret;
+            return conn()->runCommand("admin", BSON("availablequeryoptions" << 1), ret) &&
+                   (ret.getIntField("options") & QueryOption_Exhaust);
+        }
+
         int getTailingQueryOptions() const { return _tailingQueryOptions; }
         void setTailingQueryOptions( int tailingQueryOptions ) { _tailingQueryOptions = tailingQueryOptions; }
 
@@ -21,11 +21,13 @@
 #include <boost/scoped_ptr.hpp>
 
 #include "mongo/client/connpool.h"
+#include "mongo/db/client_basic.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/repl/master_slave.h"
 #include "mongo/db/repl/rs.h"
+#include "mongo/util/net/message_port.h"
 
 namespace mongo {
 
@@ -161,6 +163,7 @@ namespace mongo {
             result.appendNumber("maxBsonObjectSize", BSONObjMaxUserSize);
             result.appendNumber("maxMessageSizeBytes", MaxMessageSizeBytes);
             result.appendDate("localTime", jsTime());
+            negotiateCompression(cmdObj, ClientBasic::getCurrent()->port(), result);
             return true;
         }
     } cmdismaster;
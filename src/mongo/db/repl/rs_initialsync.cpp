@@ -16,6 +16,8 @@
 
 #include "mongo/pch.h"
 
+#include <boost/thread/thread.hpp>
+
 #include "mongo/db/repl/rs.h"
 
 #include "mongo/db/client.h"
@@ -27,6 +29,7 @@
 #include "mongo/db/repl/optime.h"
 #include "mongo/db/repl/replication_server_status.h"  // replSettings
 #include "mongo/db/repl/rs_sync.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
@@ -67,41 +70,112 @@ namespace mongo {
         fassert( 16233, failedAttempts < maxFailedAttempts);
     }
 
-    bool ReplSetImpl::_syncDoInitialSync_clone(Cloner& cloner, const char *master,
+    // Collections of a database copied at once during initial sync, each over a connection of
+    // its own, and databases whose indexes are built at once afterwards.  1 does one at a time.
+    static int initialSyncCloneThreads = 1;
+    static ExportedServerParameter<int> InitialSyncCloneThreadsParameter(
+            ServerParameterSet::getGlobal(), "initialSyncCloneThreads", &initialSyncCloneThreads,
+            true, true);
+
+    static bool cloneDB(Cloner& cloner, const char *master, const string& db, bool dataPass) {
+        if ( dataPass )
+            theReplSet->sethbmsg( str::stream() << "initial sync cloning db: " << db , 0);
+        else
+            theReplSet->sethbmsg( str::stream() << "initial sync cloning indexes for : " << db , 0);
+
+        Client::WriteContext ctx(db);
+
+        string err;
+        int errCode;
+        CloneOptions options;
+        options.fromDB = db;
+        options.logForRepl = false;
+        options.slaveOk = true;
+        options.useReplAuth = true;
+        options.snapshot = false;
+        options.mayYield = true;
+        options.mayBeInterrupted = false;
+        options.syncData = dataPass;
+        options.syncIndexes = ! dataPass;
+        // documents go in with only the _id index; the others are built in the index pass
+        options.parallelCollections = initialSyncCloneThreads;
+
+        if (!cloner.go(master, options, err, &errCode)) {
+            theReplSet->sethbmsg(str::stream() << "initial sync: error while "
+                                               << (dataPass ? "cloning " : "indexing ") << db
+                                               << ".  " << (err.empty() ? "" : err + ".  ")
+                                               << "sleeping 5 minutes" ,0);
+            return false;
+        }
+        return true;
+    }
+
+    /** the databases left to index, shared by the threads of the parallel index pass */
+    struct IndexPassWork {
+        IndexPassWork(const list<string>& dbs) : m("IndexPassWork"), todo(dbs), failed(false) {}
+        mongo::mutex m;
+        list<string> todo;
+        bool failed;
+    };
+
+    static void indexPassThread(const string& master, IndexPassWork* work) {
+        Client::initThread("initial sync index builder");
+        replLocalAuth();
+
+        Cloner cloner;
+        while (1) {
+            string db;
+            {
+                scoped_lock lk(work->m);
+                if (work->todo.empty() || work->failed)
+                    break;
+                db = work->todo.front();
+                work->todo.pop_front();
+            }
+
+            bool ok = false;
+            try {
+                ok = cloneDB(cloner, master.c_str(), db, false);
+            }
+            catch (std::exception& e) {
+                log() << "replSet initial sync index build for " << db << " failed: "
+                      << e.what() << rsLog;
+            }
+
+            if (!ok) {
+                scoped_lock lk(work->m);
+                work->failed = true;
+            }
+        }
+
+        cc().shutdown();
+    }
+
+    bool ReplSetImpl::_syncDoInitialSync_clone(Cloner &cloner, const char *master,
                                                const list<string>& dbs, bool dataPass) {
 
+        list<string> toClone;
         for( list<string>::const_iterator i = dbs.begin(); i != dbs.end(); i++ ) {
-            string db = *i;
-            if( db == "local" ) 
-                continue;
-            
-            if ( dataPass )
-                sethbmsg( str::stream() << "initial sync cloning db: " << db , 0);
-            else
-                sethbmsg( str::stream() << "initial sync cloning indexes for : " << db , 0);
-
-            Client::WriteContext ctx(db);
-
-            string err;
-            int errCode;
-            CloneOptions options;
-            options.fromDB = db;
-            options.logForRepl = false;
-            options.slaveOk = true;
-            options.useReplAuth = true;
-            options.snapshot = false;
-            options.mayYield = true;
-            options.mayBeInterrupted = false;
-            options.syncData = dataPass;
-            options.syncIndexes = ! dataPass;
-
-            if (!cloner.go(master, options, err, &errCode)) {
-                sethbmsg(str::stream() << "initial sync: error while "
-                                       << (dataPass ? "cloning " : "indexing ") << db
-                                       << ".  " << (err.empty() ? "" : err + ".  ")
-                                       << "sleeping 5 minutes" ,0);
-                return false;
+            if( *i != "local" )
+                toClone.push_back(*i);
+        }
+
+        // each database's foreground index builds hold its write lock, so they go one at a time
+        // within a database, but different databases can build side by side
+        if ( !dataPass && initialSyncCloneThreads > 1 && toClone.size() > 1 ) {
+            IndexPassWork work(toClone);
+            int nThreads = std::min( initialSyncCloneThreads, static_cast<int>(toClone.size()) );
+            boost::thread_group threads;
+            for ( int i = 0; i < nThreads; i++ ) {
+                threads.create_thread( boost::bind( &indexPassThread, string(master), &work ) );
             }
+            threads.join_all();
+            return !work.failed;
+        }
+
+        for( list<string>::const_iterator i = toClone.begin(); i != toClone.end(); i++ ) {
+            if ( !cloneDB(cloner, master, *i, dataPass) )
+                return false;
         }
 
         return true;
@@ -25,7 +25,12 @@
 #include "mongo/db/client.h"
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/d_concurrency.h"
+#include "mongo/db/databaseholder.h"
+#include "mongo/db/hasher.h"
+#include "mongo/db/instance.h"
 #include "mongo/db/namespacestring.h"
+#include "mongo/db/pagefault.h"
+#include "mongo/db/pdfile.h"
 #include "mongo/db/prefetch.h"
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/oplog.h"
@@ -33,6 +38,7 @@
 #include "mongo/db/repl/rs_sync.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/db/commands/server_status.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/base/counter.h"
 
@@ -59,6 +65,15 @@ namespace replset {
     static ServerStatusMetricField<Counter64> displayOpsApplied( "repl.apply.ops",
                                                                 &opsAppliedStats );
 
+    // When set, writes to a document go to the writer chosen by (ns, _id) rather than by ns
+    // alone, so that one busy collection is applied by all the writers.  See fillWriterVectors().
+    static bool replWriterHashById = false;
+    static ExportedServerParameter<bool> ReplWriterHashByIdSetting(ServerParameterSet::getGlobal(),
+                                                                   "replWriterHashById",
+                                                                   &replWriterHashById,
+                                                                   true,
+                                                                   true);
+
 
     SyncTail::SyncTail(BackgroundSyncInterface *q) :
         Sync(""), oplogVersion(0), _networkQueue(q)
@@ -88,31 +103,53 @@ namespace replset {
 
         bool isCommand(op["op"].valuestrsafe()[0] == 'c');
 
-        boost::scoped_ptr<Lock::ScopedLock> lk;
-
-        if(isCommand) {
-            // a command may need a global write lock. so we will conservatively go 
-            // ahead and grab one here. suboptimal. :-(
-            lk.reset(new Lock::GlobalWrite());
-        } else {
-            // DB level lock for this operation
-            lk.reset(new Lock::DBWrite(ns)); 
+        // when writes to one collection are spread over the writers, let a writer that needs
+        // a page from disk step out of the lock for it rather than hold up the others
+        boost::scoped_ptr<PageFaultRetryableSection> retryable;
+        if (!isCommand && replWriterHashById) {
+            retryable.reset(new PageFaultRetryableSection());
         }
 
-        Client::Context ctx(ns, dbpath);
-        ctx.getClient()->curop()->reset();
-        // For non-initial-sync, we convert updates to upserts
-        // to suppress errors when replaying oplog entries.
-        bool ok = !applyOperation_inlock(op, true, convertUpdateToUpsert);
-        opsAppliedStats.increment();
-        getDur().commitIfNeeded();
+        while (1) {
+            try {
+                boost::scoped_ptr<Lock::ScopedLock> lk;
+
+                if(isCommand) {
+                    // a command may need a global write lock. so we will conservatively go 
+                    // ahead and grab one here. suboptimal. :-(
+                    lk.reset(new Lock::GlobalWrite());
+                } else {
+                    // A collection lock where it suffices, so that writers given the ops of one
+                    // collection by _id only exclude each other while they hold it, and a
+                    // writer waiting on a page fault lets the others in.  Writes within a
+                    // collection still go one at a time: record allocation and the btrees
+                    // aren't safe for concurrent writers.
+                    lk.reset(lockForWrite(ns));
+                }
+
+                Client::Context ctx(ns, dbpath);
+                ctx.getClient()->curop()->reset();
+                // For non-initial-sync, we convert updates to upserts
+                // to suppress errors when replaying oplog entries.
+                bool ok = !applyOperation_inlock(op, true, convertUpdateToUpsert);
+                opsAppliedStats.increment();
+                getDur().commitIfNeeded();
 
-        return ok;
+                return ok;
+            }
+            catch (PageFaultException& e) {
+                e.touch();
+            }
+        }
     }
 
     void initializePrefetchThread() {
         if (!ClientBasic::getCurrent()) {
             Client::initThread("repl prefetch worker");
+            // Prefetching the next ops must go on while the writers apply a batch, or the
+            // prefetch stage would wait out every batch.  The prefetcher only pages data in and
+            // never returns what it reads, so seeing a batch half applied does no harm.
+            Lock::ParallelBatchWriterMode::iAmABatchParticipant();
             replLocalAuth();
         }
     }
@@ -235,9 +272,9 @@ namespace replset {
     // Doles out all the work to the writer pool threads and waits for them to complete
     void SyncTail::multiApply( std::deque<BSONObj>& ops, MultiSyncApplyFunc applyFunc ) {
 
-        // Use a ThreadPool to prefetch all the operations in a batch.
-        prefetchOps(ops);
-        
+        // the ops were prefetched by the background sync prefetch stage on their way into the
+        // queue, so the pages they need should already be in memory
+
         std::vector< std::vector<BSONObj> > writerVectors(theReplSet->replWriterThreadCount);
         fillWriterVectors(ops, &writerVectors);
         LOG(1) << "replication batch size is " << ops.size() << endl;
@@ -246,15 +283,84 @@ namespace replset {
         // because all readers are blocked anyway.
         SimpleMutex::scoped_lock fsynclk(filesLockedFsync);
 
-        // stop all readers until we're done
+        // stop all readers until we're done, except the prefetch workers
         Lock::ParallelBatchWriterMode pbwm;
 
         applyOps(writerVectors, applyFunc);
     }
 
 
+    /**
+     * @return the _id of the single document op writes, or eoo if it isn't an insert, update
+     * or delete of a document named by its _id.
+     */
+    static BSONElement writtenDocumentId(const BSONObj& op) {
+        BSONElement id;
+        switch (*op.getStringField("op")) {
+        case 'i':
+        case 'd':
+            id = op.getObjectField("o")["_id"];
+            break;
+        case 'u':
+            id = op.getObjectField("o2")["_id"];
+            break;
+        default:
+            return BSONElement();
+        }
+        // an operator expression could match any number of documents
+        if (id.type() == Object && id.embeddedObject().firstElementFieldName()[0] == '$')
+            return BSONElement();
+        return id;
+    }
+
+    /**
+     * Whether writes to different documents of ns can be applied in any order.  That isn't so
+     * for capped collections (insertion order is the natural order), for collections with
+     * unique secondary indexes (a reordered pair of writes may collide on a key), or for
+     * collections that don't exist yet (the first write creates them).  Nothing that changes
+     * this can happen within a batch: index builds and commands are batches of their own.
+     */
+    static bool writesCommute(const string& ns) {
+        if (NamespaceString(ns).isSystem() || NamespaceString::special(ns.c_str()))
+            return false;
+
+        Lock::DBRead lk(ns);
+        Database* db = dbHolder().get(ns, dbpath);
+        if (!db)
+            return false;
+        NamespaceDetails* d = db->namespaceIndex.details(ns.c_str());
+        if (!d || d->isCapped() || d->indexBuildsInProgress)
+            return false;
+        NamespaceDetails::IndexIterator i = d->ii();
+        while (i.more()) {
+            IndexDetails& idx = i.next();
+            if (idx.unique() && !idx.isIdIndex())
+                return false;
+        }
+        return true;
+    }
+
     void SyncTail::fillWriterVectors(const std::deque<BSONObj>& ops, 
                                               std::vector< std::vector<BSONObj> >* writerVectors) {
+        // Normally all of a namespace's ops go to one writer, in oplog order.  With
+        // replWriterHashById, ops on a namespace whose document writes commute are spread
+        // by _id instead: each document's ops still reach one writer in order.  A namespace
+        // with any op in the batch that doesn't name a document by _id stays on one writer
+        // for the whole batch, which keeps that op ordered against the rest.
+        std::map<string, bool> byId;
+        if (replWriterHashById && theReplSet->oplogVersion > 1) {
+            for (std::deque<BSONObj>::const_iterator it = ops.begin();
+                 it != ops.end();
+                 ++it) {
+                const string ns = it->getStringField("ns");
+                std::map<string, bool>::iterator i = byId.find(ns);
+                if (i == byId.end())
+                    i = byId.insert(make_pair(ns, writesCommute(ns))).first;
+                if (i->second && writtenDocumentId(*it).eoo())
+                    i->second = false;
+            }
+        }
+
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
              ++it) {
@@ -265,6 +371,12 @@ namespace replset {
             uint32_t hash = 0;
             MurmurHash3_x86_32( ns, len, 0, &hash);
 
+            if (!byId.empty() && byId[ns]) {
+                long long idHash = BSONElementHasher::hash64(writtenDocumentId(*it),
+                                                             BSONElementHasher::DEFAULT_HASH_SEED);
+                hash ^= static_cast<uint32_t>(idHash ^ (idHash >> 32));
+            }
+
             (*writerVectors)[hash % writerVectors->size()].push_back(*it);
         }
     }
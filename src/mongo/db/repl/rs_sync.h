@@ -67,6 +67,10 @@ namespace replset {
         void oplogApplication();
         bool peek(BSONObj* obj);
 
+        // Doles out all the work to the reader pool threads and waits for them to complete.
+        // Called by the background sync prefetch stage before ops reach the apply buffer.
+        static void prefetchOps(const std::deque<BSONObj>& ops);
+
         class OpQueue {
         public:
             OpQueue() : _size(0) {}
@@ -101,18 +105,21 @@ namespace replset {
         static const int replBatchLimitSeconds = 1;
         static const unsigned int replBatchLimitOperations = 5000;
 
-        // Prefetch and write a deque of operations, using the supplied function.
+        // Write a deque of operations, using the supplied function.
         // Initial Sync and Sync Tail each use a different function.
         void multiApply(std::deque<BSONObj>& ops, MultiSyncApplyFunc applyFunc);
 
         // The version of the last op to be read
         int oplogVersion;
 
+        // Deals the ops out to the writers: the ops of each namespace, or of each document with
+        // replWriterHashById, go to one writer in oplog order.
+        void fillWriterVectors(const std::deque<BSONObj>& ops, 
+                               std::vector< std::vector<BSONObj> >* writerVectors);
+
     private:
         BackgroundSyncInterface* _networkQueue;
 
-        // Doles out all the work to the reader pool threads and waits for them to complete
-        void prefetchOps(const std::deque<BSONObj>& ops);
         // Used by the thread pool readers to prefetch an op
         static void prefetchOp(const BSONObj& op);
 
@@ -120,8 +127,6 @@ namespace replset {
         void applyOps(const std::vector< std::vector<BSONObj> >& writerVectors, 
                       MultiSyncApplyFunc applyFunc);
 
-        void fillWriterVectors(const std::deque<BSONObj>& ops, 
-                               std::vector< std::vector<BSONObj> >* writerVectors);
         void handleSlaveDelay(const BSONObj& op);
         void setOplogVersion(const BSONObj& op);
     };
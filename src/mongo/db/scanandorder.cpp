@@ -22,7 +22,10 @@
 
 #include "mongo/db/scanandorder.h"
 
+#include <algorithm>
+
 #include "mongo/db/index/btree_key_generator.h"
+#include "mongo/db/key_string.h"
 #include "mongo/db/matcher.h"
 #include "mongo/db/parsed_query.h"
 #include "mongo/util/mongoutils/str.h"
@@ -31,6 +34,18 @@ namespace mongo {
 
     const unsigned ScanAndOrder::MaxScanAndOrderBytes = 32 * 1024 * 1024;
 
+    ScanAndOrder::ScanAndOrder(int startFrom, int limit, const BSONObj &order,
+                               const FieldRangeSet &frs) :
+        _isHeap(false),
+        _nextSeq(0),
+        _startFrom(startFrom),
+        _order(order, frs),
+        _firstFieldDescending(order.firstElement().number() < 0),
+        _cmp(Ordering::make(order)),
+        _approxSize(0) {
+        _limit = limit > 0 ? limit + _startFrom : 0x7fffffff;
+    }
+
     void ScanAndOrder::add(const BSONObj& o, const DiskLoc* loc) {
         verify( o.isValid() );
         BSONObj k;
@@ -53,13 +68,31 @@ namespace mongo {
             _add(k, o, loc);
             return;
         }
-        BestMap::iterator i;
-        verify( _best.end() != _best.begin() );
-        i = _best.end();
-        i--;
-        _addIfBetter(k, o, i, loc);
+
+        if ( !_isHeap ) {
+            make_heap(_best.begin(), _best.end(), _cmp);
+            _isHeap = true;
+        }
+
+        // the worst of the best is on top of the heap; only something strictly better than it
+        // gets in, as the first of several equal keys stays ahead of the rest
+        Entry candidate;
+        candidate.prefix = _keyPrefix(k);
+        candidate.key = k;
+        if ( _cmp.compareKeys(candidate, _best.front()) >= 0 ) {
+            return;
+        }
+        pop_heap(_best.begin(), _best.end(), _cmp);
+        _validateAndUpdateApproxSize( -_best.back().key.objsize() + -_best.back().doc.objsize() );
+        _best.pop_back();
+        _add(k, o, loc);
+        push_heap(_best.begin(), _best.end(), _cmp);
     }
 
+    unsigned long long ScanAndOrder::_keyPrefix(const BSONObj& k) const {
+        unsigned long long prefix = KeyString::firstFieldPrefix(k);
+        return _firstFieldDescending ? ~prefix : prefix;
+    }
 
     void ScanAndOrder::fill( BufBuilder& b, const ParsedQuery *parsedQuery, int& nout ) const {
         int n = 0;
@@ -74,11 +107,20 @@ namespace mongo {
             details.reset( new MatchDetails );
             details->requestElemMatchKey();
         }
-        for ( BestMap::const_iterator i = _best.begin(); i != _best.end(); i++ ) {
+
+        // only the results we send back need to be put in order
+        vector<const Entry*> sorted;
+        sorted.reserve(_best.size());
+        for ( vector<Entry>::const_iterator i = _best.begin(); i != _best.end(); ++i ) {
+            sorted.push_back(&*i);
+        }
+        sort(sorted.begin(), sorted.end(), _cmp);
+
+        for ( vector<const Entry*>::const_iterator i = sorted.begin(); i != sorted.end(); ++i ) {
             n++;
             if ( n <= _startFrom )
                 continue;
-            const BSONObj& o = i->second;
+            const BSONObj& o = (*i)->doc;
             massert( 16355, "positional operator specified, but no array match",
                      ! arrayMatcher || arrayMatcher->matches( o, details.get() ) );
             fillQueryResultFromObj( b, projection, o, details.get() );
@@ -98,19 +140,12 @@ namespace mongo {
             docToReturn = b.obj();
         }
         _validateAndUpdateApproxSize( k.objsize() + docToReturn.objsize() );
-        _best.insert(make_pair(k.getOwned(),docToReturn.getOwned()));
-    }
-    
-    void ScanAndOrder::_addIfBetter(const BSONObj& k, const BSONObj& o, const BestMap::iterator& i,
-                                    const DiskLoc* loc) {
-        const BSONObj& worstBestKey = i->first;
-        int cmp = worstBestKey.woCompare(k, _order._keyPattern);
-        if ( cmp > 0 ) {
-            // k is better, 'upgrade'
-            _validateAndUpdateApproxSize( -i->first.objsize() + -i->second.objsize() );
-            _best.erase(i);
-            _add(k, o, loc);
-        }
+        Entry e;
+        e.prefix = _keyPrefix(k);
+        e.key = k.getOwned();
+        e.doc = docToReturn.getOwned();
+        e.seq = _nextSeq++;
+        _best.push_back(e);
     }
 
     void ScanAndOrder::_validateAndUpdateApproxSize( const int approxSizeDelta ) {
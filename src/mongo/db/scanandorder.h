@@ -75,17 +75,11 @@ namespace mongo {
         }
     }
 
-    typedef multimap<BSONObj,BSONObj,BSONObjCmp> BestMap;
     class ScanAndOrder {
     public:
         static const unsigned MaxScanAndOrderBytes;
 
-        ScanAndOrder(int startFrom, int limit, const BSONObj &order, const FieldRangeSet &frs) :
-            _best( BSONObjCmp( order ) ),
-            _startFrom(startFrom), _order(order, frs) {
-            _limit = limit > 0 ? limit + _startFrom : 0x7fffffff;
-            _approxSize = 0;
-        }
+        ScanAndOrder(int startFrom, int limit, const BSONObj &order, const FieldRangeSet &frs);
 
         int size() const { return _best.size(); }
 
@@ -105,10 +99,39 @@ namespace mongo {
 
     private:
 
-        void _add(const BSONObj& k, const BSONObj& o, const DiskLoc* loc);
+        /** A candidate result.  Ordered by sort key, then by when it was added. */
+        struct Entry {
+            unsigned long long prefix; // first key field, see _keyPrefix()
+            BSONObj key;
+            BSONObj doc;
+            unsigned long long seq;
+        };
+
+        /** orders Entries: a < b if a comes first in the results */
+        class EntryCmp {
+        public:
+            explicit EntryCmp(const Ordering& ordering) : _ordering(ordering) {}
+            bool operator()(const Entry& a, const Entry& b) const {
+                int x = compareKeys(a, b);
+                return x != 0 ? x < 0 : a.seq < b.seq;
+            }
+            bool operator()(const Entry* a, const Entry* b) const { return (*this)(*a, *b); }
+            int compareKeys(const Entry& a, const Entry& b) const {
+                if ( a.prefix != b.prefix )
+                    return a.prefix < b.prefix ? -1 : 1;
+                return a.key.woCompare(b.key, _ordering, false);
+            }
+        private:
+            Ordering _ordering;
+        };
+
+        /**
+         * @return an integer that orders like the first field of k in the sort order, so that
+         * most comparisons never look at the keys themselves
+         */
+        unsigned long long _keyPrefix(const BSONObj& k) const;
 
-        void _addIfBetter(const BSONObj& k, const BSONObj& o, const BestMap::iterator& i,
-                          const DiskLoc* loc);
+        void _add(const BSONObj& k, const BSONObj& o, const DiskLoc* loc);
 
         /**
          * @throw ScanAndOrderMemoryLimitExceededAssertionCode if approxSize would grow too high,
@@ -116,10 +139,18 @@ namespace mongo {
          */
         void _validateAndUpdateApproxSize( const int approxSizeDelta );
 
-        BestMap _best; // key -> full object
+        /*
+          Until there are _limit of them, the candidates are just appended.  After that _best
+          is a heap with the worst candidate on top, which a better one replaces.
+        */
+        vector<Entry> _best;
+        bool _isHeap;
+        unsigned long long _nextSeq;
         int _startFrom;
         int _limit;   // max to send back.
         KeyType _order;
+        bool _firstFieldDescending;
+        EntryCmp _cmp;
         unsigned _approxSize;
 
     };
@@ -415,7 +415,7 @@ namespace mongo {
 
                 SortedFileWriter<Key, Value> writer(_settings);
                 for ( ; !_data.empty(); _data.pop_front()) {
-                    writer.addAlreadySorted(_data.front().first, _data.back().second);
+                    writer.addAlreadySorted(_data.front().first, _data.front().second);
                 }
 
                 _iters.push_back(boost::shared_ptr<Iterator>(writer.done()));
@@ -619,7 +619,15 @@ namespace mongo {
     // SortedFileWriter
     //
 
-    static AtomicUInt fileCounter;
+    namespace sorter {
+        // this file is included by several translation units; an inline function's static has a
+        // single instance across all of them, so their file names don't collide
+        inline unsigned nextFileNumber() {
+            static AtomicUInt fileCounter;
+            return fileCounter++;
+        }
+    }
+
     template <typename Key, typename Value>
     SortedFileWriter<Key, Value>::SortedFileWriter(const Settings& settings)
         : _settings(settings)
@@ -627,7 +635,7 @@ namespace mongo {
         {
             StringBuilder sb;
             // TODO use tmpPath rather than dbpath/_tmp
-            sb << dbpath << "/_tmp" << "/extsort." << fileCounter++;
+            sb << dbpath << "/_tmp" << "/extsort." << sorter::nextFileNumber();
             _fileName = sb.str();
         }
 
@@ -22,6 +22,7 @@
 #include "mongo/db/btreecursor.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/instance.h"
+#include "mongo/db/intersection_cursor.h"
 #include "mongo/db/json.h"
 #include "mongo/db/query_optimizer.h"
 #include "mongo/db/queryutil.h"
@@ -770,6 +771,152 @@ namespace CursorTests {
 
     } // namespace ClientCursor
     
+    namespace IntersectionCursor {
+
+        using mongo::IntersectionCursor;
+
+        class Base {
+        public:
+            Base() {
+                _c.dropCollection( ns() );
+                _c.ensureIndex( ns(), BSON( "a" << 1 ) );
+                _c.ensureIndex( ns(), BSON( "b" << 1 ) );
+            }
+            virtual ~Base() { _c.dropCollection( ns() ); }
+        protected:
+            static const char *ns() { return "unittests.cursortests.IntersectionCursor"; }
+            DBDirectClient _c;
+            /** @return a cursor over the 'keyPattern' index, bounded by 'spec'. */
+            shared_ptr<Cursor> indexCursor( const BSONObj& keyPattern, const BSONObj& spec ) {
+                NamespaceDetails* d = nsdetails( ns() );
+                FieldRangeSet frs( ns(), spec, true, true );
+                shared_ptr<FieldRangeVector> frv( new FieldRangeVector( frs, keyPattern, 1 ) );
+                int idxNo = d->findIndexByKeyPattern( keyPattern );
+                return shared_ptr<Cursor>( mongo::BtreeCursor::make( d, d->idx( idxNo ),
+                                                                     frv, 0, 1 ) );
+            }
+            /** Check that 'c' returns each document matching 'query' once. */
+            void checkMatches( Cursor* c, const BSONObj& query ) {
+                set<DiskLoc> expected;
+                for( shared_ptr<Cursor> all = theDataFileMgr.findAll( ns() ); all->ok();
+                     all->advance() ) {
+                    if ( Matcher( query ).matches( all->current() ) ) {
+                        expected.insert( all->currLoc() );
+                    }
+                }
+                set<DiskLoc> found;
+                for( ; c->ok(); c->advance() ) {
+                    ASSERT( found.insert( c->currLoc() ).second );
+                }
+                ASSERT( expected == found );
+            }
+        };
+
+        /** Single point cursors are merged in DiskLoc order. */
+        class MergePoints : public Base {
+        public:
+            void run() {
+                for( int i = 0; i < 60; ++i ) {
+                    _c.insert( ns(), BSON( "a" << i % 3 << "b" << i % 5 ) );
+                }
+                Client::ReadContext ctx( ns() );
+                vector<shared_ptr<Cursor> > cursors;
+                cursors.push_back( indexCursor( BSON( "a" << 1 ), BSON( "a" << 1 ) ) );
+                cursors.push_back( indexCursor( BSON( "b" << 1 ), BSON( "b" << 2 ) ) );
+                scoped_ptr<IntersectionCursor> c( IntersectionCursor::make( cursors, true ) );
+                ASSERT_EQUALS( 4, countInOrder( c.get() ) );
+            }
+        private:
+            int countInOrder( Cursor* c ) {
+                int count = 0;
+                DiskLoc last;
+                for( ; c->ok(); c->advance() ) {
+                    ASSERT( last < c->currLoc() );
+                    ASSERT_EQUALS( 1, c->current()[ "a" ].number() );
+                    ASSERT_EQUALS( 2, c->current()[ "b" ].number() );
+                    last = c->currLoc();
+                    ++count;
+                }
+                return count;
+            }
+        };
+
+        /** Range cursors over a multikey index are intersected by location, without dups. */
+        class HashRanges : public Base {
+        public:
+            void run() {
+                for( int i = 0; i < 60; ++i ) {
+                    _c.insert( ns(), BSON( "a" << i << "b" << BSON_ARRAY( i % 5 << i % 5 + 1 ) ) );
+                }
+                Client::ReadContext ctx( ns() );
+                vector<shared_ptr<Cursor> > cursors;
+                cursors.push_back( indexCursor( BSON( "a" << 1 ),
+                                                BSON( "a" << GTE << 20 << LT << 40 ) ) );
+                cursors.push_back( indexCursor( BSON( "b" << 1 ), BSON( "b" << LTE << 2 ) ) );
+                scoped_ptr<IntersectionCursor> c(
+                        IntersectionCursor::make( cursors, false,
+                                                  indexCursor( BSON( "a" << 1 ),
+                                                               BSON( "a" << GTE << 20 <<
+                                                                     LT << 40 ) ) ) );
+                checkMatches( c.get(), fromjson( "{a:{$gte:20,$lt:40},b:{$lte:2}}" ) );
+            }
+        };
+
+        /** Nothing is returned once a cursor with no keys is exhausted. */
+        class HashEmptyCursor : public Base {
+        public:
+            void run() {
+                for( int i = 0; i < 20; ++i ) {
+                    _c.insert( ns(), BSON( "a" << i << "b" << i ) );
+                }
+                Client::ReadContext ctx( ns() );
+                vector<shared_ptr<Cursor> > cursors;
+                cursors.push_back( indexCursor( BSON( "a" << 1 ), BSON( "a" << GTE << 0 ) ) );
+                cursors.push_back( indexCursor( BSON( "b" << 1 ), BSON( "b" << GT << 100 ) ) );
+                scoped_ptr<IntersectionCursor> c(
+                        IntersectionCursor::make( cursors, false,
+                                                  indexCursor( BSON( "a" << 1 ),
+                                                               BSON( "a" << GTE << 0 ) ) ) );
+                ASSERT( !c->ok() );
+                // The empty cursor stopped the scan before the other was exhausted.
+                ASSERT( c->nscanned() < 20 );
+            }
+        };
+
+        /**
+         * With too many locations to remember, the rest of the first index's documents are
+         * returned instead, each once, whether or not that index is multikey.
+         */
+        class HashFallback : public Base {
+        public:
+            void run() {
+                for( int i = 0; i < 60; ++i ) {
+                    _c.insert( ns(), BSON( "a" << i << "b" << BSON_ARRAY( i % 5 << i % 5 + 1 ) ) );
+                }
+                Client::ReadContext ctx( ns() );
+                BSONObj aSpec = BSON( "a" << GTE << 20 << LT << 40 );
+                BSONObj bSpec = BSON( "b" << LTE << 2 );
+
+                vector<shared_ptr<Cursor> > cursors;
+                cursors.push_back( indexCursor( BSON( "a" << 1 ), aSpec ) );
+                cursors.push_back( indexCursor( BSON( "b" << 1 ), bSpec ) );
+                scoped_ptr<IntersectionCursor> c(
+                        IntersectionCursor::make( cursors, false,
+                                                  indexCursor( BSON( "a" << 1 ), aSpec ), 5 ) );
+                checkMatches( c.get(), fromjson( "{a:{$gte:20,$lt:40}}" ) );
+
+                // The multikey index first.
+                cursors.clear();
+                cursors.push_back( indexCursor( BSON( "b" << 1 ), bSpec ) );
+                cursors.push_back( indexCursor( BSON( "a" << 1 ), aSpec ) );
+                c.reset( IntersectionCursor::make( cursors, false,
+                                                   indexCursor( BSON( "b" << 1 ), bSpec ), 5 ) );
+                checkMatches( c.get(), fromjson( "{b:{$lte:2}}" ) );
+            }
+        };
+
+    } // namespace IntersectionCursor
+
     class All : public Suite {
     public:
         All() : Suite( "cursor" ) {}
@@ -797,6 +944,10 @@ namespace CursorTests {
             add<ClientCursor::Pin::PinCursor>();
             add<ClientCursor::Pin::PinTwice>();
             add<ClientCursor::Pin::CursorDeleted>();
+            add<IntersectionCursor::MergePoints>();
+            add<IntersectionCursor::HashRanges>();
+            add<IntersectionCursor::HashEmptyCursor>();
+            add<IntersectionCursor::HashFallback>();
         }
     } myall;
 } // namespace CursorTests
@@ -23,6 +23,7 @@
 
 #include "mongo/db/interrupt_status_mongod.h"
 #include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/server_parameters.h"
 
 #include "dbtests.h"
 
@@ -44,6 +45,19 @@ namespace DocumentSourceTests {
         }
     };
 
+    /** Lowers the memory limit of $group and $sort, so that they spill with allowDiskUse. */
+    class MaxMemoryUsageBytesSetter {
+    public:
+        MaxMemoryUsageBytesSetter( int bytes ) : _old( aggregationMaxMemoryUsageBytes ) {
+            aggregationMaxMemoryUsageBytes = bytes;
+        }
+        ~MaxMemoryUsageBytesSetter() {
+            aggregationMaxMemoryUsageBytes = _old;
+        }
+    private:
+        int _old;
+    };
+
     namespace DocumentSourceClass {
         using mongo::DocumentSource;
 
@@ -373,7 +387,8 @@ namespace DocumentSourceTests {
 
         class Base : public DocumentSourceCursor::Base {
         protected:
-            void createGroup( const BSONObj &spec, bool inShard = false ) {
+            void createGroup( const BSONObj &spec, bool inShard = false,
+                              bool allowDiskUse = false, DocumentSource* input = NULL ) {
                 BSONObj namedSpec = BSON( "$group" << spec );
                 BSONElement specElement = namedSpec.firstElement();
                 intrusive_ptr<ExpressionContext> expressionContext =
@@ -381,9 +396,10 @@ namespace DocumentSourceTests {
                 if ( inShard ) {
                     expressionContext->setInShard( true );
                 }
+                expressionContext->setExtSortAllowed( allowDiskUse );
                 _group = DocumentSourceGroup::createFromBson( &specElement, expressionContext );
                 assertRoundTrips( _group );
-                _group->setSource( source() );
+                _group->setSource( input ? input : source() );
             }
             DocumentSource* group() { return _group.get(); }
             /** Assert that iterator state accessors consistently report the source is exhausted. */
@@ -894,6 +910,98 @@ namespace DocumentSourceTests {
             string expectedResultSetString() { return "[{_id:[1,2,3],a:[[4,5,6]]}]"; }
         };
 
+        /**
+         * Enough keys to grow the group table several times, with accumulators kept both inline
+         * in the table and per group.
+         */
+        class ManyKeysMixedAccumulators : public CheckResultsBase {
+            void populateData() {
+                for( int i = 0; i < 1000; ++i ) {
+                    client.insert( ns, BSON( "id" << i % 500 << "a" << i ) );
+                }
+            }
+            BSONObj groupSpec() {
+                return fromjson( "{_id:'$id',sum:{$sum:'$a'},avg:{$avg:'$a'},"
+                                 "first:{$first:'$a'},list:{$push:'$a'}}" );
+            }
+            BSONObj expectedResultSet() {
+                BSONArrayBuilder expected;
+                for( int i = 0; i < 500; ++i ) {
+                    expected << BSON( "_id" << i << "sum" << 2 * i + 500 << "avg" << i + 250.0
+                                      << "first" << i << "list" << BSON_ARRAY( i << i + 500 ) );
+                }
+                return expected.arr();
+            }
+        };
+
+        /** Groups spilled to disk with allowDiskUse merge to the groups built in memory. */
+        class SpillToDisk : public Base {
+        public:
+            void run() {
+                for( int i = 0; i < 2000; ++i ) {
+                    client.insert( ns, BSON( "id" << ( i * 7 ) % 500 << "a" << i ) );
+                }
+                BSONObj spec = fromjson( "{_id:'$id',sum:{$sum:'$a'},avg:{$avg:'$a'},"
+                                         "min:{$min:'$a'},max:{$max:'$a'}}" );
+
+                createSource();
+                createGroup( spec );
+                BSONObj inMemory = results();
+
+                MaxMemoryUsageBytesSetter setter( 4096 );
+                createSource();
+                createGroup( spec, false, true );
+                ASSERT_EQUALS( inMemory, results() );
+                ASSERT_EQUALS( 500, inMemory.nFields() );
+
+                // Over a $sort that has spilled too, each writes its runs to files of its own.
+                createSource();
+                intrusive_ptr<ExpressionContext> sortCtx =
+                        ExpressionContext::create( &InterruptStatusMongod::status );
+                sortCtx->setExtSortAllowed( true );
+                BSONObj sortSpec = BSON( "$sort" << BSON( "a" << -1 ) );
+                BSONElement sortElement = sortSpec.firstElement();
+                intrusive_ptr<DocumentSource> sort =
+                        mongo::DocumentSourceSort::createFromBson( &sortElement, sortCtx );
+                sort->setSource( source() );
+                createGroup( spec, false, true, sort.get() );
+                ASSERT_EQUALS( inMemory, results() );
+            }
+        private:
+            /** The group's results, sorted by _id. */
+            BSONObj results() {
+                IdMap resultSet;
+                for( bool more = !group()->eof(); more; more = group()->advance() ) {
+                    Document current = group()->getCurrent();
+                    resultSet[ current->getValue( "_id" ) ] = current;
+                }
+                BSONArrayBuilder bab;
+                for( IdMap::const_iterator i = resultSet.begin(); i != resultSet.end(); ++i ) {
+                    BSONObjBuilder bob;
+                    i->second->toBson( &bob );
+                    bab << bob.obj();
+                }
+                return bab.arr();
+            }
+        };
+
+        /** The memory limit can't be set to 0 or less. */
+        class MaxMemoryUsageBytesMustBePositive {
+        public:
+            void run() {
+                ServerParameter* limit = ServerParameterSet::getGlobal()->getMap().find(
+                        "aggregationMaxMemoryUsageBytes" )->second;
+                int old = aggregationMaxMemoryUsageBytes;
+                ASSERT_NOT_OK( limit->setFromString( "0" ) );
+                ASSERT_NOT_OK( limit->setFromString( "-1" ) );
+                ASSERT_NOT_OK( limit->set( BSON( "" << -1 ).firstElement() ) );
+                ASSERT_EQUALS( old, aggregationMaxMemoryUsageBytes );
+                ASSERT_OK( limit->setFromString( "1024" ) );
+                ASSERT_EQUALS( 1024, aggregationMaxMemoryUsageBytes );
+                aggregationMaxMemoryUsageBytes = old;
+            }
+        };
+
     } // namespace DocumentSourceGroup
 
     namespace DocumentSourceProject {
@@ -1434,6 +1542,40 @@ namespace DocumentSourceTests {
             }
         };
         
+        /** With allowDiskUse, a sort spilled to disk returns what the in-memory sort does. */
+        class SpillToDisk : public Base {
+        public:
+            void run() {
+                string pad( 100, 'x' );
+                for( int i = 0; i < 1000; ++i ) {
+                    client.insert( ns, BSON( "_id" << i << "a" << ( i * 7 ) % 1000 <<
+                                             "b" << BSON_ARRAY( i << "s" ) << "pad" << pad ) );
+                }
+
+                createSource();
+                createSort();
+                BSONObj inMemory = results();
+
+                MaxMemoryUsageBytesSetter setter( 4096 );
+                ctx()->setExtSortAllowed( true );
+                createSource();
+                createSort();
+                ASSERT_EQUALS( inMemory, results() );
+                ASSERT_EQUALS( 1000, inMemory.nFields() );
+                ASSERT_EQUALS( 0, inMemory.firstElement().Obj()[ "a" ].numberInt() );
+            }
+        private:
+            BSONObj results() {
+                BSONArrayBuilder bab;
+                for( bool more = !sort()->eof(); more; more = sort()->advance() ) {
+                    BSONObjBuilder bob;
+                    sort()->getCurrent()->toBson( &bob );
+                    bab << bob.obj();
+                }
+                return bab.arr();
+            }
+        };
+
     } // namespace DocumentSourceSort
 
     namespace DocumentSourceUnwind {
@@ -1806,6 +1948,9 @@ namespace DocumentSourceTests {
             add<DocumentSourceGroup::Dependencies>();
             add<DocumentSourceGroup::StringConstantIdAndAccumulatorExpressions>();
             add<DocumentSourceGroup::ArrayConstantAccumulatorExpression>();
+            add<DocumentSourceGroup::ManyKeysMixedAccumulators>();
+            add<DocumentSourceGroup::SpillToDisk>();
+            add<DocumentSourceGroup::MaxMemoryUsageBytesMustBePositive>();
 
             add<DocumentSourceProject::EofInit>();
             add<DocumentSourceProject::AdvanceInit>();
@@ -1839,6 +1984,7 @@ namespace DocumentSourceTests {
             add<DocumentSourceSort::MissingObjectWithinArray>();
             add<DocumentSourceSort::ExtractArrayValues>();
             add<DocumentSourceSort::Dependencies>();
+            add<DocumentSourceSort::SpillToDisk>();
 
             add<DocumentSourceUnwind::EofInit>();
             add<DocumentSourceUnwind::AdvanceInit>();
@@ -19,6 +19,7 @@
 #include "pch.h"
 
 #include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/field_path.h"
 #include "mongo/db/pipeline/value.h"
 
@@ -396,6 +397,89 @@ namespace DocumentTests {
             BSONObjBuilder objBuilder;
             BSONArrayBuilder arrBuilder;
         };
+
+        /** A lazy Document behaves like one converted up front. */
+        class FromBsonLazy {
+        public:
+            void run() {
+                BSONObjBuilder bob;
+                for (int i = 0; i < 20; i++)
+                    bob.append(string(str::stream() << "f" << i), i);
+                bob.append("sub", BSON("x" << 1 << "y" << BSON_ARRAY(BSON("z" << 2) << 3)));
+                const BSONObj obj = bob.obj();
+
+                const mongo::Document eager = fromBson(obj);
+
+                // lookups before the fields are loaded
+                mongo::Document lazy = mongo::Document::fromBsonLazy(obj);
+                ASSERT_EQUALS(lazy["f7"].getInt(), 7);
+                ASSERT(lazy["nothere"].missing());
+                ASSERT_EQUALS(lazy["sub"].getDocument()["x"].getInt(), 1);
+                ASSERT_EQUALS(Document::compare(lazy, eager), 0);
+                ASSERT_EQUALS(lazy.size(), eager.size());
+                ASSERT_EQUALS(getNthField(lazy, 20).first.toString(), "sub");
+
+                // unmodified, so toBson copies obj
+                lazy = mongo::Document::fromBsonLazy(obj);
+                ASSERT_EQUALS(toBson(lazy), obj);
+
+                // modified, so toBson must not use obj
+                MutableDocument md (lazy);
+                md["f0"] = mongo::Value(100);
+                md["sub"]["x"] = mongo::Value(200);
+                const BSONObj modified = toBson(md.freeze());
+                ASSERT_EQUALS(modified["f0"].numberInt(), 100);
+                ASSERT_EQUALS(modified["sub"]["x"].numberInt(), 200);
+                ASSERT_EQUALS(modified.nFields(), obj.nFields());
+                ASSERT_EQUALS(toBson(lazy), obj);
+            }
+        };
+
+        /** A sub-document taken from a lazy Document doesn't hold on to its parent's BSON. */
+        class LazySubDocumentSize {
+        public:
+            void run() {
+                const BSONObj obj = BSON("big" << string(1024 * 1024, 'x')
+                                      << "sub" << BSON("x" << 1));
+                mongo::Document lazy = mongo::Document::fromBsonLazy(obj.getOwned());
+                const mongo::Value sub = lazy["sub"];
+                ASSERT(lazy.getApproximateSize() > 1024U * 1024);
+                lazy = mongo::Document();
+
+                ASSERT_EQUALS(sub.getDocument()["x"].getInt(), 1);
+                ASSERT(sub.getApproximateSize() < 1024U);
+                // The copy is still written back out unconverted.
+                BSONObjBuilder bob;
+                sub.getDocument().toBson(&bob);
+                ASSERT_EQUALS(bob.obj(), BSON("x" << 1));
+            }
+        };
+
+        /** Only the fields in a ParsedDeps are kept. */
+        class FromBsonWithDeps {
+        public:
+            void run() {
+                const BSONObj obj = BSON("a" << 1
+                                      << "b" << BSON("c" << 2 << "d" << 3)
+                                      << "e" << BSON_ARRAY(BSON("c" << 4 << "d" << 5) << 6)
+                                      << "f" << 7
+                                      << "g" << 8);
+                const mongo::Document deps = fromBson(BSON("a" << true
+                                                        << "b" << BSON("c" << true)
+                                                        << "e" << BSON("c" << true)
+                                                        << "f" << BSON("c" << true)));
+
+                const BSONObj expected = BSON("a" << 1
+                                           << "b" << BSON("c" << 2)
+                                           << "e" << BSON_ARRAY(BSON("c" << 4)));
+
+                const mongo::Document doc = DocumentSource::documentFromBsonWithDeps(obj, deps);
+                ASSERT(doc["g"].missing());
+                ASSERT(doc["f"].missing());
+                ASSERT_EQUALS(doc["b"].getDocument().size(), 1U);
+                ASSERT_EQUALS(toBson(doc), expected);
+            }
+        };
     } // namespace Document
 
     namespace Value {
@@ -1341,7 +1425,34 @@ namespace DocumentTests {
                 ASSERT_EQUALS(val["a"][0]["b"][1]["c"].getInt(), 1234);
             }
         };
-        
+
+        /** Values, including arrays with missing elements, survive the Sorter's serialization. */
+        class SorterRoundTrip {
+        public:
+            void run() {
+                vector<Value> inner;
+                inner.push_back(Value());
+                inner.push_back(Value::createDocument(mongo::Document(BSON("a" << 1))));
+                vector<Value> array;
+                array.push_back(Value(5));
+                array.push_back(Value(inner));
+                array.push_back(Value());
+                assertSorterRoundTrips(Value(array));
+                assertSorterRoundTrips(Value("string"));
+                assertSorterRoundTrips(Value());
+            }
+        private:
+            void assertSorterRoundTrips(const Value& value) {
+                BufBuilder buf;
+                value.serializeForSorter(buf);
+                BufReader reader(buf.buf(), buf.len());
+                Value out = Value::deserializeForSorter(reader, Value::SorterDeserializeSettings());
+                ASSERT_EQUALS(0, Value::compare(value, out));
+                ASSERT_EQUALS(value.missing(), out.missing());
+                ASSERT(reader.atEof());
+            }
+        };
+
     } // namespace Value
 
     class All : public Suite {
@@ -1362,6 +1473,9 @@ namespace DocumentTests {
             add<Document::FieldIteratorSingle>();
             add<Document::FieldIteratorMultiple>();
             add<Document::AllTypesDoc>();
+            add<Document::FromBsonLazy>();
+            add<Document::LazySubDocumentSize>();
+            add<Document::FromBsonWithDeps>();
 
             add<Value::Int>();
             add<Value::Long>();
@@ -1438,6 +1552,7 @@ namespace DocumentTests {
             add<Value::AddToBsonArray>();
             add<Value::Compare>();
             add<Value::SubFields>();
+            add<Value::SorterRoundTrip>();
         }
     } myall;
     
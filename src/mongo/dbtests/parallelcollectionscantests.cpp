@@ -0,0 +1,287 @@
+// parallelcollectionscantests.cpp : ParallelCollectionScan unit tests.
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/db/instance.h"
+#include "mongo/db/json.h"
+#include "mongo/db/parallel_collection_scan.h"
+#include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/dbtests/dbtests.h"
+
+namespace ParallelCollectionScanTests {
+
+    static const int nDocs = 3000;
+
+    /** Padding that makes the collection large enough to be scanned on several threads. */
+    static const int largePadding = ParallelCollectionScan::MinParallelDataSize / nDocs + 100;
+
+    /** Sets parallelCollectionScanThreads for the life of the object. */
+    class ScanThreadsSetter {
+    public:
+        ScanThreadsSetter( int threads ) {
+            set( str::stream() << threads );
+        }
+        ~ScanThreadsSetter() {
+            set( "0" );
+        }
+    private:
+        static void set( const string& value ) {
+            ServerParameter* parameter = ServerParameterSet::getGlobal()->getMap().find
+                    ( "parallelCollectionScanThreads" )->second;
+            ASSERT_OK( parameter->setFromString( value ) );
+        }
+    };
+
+    class Base {
+    public:
+        Base( int padding = 100 ) {
+            _client.dropCollection( ns() );
+            for( int i = 0; i < nDocs; ++i ) {
+                _client.insert( ns(), BSON( "_id" << i << "a" << i % 10 <<
+                                            "s" << string( padding, 'x' ) ) );
+            }
+        }
+        virtual ~Base() { _client.dropCollection( ns() ); }
+    protected:
+        static const char* dbName() { return "unittests"; }
+        static const char* collName() { return "parallelcollectionscantests"; }
+        static const char* ns() { return "unittests.parallelcollectionscantests"; }
+        static NamespaceDetails* nsd() { return nsdetails( ns() ); }
+        DBDirectClient _client;
+    };
+
+    /** Collects the _ids a scanning thread matches. */
+    class IdSink : public ParallelCollectionScan::Sink {
+    public:
+        virtual bool consume( const BSONObj& obj ) {
+            ids.push_back( obj[ "_id" ].numberInt() );
+            return true;
+        }
+        vector<int> ids;
+    };
+
+    /** Each matching document goes to one thread's sink. */
+    class RunSinks : public Base {
+    public:
+        void run() {
+            Client::ReadContext ctx( ns() );
+            // The documents span several extents.
+            ASSERT( nsd()->firstExtent != nsd()->lastExtent );
+
+            OwnedPointerVector<ParallelCollectionScan::Sink> sinks;
+            for( int i = 0; i < 4; ++i ) {
+                sinks.mutableVector().push_back( new IdSink() );
+            }
+            ParallelCollectionScan scan( nsd(), BSON( "a" << 3 ) );
+            scan.run( sinks.vector() );
+
+            set<int> ids;
+            for( int i = 0; i < 4; ++i ) {
+                const vector<int>& found = static_cast<IdSink*>( sinks.vector()[ i ] )->ids;
+                for( vector<int>::const_iterator j = found.begin(); j != found.end(); ++j ) {
+                    ASSERT_EQUALS( 3, *j % 10 );
+                    ASSERT( ids.insert( *j ).second );
+                }
+            }
+            ASSERT_EQUALS( nDocs / 10, static_cast<int>( ids.size() ) );
+            ASSERT_EQUALS( static_cast<long long>( nDocs ), scan.nscanned() );
+        }
+    };
+
+    /** Matching documents are buffered for the caller, each once. */
+    class Next : public Base {
+    public:
+        void run() {
+            Client::ReadContext ctx( ns() );
+            ParallelCollectionScan scan( nsd(), fromjson( "{a:{$in:[1,2]}}" ) );
+            scan.start( 3 );
+            set<int> ids;
+            BSONObj obj;
+            while( scan.next( &obj ) ) {
+                int a = obj[ "a" ].numberInt();
+                ASSERT( a == 1 || a == 2 );
+                ASSERT( ids.insert( obj[ "_id" ].numberInt() ).second );
+            }
+            ASSERT_EQUALS( nDocs / 5, static_cast<int>( ids.size() ) );
+            ASSERT( !scan.next( &obj ) );
+        }
+    };
+
+    /** More matches than the buffer holds wait for the caller to read them. */
+    class NextFullBuffer : public Base {
+    public:
+        void run() {
+            for( int i = nDocs; i < static_cast<int>( ParallelCollectionScan::MaxBufferedDocs ) * 2;
+                 ++i ) {
+                _client.insert( ns(), BSON( "_id" << i ) );
+            }
+            Client::ReadContext ctx( ns() );
+            ParallelCollectionScan scan( nsd(), BSONObj() );
+            scan.start( 2 );
+            int count = 0;
+            BSONObj obj;
+            while( scan.next( &obj ) ) {
+                ++count;
+            }
+            ASSERT_EQUALS( static_cast<int>( ParallelCollectionScan::MaxBufferedDocs ) * 2,
+                           count );
+        }
+    };
+
+    /** A scan stopped early stops its threads. */
+    class StopEarly : public Base {
+    public:
+        void run() {
+            Client::ReadContext ctx( ns() );
+            ParallelCollectionScan scan( nsd(), BSONObj() );
+            scan.start( 4 );
+            BSONObj obj;
+            ASSERT( scan.next( &obj ) );
+            // The destructor stops the threads, which may be waiting on a full buffer.
+        }
+    };
+
+    /** A scanning thread's failure is reported to the caller. */
+    class ThreadFailure : public Base {
+    public:
+        void run() {
+            Client::ReadContext ctx( ns() );
+            OwnedPointerVector<ParallelCollectionScan::Sink> sinks;
+            sinks.mutableVector().push_back( new IdSink() );
+            sinks.mutableVector().push_back( new IdSink() );
+            // The query is invalid, so each thread's Matcher fails.
+            ParallelCollectionScan scan( nsd(), fromjson( "{a:{$bad:1}}" ) );
+            ASSERT_THROWS( scan.run( sinks.vector() ), UserException );
+        }
+    };
+
+    /**
+     * Scans stay on the calling thread by default, for small collections and for queries with
+     * $where.
+     */
+    class ThreadsFor : public Base {
+    public:
+        ThreadsFor() : Base( largePadding ) {}
+        void run() {
+            Client::ReadContext ctx( ns() );
+            ASSERT_EQUALS( 0, ParallelCollectionScan::threadsFor( nsd(), BSON( "a" << 1 ) ) );
+
+            ScanThreadsSetter threads( 4 );
+            ASSERT_EQUALS( 4, ParallelCollectionScan::threadsFor( nsd(), BSON( "a" << 1 ) ) );
+            ASSERT_EQUALS( 0, ParallelCollectionScan::threadsFor
+                                  ( nsd(), fromjson( "{$where:'this.a == 1'}" ) ) );
+            ASSERT_EQUALS( 0, ParallelCollectionScan::threadsFor
+                                  ( nsd(), fromjson( "{$or:[{a:1},{$where:'true'}]}" ) ) );
+            ASSERT_EQUALS( 0, ParallelCollectionScan::threadsFor
+                                  ( nsd(), fromjson( "{$and:[{a:1},{$nor:[{$where:'true'}]}]}" ) ) );
+
+            _client.dropCollection( ns() );
+            _client.insert( ns(), BSON( "a" << 1 ) );
+            ASSERT_EQUALS( 0, ParallelCollectionScan::threadsFor( nsd(), BSON( "a" << 1 ) ) );
+        }
+    };
+
+    /** count splits the scan among threads, applying skip and limit to the total. */
+    class Count : public Base {
+    public:
+        Count() : Base( largePadding ) {}
+        void run() {
+            ScanThreadsSetter threads( 4 );
+            {
+                Client::ReadContext ctx( ns() );
+                ASSERT_EQUALS( 4, ParallelCollectionScan::threadsFor( nsd(), BSON( "a" << 3 ) ) );
+            }
+            BSONObj query = BSON( "a" << 3 );
+            ASSERT_EQUALS( static_cast<unsigned long long>( nDocs / 10 ),
+                           _client.count( ns(), query ) );
+            ASSERT_EQUALS( static_cast<unsigned long long>( nDocs / 10 - 50 ),
+                           _client.count( ns(), query, 0, 0, 50 ) );
+            ASSERT_EQUALS( 0ULL, _client.count( ns(), query, 0, 0, nDocs ) );
+            // With a limit the scan stays on this thread, to stop early.
+            ASSERT_EQUALS( 20ULL, _client.count( ns(), query, 0, 20, 50 ) );
+            ASSERT_EQUALS( static_cast<unsigned long long>( nDocs / 5 ),
+                           _client.count( ns(), fromjson( "{a:{$in:[1,2]}}" ) ) );
+        }
+    };
+
+    /**
+     * An aggregation reads the scanning threads' matches, and one that stops early stops the
+     * threads before releasing its read lock.
+     */
+    class Aggregate : public Base {
+    public:
+        Aggregate() : Base( largePadding ) {}
+        void run() {
+            ScanThreadsSetter threads( 4 );
+
+            BSONObj result;
+            ASSERT( _client.runCommand( dbName(),
+                                        BSON( "aggregate" << collName() << "pipeline" <<
+                                              BSON_ARRAY( BSON( "$match" << BSON( "a" << 3 ) ) <<
+                                                          fromjson( "{$group:{_id:null,"
+                                                                    "n:{$sum:1},"
+                                                                    "ids:{$sum:'$_id'}}}" ) ) ),
+                                        result ) );
+            vector<BSONElement> groups = result[ "result" ].Array();
+            ASSERT_EQUALS( 1U, groups.size() );
+            ASSERT_EQUALS( nDocs / 10, groups[ 0 ][ "n" ].numberInt() );
+            // Each of 3, 13, 23, ... once.
+            long long sum = 0;
+            for( int i = 3; i < nDocs; i += 10 ) {
+                sum += i;
+            }
+            ASSERT_EQUALS( sum, groups[ 0 ][ "ids" ].numberLong() );
+
+            // The $limit disposes of the cursor source while the threads are scanning.
+            ASSERT( _client.runCommand( dbName(),
+                                        BSON( "aggregate" << collName() << "pipeline" <<
+                                              BSON_ARRAY( BSON( "$match" << BSON( "a" << 3 ) ) <<
+                                                          BSON( "$limit" << 5 ) ) ),
+                                        result ) );
+            ASSERT_EQUALS( 5U, result[ "result" ].Array().size() );
+            ASSERT( !Lock::isLocked() );
+
+            // The collection can be written, the scan having let go of it.
+            _client.insert( ns(), BSON( "_id" << nDocs << "a" << 3 ) );
+            ASSERT( _client.getLastError().empty() );
+            ASSERT_EQUALS( static_cast<unsigned long long>( nDocs / 10 + 1 ),
+                           _client.count( ns(), BSON( "a" << 3 ) ) );
+        }
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite( "parallelcollectionscan" ) {
+        }
+
+        void setupTests() {
+            add<RunSinks>();
+            add<Next>();
+            add<NextFullBuffer>();
+            add<StopEarly>();
+            add<ThreadFailure>();
+            add<ThreadsFor>();
+            add<Count>();
+            add<Aggregate>();
+        }
+    } myall;
+
+} // namespace ParallelCollectionScanTests
@@ -2910,7 +2910,9 @@ namespace QueryOptimizerCursorTests {
                     client.remove( ns(), BSON( "i" << i + 1 ) );
                 }
             }
-            // Best plan cleared by ~1000 writes.
+            // Best plan kept through ~1000 writes.
+            nPlans( 1 );
+            NamespaceDetailsTransient::get( ns() ).clearQueryCache();
             nPlans( 3 );
 
             shared_ptr<ParsedQuery> parsedQuery
@@ -251,6 +251,43 @@ namespace {
             }
         };
 
+        /** Separate indexes on two constrained fields are intersected when there is no sort. */
+        class IntersectionPlan : public Base {
+        public:
+            void run() {
+                Helpers::ensureIndex( ns(), BSON( "a" << 1 ), false, "a_1" );
+                Helpers::ensureIndex( ns(), BSON( "b" << 1 ), false, "b_1" );
+                BSONObj intersectKey = BSON( "$intersect" << BSON_ARRAY( BSON( "a" << 1 ) <<
+                                                                         BSON( "b" << 1 ) ) );
+                {
+                    shared_ptr<QueryPlanSet> qps = makeQps( BSON( "a" << 1 << "b" << 1 ) );
+                    ASSERT_EQUALS( 4, qps->nPlans() );
+                    int intersections = 0;
+                    for( QueryPlanSet::PlanVector::const_iterator i = qps->plans().begin();
+                         i != qps->plans().end(); ++i ) {
+                        if ( (*i)->isIntersection() ) {
+                            ASSERT_EQUALS( intersectKey, (*i)->cacheKey() );
+                            ++intersections;
+                        }
+                    }
+                    ASSERT_EQUALS( 1, intersections );
+                }
+
+                // No intersection plan is made for a sorted query.
+                ASSERT_EQUALS( 3, makeQps( BSON( "a" << 1 << "b" << 1 ),
+                                           BSON( "c" << 1 ) )->nPlans() );
+
+                // A recorded intersection plan is used alone.
+                NamespaceDetailsTransient::get( ns() ).registerCachedQueryPlanForPattern
+                        ( makePattern( BSON( "a" << 1 << "b" << 1 ), BSONObj() ),
+                          CachedQueryPlan( intersectKey, 1, CandidatePlanCharacter( true, false ) ) );
+                shared_ptr<QueryPlanSet> qps = makeQps( BSON( "a" << 1 << "b" << 1 ) );
+                ASSERT( qps->usingCachedPlan() );
+                ASSERT_EQUALS( 1, qps->nPlans() );
+                ASSERT( qps->firstPlan()->isIntersection() );
+            }
+        };
+
         class FindOne : public Base {
         public:
             void run() {
@@ -806,6 +843,7 @@ namespace {
             add<QueryPlanSetTests::Count>();
             add<QueryPlanSetTests::QueryMissingNs>();
             add<QueryPlanSetTests::UnhelpfulIndex>();
+            add<QueryPlanSetTests::IntersectionPlan>();
             add<QueryPlanSetTests::FindOne>();
             add<QueryPlanSetTests::Delete>();
             add<QueryPlanSetTests::DeleteOneScan>();
@@ -1655,6 +1655,37 @@ namespace QueryTests {
                 assertNumFilled( 1, t );
             }
         };
+
+        /** With a limit, the best results are kept and returned in order. */
+        class LimitKeepsBest : public Base {
+        public:
+            void run() {
+                FieldRangeSet frs( "n/a", BSONObj(), true, true );
+                Testable t( 1, 3, BSON( "a" << -1 << "b" << 1 ), frs );
+                int values[] = { 4, 9, 1, 7, 9, 3, 8, 12, 2 };
+                for ( int i = 0; i < (int)( sizeof( values ) / sizeof( values[0] ) ); ++i ) {
+                    t.add( BSON( "a" << values[ i ] << "b" << i ), 0 );
+                }
+                // the limit applies after skipping startFrom
+                ASSERT_EQUALS( 4, t.size() );
+
+                BufBuilder bb;
+                int nout;
+                t.fill( bb, 0, nout );
+                ASSERT_EQUALS( 3, nout );
+
+                // 12 is skipped; the two 9s keep their order on b
+                BSONObj expected[] = { BSON( "a" << 9 << "b" << 1 ),
+                                       BSON( "a" << 9 << "b" << 4 ),
+                                       BSON( "a" << 8 << "b" << 6 ) };
+                const char* data = bb.buf();
+                for ( int i = 0; i < nout; ++i ) {
+                    BSONObj o( data );
+                    ASSERT_EQUALS( expected[ i ], o );
+                    data += o.objsize();
+                }
+            }
+        };
         
     } // namespace ScanAndOrderTests
 
@@ -1729,6 +1760,7 @@ namespace QueryTests {
             
             add< ScanAndOrderTests::Unlimited >();
             add< ScanAndOrderTests::LimitOne >();
+            add< ScanAndOrderTests::LimitKeepsBest >();
         }
     } myall;
 
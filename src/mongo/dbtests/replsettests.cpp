@@ -27,6 +27,7 @@
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/rs.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/util/time_support.h"
 
@@ -1105,6 +1106,173 @@ namespace ReplSetTests {
         }
     };
 
+    class PrefetchOpsThread : public BackgroundJob {
+    public:
+        PrefetchOpsThread(const std::deque<BSONObj>& ops) : _ops(ops) {}
+        std::string name() const { return "prefetch ops helper"; }
+        void run() { replset::SyncTail::prefetchOps(_ops); }
+    private:
+        const std::deque<BSONObj> _ops;
+    };
+
+    /** The prefetch stage keeps going while a batch is being applied. */
+    class TestPrefetchDuringBatch : public Base {
+    public:
+        void run() {
+            drop();
+            std::deque<BSONObj> ops;
+            for (int i = 0; i < 50; ++i) {
+                insert(BSON("_id" << i));
+                BSONObjBuilder b;
+                b.appendTimestamp("ts", OpTime::_now().asLL());
+                b.append("op", "u");
+                b.append("ns", ns());
+                b.append("o", BSON("$set" << BSON("x" << i)));
+                b.append("o2", BSON("_id" << i));
+                ops.push_back(b.obj());
+            }
+
+            PrefetchOpsThread prefetch(ops);
+            bool finishedDuringBatch;
+            {
+                // As multiApply holds it while the writers apply a batch.
+                Lock::ParallelBatchWriterMode pbwm;
+                prefetch.go();
+                finishedDuringBatch = prefetch.wait(10000);
+            }
+            prefetch.wait();
+            ASSERT(finishedDuringBatch);
+
+            drop();
+        }
+    };
+
+    /** Exposes SyncTail's protected fillWriterVectors() to the tests below. */
+    class WriterVectorsTail : public replset::SyncTail {
+    public:
+        WriterVectorsTail() : SyncTail(0) {}
+        void fill(const std::deque<BSONObj>& ops, std::vector< std::vector<BSONObj> >* writers) {
+            fillWriterVectors(ops, writers);
+        }
+    };
+
+    /** With replWriterHashById, a collection's ops are dealt out by _id, in order per _id. */
+    class TestWriterVectorsById : public Base {
+    public:
+        TestWriterVectorsById() : _hashById(ServerParameterSet::getGlobal()->getMap().find(
+                                                "replWriterHashById")->second),
+                                  _oplogVersion(theReplSet->oplogVersion) {
+            ASSERT_OK(_hashById->setFromString("true"));
+            theReplSet->oplogVersion = 2;
+        }
+        ~TestWriterVectorsById() {
+            ASSERT_OK(_hashById->setFromString("false"));
+            theReplSet->oplogVersion = _oplogVersion;
+        }
+        void run() {
+            drop();
+            // The collection must exist for its writes to be spread.
+            insert(BSON("_id" << -1));
+
+            std::deque<BSONObj> ops;
+            for (int i = 0; i < 100; ++i) {
+                ops.push_back(op("i", BSON("_id" << i << "x" << 0)));
+            }
+            for (int i = 0; i < 100; ++i) {
+                ops.push_back(op("u", BSON("$set" << BSON("x" << 1)), BSON("_id" << i)));
+            }
+            for (int i = 0; i < 100; i += 2) {
+                ops.push_back(op("u", BSON("$set" << BSON("x" << 2)), BSON("_id" << i)));
+            }
+            for (int i = 0; i < 100; i += 5) {
+                ops.push_back(op("d", BSON("_id" << i)));
+            }
+
+            std::vector< std::vector<BSONObj> > writers(8);
+            WriterVectorsTail tail;
+            tail.fill(ops, &writers);
+
+            // Each _id's ops went to a single writer, in oplog order.
+            std::map<int, size_t> writerOf;
+            std::map<int, std::vector<string> > opsOf;
+            size_t used = 0;
+            for (size_t w = 0; w < writers.size(); ++w) {
+                if (!writers[w].empty()) {
+                    ++used;
+                }
+                for (size_t j = 0; j < writers[w].size(); ++j) {
+                    const BSONObj& o = writers[w][j];
+                    int id = (*o.getStringField("op") == 'u' ? o.getObjectField("o2")
+                                                             : o.getObjectField("o"))["_id"]
+                            .numberInt();
+                    if (writerOf.count(id)) {
+                        ASSERT_EQUALS(writerOf[id], w);
+                    }
+                    writerOf[id] = w;
+                    opsOf[id].push_back(o.getStringField("op"));
+                }
+            }
+            ASSERT(used > 1);
+            ASSERT_EQUALS(100U, opsOf.size());
+            for (int i = 0; i < 100; ++i) {
+                std::vector<string> expected;
+                expected.push_back("i");
+                expected.push_back("u");
+                if (i % 2 == 0) {
+                    expected.push_back("u");
+                }
+                if (i % 5 == 0) {
+                    expected.push_back("d");
+                }
+                ASSERT(expected == opsOf[i]);
+            }
+
+            // Applying the writers in any order gives each document its final state.
+            for (size_t w = writers.size(); w > 0; --w) {
+                replset::multiSyncApply(writers[w - 1], &tail);
+            }
+            for (int i = 0; i < 100; ++i) {
+                BSONObj doc = findOne(BSON("_id" << i));
+                if (i % 5 == 0) {
+                    ASSERT(doc.isEmpty());
+                }
+                else {
+                    ASSERT_EQUALS(i % 2 == 0 ? 2 : 1, doc["x"].numberInt());
+                }
+            }
+
+            // An op that doesn't name its document keeps the collection on one writer.
+            ops.push_back(op("u", BSON("$set" << BSON("x" << 3)), BSON("x" << 1)));
+            writers.assign(8, std::vector<BSONObj>());
+            tail.fill(ops, &writers);
+            used = 0;
+            for (size_t w = 0; w < writers.size(); ++w) {
+                if (!writers[w].empty()) {
+                    ASSERT_EQUALS(ops.size(), writers[w].size());
+                    ++used;
+                }
+            }
+            ASSERT_EQUALS(1U, used);
+
+            drop();
+        }
+    private:
+        BSONObj op(const char* type, const BSONObj& o, const BSONObj& o2 = BSONObj()) {
+            BSONObjBuilder b;
+            b.appendTimestamp("ts", OpTime::_now().asLL());
+            b.append("op", type);
+            b.append("ns", ns());
+            b.append("o", o);
+            if (!o2.isEmpty()) {
+                b.append("o2", o2);
+            }
+            return b.obj();
+        }
+
+        ServerParameter* _hashById;
+        int _oplogVersion;
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "replset" ) {
@@ -1125,6 +1293,8 @@ namespace ReplSetTests {
             add< TestReIndex >();
             add< TestRepair >();
             add< TestCompact >();
+            add< TestWriterVectorsById >();
+            add< TestPrefetchDuringBatch >();
         }
     } myall;
 }
@@ -0,0 +1,151 @@
+// s2coveringcachetests.cpp : S2CoveringCache unit tests.
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/geo/geoparser.h"
+#include "mongo/db/index/s2_common.h"
+#include "mongo/db/index/s2_covering_cache.h"
+#include "mongo/db/json.h"
+#include "mongo/dbtests/dbtests.h"
+#include "third_party/s2/s2polygon.h"
+
+namespace S2CoveringCacheTests {
+
+    class Base {
+    public:
+        Base() {
+            _coverer.set_min_level(5);
+            _coverer.set_max_level(20);
+            _coverer.set_max_cells(8);
+        }
+    protected:
+        static BSONObj square( double side ) {
+            return BSON( "type" << "Polygon" << "coordinates" <<
+                         BSON_ARRAY( BSON_ARRAY( BSON_ARRAY( 0 << 0 ) << BSON_ARRAY( side << 0 ) <<
+                                                 BSON_ARRAY( side << side ) <<
+                                                 BSON_ARRAY( 0 << side ) <<
+                                                 BSON_ARRAY( 0 << 0 ) ) ) );
+        }
+        static void parse( const BSONObj& geometry, S2Polygon* polygon ) {
+            ASSERT( GeoParser::isGeoJSONPolygon( geometry ) );
+            GeoParser::parseGeoJSONPolygon( geometry, polygon );
+        }
+        BSONObj uncached( const S2Polygon& polygon ) {
+            vector<S2CellId> cover;
+            _coverer.GetCovering( polygon, &cover );
+            return S2SearchUtil::coverAsBSON( cover, "geo", 5 );
+        }
+        S2CoveringCache _cache;
+        S2RegionCoverer _coverer;
+    };
+
+    /** A cached covering is the one the coverer generates. */
+    class CoverTwice : public Base {
+    public:
+        void run() {
+            BSONObj geometry = square( 1 );
+            S2Polygon polygon;
+            parse( geometry, &polygon );
+            BSONObj expected = uncached( polygon );
+
+            size_t cells = 0;
+            ASSERT_EQUALS( expected,
+                           _cache.coverAsBSON( polygon, geometry, "geo", &_coverer, 5, &cells ) );
+            ASSERT( cells > 0 );
+            ASSERT_EQUALS( 1U, _cache.size() );
+            ASSERT( _cache.contains( geometry, "geo", _coverer, 5 ) );
+
+            size_t cachedCells = 0;
+            ASSERT_EQUALS( expected, _cache.coverAsBSON( polygon, geometry, "geo", &_coverer, 5,
+                                                         &cachedCells ) );
+            ASSERT_EQUALS( cells, cachedCells );
+            ASSERT_EQUALS( 1U, _cache.size() );
+        }
+    };
+
+    /** The field and the coverer's settings are part of the key. */
+    class KeyedBySettings : public Base {
+    public:
+        void run() {
+            BSONObj geometry = square( 1 );
+            S2Polygon polygon;
+            parse( geometry, &polygon );
+            _cache.coverAsBSON( polygon, geometry, "geo", &_coverer, 5 );
+            BSONObj other = _cache.coverAsBSON( polygon, geometry, "other", &_coverer, 5 );
+            ASSERT_EQUALS( "other", string( other.firstElementFieldName() ) );
+            _coverer.set_max_cells( 20 );
+            _cache.coverAsBSON( polygon, geometry, "geo", &_coverer, 5 );
+            ASSERT_EQUALS( 3U, _cache.size() );
+            ASSERT( _cache.contains( geometry, "geo", _coverer, 5 ) );
+            ASSERT( !_cache.contains( geometry, "geo", _coverer, 6 ) );
+        }
+    };
+
+    /** The least recently used covering is dropped when the cache is full. */
+    class EvictLeastRecentlyUsed : public Base {
+    public:
+        void run() {
+            BSONObj first = square( 1 );
+            S2Polygon firstPolygon;
+            parse( first, &firstPolygon );
+            _cache.coverAsBSON( firstPolygon, first, "geo", &_coverer, 5 );
+
+            S2Polygon polygon;
+            parse( square( 2 ), &polygon );
+            for( size_t i = 1; i < S2CoveringCache::MaxEntries; ++i ) {
+                // The keys identify the region, whatever it is.
+                _cache.coverAsBSON( polygon, BSON( "i" << static_cast<int>( i ) ), "geo",
+                                    &_coverer, 5 );
+            }
+            ASSERT_EQUALS( S2CoveringCache::MaxEntries, _cache.size() );
+
+            // Use the first covering, so that the second one is dropped next.
+            _cache.coverAsBSON( firstPolygon, first, "geo", &_coverer, 5 );
+            _cache.coverAsBSON( polygon, BSON( "i" << -1 ), "geo", &_coverer, 5 );
+            ASSERT_EQUALS( S2CoveringCache::MaxEntries, _cache.size() );
+            ASSERT( _cache.contains( first, "geo", _coverer, 5 ) );
+            ASSERT( !_cache.contains( BSON( "i" << 1 ), "geo", _coverer, 5 ) );
+            ASSERT( _cache.contains( BSON( "i" << 2 ), "geo", _coverer, 5 ) );
+            ASSERT( _cache.contains( BSON( "i" << -1 ), "geo", _coverer, 5 ) );
+
+            // A dropped key is covered again, evicting the least recently used one left.
+            _cache.coverAsBSON( polygon, BSON( "i" << 1 ), "geo", &_coverer, 5 );
+            ASSERT_EQUALS( S2CoveringCache::MaxEntries, _cache.size() );
+            ASSERT( _cache.contains( BSON( "i" << 1 ), "geo", _coverer, 5 ) );
+            ASSERT( !_cache.contains( BSON( "i" << 2 ), "geo", _coverer, 5 ) );
+            ASSERT( _cache.contains( first, "geo", _coverer, 5 ) );
+
+            _cache.clear();
+            ASSERT_EQUALS( 0U, _cache.size() );
+        }
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite( "s2coveringcache" ) {
+        }
+
+        void setupTests() {
+            add<CoverTwice>();
+            add<KeyedBySettings>();
+            add<EvictLeastRecentlyUsed>();
+        }
+    } myall;
+
+} // namespace S2CoveringCacheTests
@@ -29,6 +29,7 @@
 #include "../db/d_concurrency.h"
 #include "../util/concurrency/synchronization.h"
 #include "../util/concurrency/qlock.h"
+#include "../util/concurrency/read_mostly_lock.h"
 #include "dbtests.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/platform/atomic_word.h"
@@ -890,6 +891,129 @@ namespace ThreadedTests {
         }
     };
 
+    // two writers to different collections of one database must be able to hold their
+    // CollectionWrite at the same time; a DBWrite on the database excludes both
+    class CollectionWriteTest : public ThreadedTest<2> {
+        AtomicUInt32 _inside;
+        AtomicUInt32 _sawOther;
+        AtomicUInt32 _inDBWrite;
+    private:
+        virtual void validate() {
+            ASSERT_EQUALS( 2U , _sawOther.load() );
+        }
+        virtual void subthread(int x) {
+            Client::initThread("collectionwritetest");
+            string ns = str::stream() << "collectionwritetest.c" << x;
+            {
+                Lock::CollectionWrite lk(ns);
+                ASSERT( Lock::isLocked() == 'w' );
+                ASSERT( Lock::isWriteLocked(ns) );
+                ASSERT( Lock::isWriteLocked(ns + ".$_id_") );
+                ASSERT( Lock::isWriteLocked("collectionwritetest") );
+                ASSERT( !Lock::isWriteLocked("collectionwritetest.other") );
+                ASSERT( !Lock::isWriteLocked(ns + "x") );
+                {
+                    Lock::CollectionWrite nested(ns);
+                    ASSERT( Lock::nested() );
+                }
+                _inside.fetchAndAdd(1);
+                for( int i = 0; i < 2000 && _inside.load() < 2; i++ )
+                    sleepmillis(1);
+                if( _inside.load() == 2 )
+                    _sawOther.fetchAndAdd(1);
+                {
+                    Lock::TempRelease t;
+                    ASSERT( !Lock::isLocked() );
+                }
+                ASSERT( Lock::isWriteLocked(ns) );
+            }
+            ASSERT( !Lock::isLocked() );
+            {
+                Lock::DBWrite lk("collectionwritetest");
+                ASSERT_EQUALS( 1U , _inDBWrite.addAndFetch(1) );
+                sleepmillis(20);
+                _inDBWrite.subtractAndFetch(1);
+            }
+            {
+                Lock::CollectionWrite lk(ns);
+                ASSERT_EQUALS( 0U , _inDBWrite.load() );
+            }
+            cc().shutdown();
+        }
+    };
+
+    // R, w and W holders of a ReadMostlyLock must never overlap in a way the modes forbid
+    class ReadMostlyLockTest : public ThreadedTest<8> {
+        enum { N = 20000 };
+        ReadMostlyLock m;
+        AtomicInt32 R, w, W;
+        AtomicInt32 violations;
+        virtual void validate() {
+            ASSERT_EQUALS( 0 , violations.load() );
+            ASSERT_EQUALS( 0 , m.sharedCount() );
+        }
+        virtual void subthread(int x) {
+            for( int i = 0; i < N; i++ ) {
+                int k = ( i + x ) % 50;
+                if( k == 0 ) {
+                    m.lock_W();
+                    W.fetchAndAdd(1);
+                    if( W.load() != 1 || w.load() || R.load() )
+                        violations.fetchAndAdd(1);
+                    W.fetchAndSubtract(1);
+                    m.unlock_W();
+                }
+                else if( k < 5 ) {
+                    m.lock_w();
+                    w.fetchAndAdd(1);
+                    if( W.load() || R.load() )
+                        violations.fetchAndAdd(1);
+                    w.fetchAndSubtract(1);
+                    m.unlock_w();
+                }
+                else {
+                    m.lock_R();
+                    R.fetchAndAdd(1);
+                    if( W.load() || w.load() )
+                        violations.fetchAndAdd(1);
+                    R.fetchAndSubtract(1);
+                    m.unlock_R();
+                }
+            }
+        }
+    };
+
+    /** read lock throughput under contention.  every writeEvery'th acquisition of thread 1
+        is a W (0 for none).  not a pass/fail test; compare the output across lock types and
+        thread counts. */
+    template <class whichlock, int nthr, int writeEvery>
+    class ReadLockContention : public ThreadedTest<nthr> {
+        enum { N = 50000 };
+        whichlock m;
+        Timer t;
+        virtual void setup() {
+            t.reset();
+        }
+        virtual void validate() {
+            long long ms = t.millis();
+            cout << "ReadLockContention " << typeid(whichlock).name() << " threads:" << nthr
+                 << " writeEvery:" << writeEvery << ' ' << ms << "ms "
+                 << ( nthr * (long long) N ) / ( ms ? ms : 1 ) << " locks/ms" << endl;
+        }
+        virtual void subthread(int x) {
+            for( int i = 0; i < N; i++ ) {
+                if( writeEvery && x == 1 && i % writeEvery == 0 ) {
+                    m.lock_W();
+                    m.unlock_W();
+                }
+                else {
+                    m.lock_R();
+                    m.unlock_R();
+                }
+            }
+        }
+    };
+
     // Tests waiting on the TicketHolder by running many more threads than can fit into the "hotel", but only
     // max _nRooms threads should ever get in at once
     class TicketHolderWaits : public ThreadedTest<10> {
@@ -972,6 +1096,18 @@ namespace ThreadedTests {
             add< WriteLocksAreGreedy >();
             add< QLockTest >();
             add< QLockTest >();
+            add< CollectionWriteTest >();
+            add< ReadMostlyLockTest >();
+            add< ReadLockContention<QLock, 8, 0> >();
+            add< ReadLockContention<ReadMostlyLock, 8, 0> >();
+            add< ReadLockContention<QLock, 16, 0> >();
+            add< ReadLockContention<ReadMostlyLock, 16, 0> >();
+            add< ReadLockContention<QLock, 32, 0> >();
+            add< ReadLockContention<ReadMostlyLock, 32, 0> >();
+            add< ReadLockContention<QLock, 64, 0> >();
+            add< ReadLockContention<ReadMostlyLock, 64, 0> >();
+            add< ReadLockContention<QLock, 64, 100> >();
+            add< ReadLockContention<ReadMostlyLock, 64, 100> >();
 
             // Slack is a test to see how long it takes for another thread to pick up
             // and begin work after another relinquishes the lock.  e.g. a spin lock 
@@ -673,6 +673,7 @@ namespace mongo {
                     const_cast<set<Shard>&>(_shards).swap(shards);
                     const_cast<ShardVersionMap&>(_shardVersions).swap(shardVersions);
                     const_cast<ChunkRangeManager&>(_chunkRanges).reloadAll(_chunkMap);
+                    _buildRoutingTable();
 
                     // Once we load data, clear reference to old manager
                     _oldManager.reset();
@@ -896,6 +897,19 @@ namespace mongo {
         }
     }
 
+    void ChunkManager::_buildRoutingTable() {
+        // const for thread-safety like _chunkMap; only called while constructing
+        ChunkRoutingTable& table = const_cast<ChunkRoutingTable&>(_routingTable);
+        vector<ChunkPtr>& chunks = const_cast<vector<ChunkPtr>&>(_routingChunks);
+        table.clear();
+        chunks.clear();
+        chunks.reserve(_chunkMap.size());
+        for (ChunkMap::const_iterator it = _chunkMap.begin(); it != _chunkMap.end(); ++it) {
+            table.append(it->first);
+            chunks.push_back(it->second);
+        }
+    }
+
     bool ChunkManager::_isValid(const ChunkMap& chunkMap) {
 #define ENSURE(x) do { if(!(x)) { log() << "ChunkManager::_isValid failed: " #x << endl; return false; } } while(0)
 
@@ -1048,10 +1062,14 @@ namespace mongo {
             BSONObj foo;
             ChunkPtr c;
             {
-                ChunkMap::const_iterator it = _chunkMap.upper_bound( point );
-                if (it != _chunkMap.end()) {
-                    foo = it->first;
-                    c = it->second;
+                size_t i = _routingTable.upperBound( point );
+                if ( i < _routingTable.size() ) {
+                    foo = _routingTable.bound( i );
+                    c = _routingChunks[i];
+                }
+                DEV {
+                    ChunkMap::const_iterator it = _chunkMap.upper_bound( point );
+                    verify( it == _chunkMap.end() ? !c : c == it->second );
                 }
             }
 
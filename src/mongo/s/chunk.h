@@ -20,6 +20,7 @@
 
 #include "mongo/bson/util/atomic_int.h"
 #include "mongo/client/distlock.h"
+#include "mongo/s/chunk_routing_table.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/shard.h"
 #include "mongo/s/shardkey.h"
@@ -449,6 +450,7 @@ namespace mongo {
         bool _load( const string& config, ChunkMap& chunks, set<Shard>& shards,
                                     ShardVersionMap& shardVersions, ChunkManagerPtr oldManager);
         static bool _isValid(const ChunkMap& chunks);
+        void _buildRoutingTable();
 
         // end helpers
 
@@ -460,6 +462,10 @@ namespace mongo {
         const ChunkMap _chunkMap;
         const ChunkRangeManager _chunkRanges;
 
+        // _chunkMap flattened for findIntersectingChunk(): chunk i has max _routingTable.bound(i)
+        const ChunkRoutingTable _routingTable;
+        const vector<ChunkPtr> _routingChunks;
+
         const set<Shard> _shards;
 
         const ShardVersionMap _shardVersions; // max version per shard
@@ -0,0 +1,72 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/s/chunk_routing_table.h"
+
+#include <limits>
+
+#include "mongo/db/key_string.h"
+
+namespace mongo {
+
+    void ChunkRoutingTable::append( const BSONObj& max ) {
+        dassert( _prefixes.empty() || bound( size() - 1 ).woCompare( max ) < 0 );
+        _offsets.push_back( _bounds.len() );
+        _bounds.appendBuf( max.objdata(), max.objsize() );
+        _prefixes.push_back( KeyString::firstFieldPrefix( max ) );
+    }
+
+    void ChunkRoutingTable::clear() {
+        _prefixes.clear();
+        _offsets.clear();
+        _bounds.reset();
+    }
+
+    size_t ChunkRoutingTable::lowerBoundPrefix( unsigned long long p ) const {
+        if ( _prefixes.empty() )
+            return 0;
+
+        // the answer is always in [base, base + n]; the step is a conditional move, not a branch
+        const unsigned long long* const first = &_prefixes[0];
+        const unsigned long long* base = first;
+        size_t n = _prefixes.size();
+        while ( n > 1 ) {
+            size_t half = n / 2;
+            base = ( base[half] < p ) ? base + half : base;
+            n -= half;
+        }
+        return ( base - first ) + ( *base < p );
+    }
+
+    size_t ChunkRoutingTable::upperBound( const BSONObj& point ) const {
+        unsigned long long p = KeyString::firstFieldPrefix( point );
+
+        // bounds below lo are less than point and bounds from hi on are greater; the ones in
+        // between share its prefix and need a real comparison
+        size_t lo = lowerBoundPrefix( p );
+        size_t hi = p == std::numeric_limits<unsigned long long>::max() ? size() :
+                                                                           lowerBoundPrefix( p + 1 );
+        while ( lo < hi ) {
+            size_t mid = lo + ( hi - lo ) / 2;
+            if ( point.woCompare( bound( mid ) ) < 0 )
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        return lo;
+    }
+
+}
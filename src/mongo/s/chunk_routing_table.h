@@ -0,0 +1,65 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/bson/util/builder.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * The upper bounds of a collection's chunks, in order, laid out for routing lookups.
+     *
+     * The bounds are copied back to back into one buffer, and next to them we keep a 64 bit
+     * prefix of each bound's first field, encoded so that comparing prefixes as integers never
+     * disagrees with BSONObj::woCompare (see KeyString::firstFieldPrefix()).  A lookup binary
+     * searches the prefixes without branching on the comparison, and only compares whole BSON
+     * keys for the few bounds whose prefix ties with the point's - usually none or one.
+     *
+     * Immutable once built; the owner rebuilds it when the chunks change.
+     */
+    class ChunkRoutingTable {
+    public:
+        ChunkRoutingTable() {}
+
+        /** append the next chunk's max.  bounds must be added in ascending order. */
+        void append( const BSONObj& max );
+
+        void clear();
+
+        size_t size() const { return _prefixes.size(); }
+
+        BSONObj bound( size_t i ) const { return BSONObj( _bounds.buf() + _offsets[i] ); }
+
+        /**
+         * @return the index of the first bound greater than point, i.e. of the chunk containing
+         * point, or size() if there is none
+         */
+        size_t upperBound( const BSONObj& point ) const;
+
+    private:
+        /** first i with _prefixes[i] >= p */
+        size_t lowerBoundPrefix( unsigned long long p ) const;
+
+        std::vector<unsigned long long> _prefixes;
+        std::vector<unsigned> _offsets;
+        BufBuilder _bounds;
+    };
+
+}
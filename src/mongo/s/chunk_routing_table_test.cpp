@@ -0,0 +1,107 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <limits>
+#include <map>
+#include <vector>
+
+#include "mongo/s/chunk_routing_table.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using mongo::BSONObj;
+    using mongo::BSONObjBuilder;
+    using mongo::BSONObjCmp;
+    using mongo::ChunkRoutingTable;
+    using mongo::OID;
+    using std::vector;
+
+    // keys of mixed types in woCompare order, with ties and near ties
+    vector<BSONObj> orderedKeys() {
+        vector<BSONObj> keys;
+        keys.push_back(BSON("x" << mongo::MINKEY));
+        keys.push_back(BSON("x" << std::numeric_limits<double>::quiet_NaN()));
+        keys.push_back(BSON("x" << -std::numeric_limits<double>::infinity()));
+        keys.push_back(BSON("x" << -1000.5));
+        keys.push_back(BSON("x" << -1000));
+        keys.push_back(BSON("x" << -0.0));
+        keys.push_back(BSON("x" << 0));
+        keys.push_back(BSON("x" << 1LL));
+        keys.push_back(BSON("x" << 1.5));
+        keys.push_back(BSON("x" << (1LL << 60)));
+        keys.push_back(BSON("x" << (1LL << 60) + 1));
+        keys.push_back(BSON("x" << ""));
+        keys.push_back(BSON("x" << "abcdefg"));
+        keys.push_back(BSON("x" << "abcdefgh"));
+        keys.push_back(BSON("x" << "abcdefgi"));
+        keys.push_back(BSON("x" << "abd"));
+        keys.push_back(BSON("x" << BSON("a" << 1)));
+        keys.push_back(BSON("x" << OID("000000000000000000000001")));
+        keys.push_back(BSON("x" << OID("000000000000010000000000")));
+        keys.push_back(BSON("x" << false));
+        keys.push_back(BSON("x" << true));
+        keys.push_back(BSON("x" << mongo::Date_t(-5)));
+        keys.push_back(BSON("x" << mongo::Date_t(5)));
+        keys.push_back(BSON("x" << mongo::MAXKEY));
+        return keys;
+    }
+
+    TEST(ChunkRoutingTable, UpperBoundMatchesMap) {
+        vector<BSONObj> keys = orderedKeys();
+
+        // every other key is a chunk bound, the rest are only looked up
+        ChunkRoutingTable table;
+        std::map<BSONObj, size_t, BSONObjCmp> bounds;
+        for (size_t i = 0; i < keys.size(); i += 2) {
+            if (!bounds.empty() && bounds.rbegin()->first.woCompare(keys[i]) == 0)
+                continue;
+            bounds[keys[i]] = table.size();
+            table.append(keys[i]);
+        }
+
+        for (size_t i = 0; i < keys.size(); i++) {
+            std::map<BSONObj, size_t, BSONObjCmp>::const_iterator it = bounds.upper_bound(keys[i]);
+            size_t expected = it == bounds.end() ? table.size() : it->second;
+            ASSERT_EQUALS(expected, table.upperBound(keys[i]));
+        }
+    }
+
+    TEST(ChunkRoutingTable, ManyCompoundBounds) {
+        // a constant first field makes every prefix tie
+        ChunkRoutingTable table;
+        for (int i = 0; i < 1000; i++) {
+            table.append(BSON("a" << "same" << "b" << i * 2));
+        }
+        ASSERT_EQUALS(1000U, table.size());
+        ASSERT_EQUALS(0U, table.upperBound(BSON("a" << "same" << "b" << -1)));
+        ASSERT_EQUALS(1U, table.upperBound(BSON("a" << "same" << "b" << 0)));
+        ASSERT_EQUALS(501U, table.upperBound(BSON("a" << "same" << "b" << 1001)));
+        ASSERT_EQUALS(1000U, table.upperBound(BSON("a" << "same" << "b" << 1998)));
+        ASSERT_EQUALS(1000U, table.upperBound(BSON("a" << "zzz" << "b" << 0)));
+        ASSERT_EQUALS(0U, table.upperBound(BSON("a" << "aaa" << "b" << 5000)));
+    }
+
+    TEST(ChunkRoutingTable, Empty) {
+        ChunkRoutingTable table;
+        ASSERT_EQUALS(0U, table.upperBound(BSON("x" << 1)));
+        table.append(BSON("x" << mongo::MAXKEY));
+        ASSERT_EQUALS(0U, table.upperBound(BSON("x" << 1)));
+        table.clear();
+        ASSERT_EQUALS(0U, table.size());
+    }
+
+}
@@ -29,6 +29,7 @@
 #include "../db/stats/timer_stats.h"
 
 #include "../client/connpool.h"
+#include "../client/parallel.h"
 
 #include "client_info.h"
 #include "request.h"
@@ -320,21 +321,49 @@ namespace mongo {
 
         int updatedExistingStat = 0; // 0 is none, -1 has but false, 1 has true
 
-        // hit each shard
+        // hit each shard: send every shard the gle before reading any reply, so the waits
+        // (for w, j, ...) overlap
+        vector< shared_ptr<ShardConnection> > conns;
+        vector< shared_ptr<Future::CommandResult> > gles;
+        for ( set<string>::iterator i = shards->begin(); i != shards->end(); i++ ) {
+            try {
+                // constructor can throw if shard is down
+                conns.push_back( shared_ptr<ShardConnection>( new ShardConnection( *i , "" ) ) );
+                gles.push_back( Future::spawnCommand( *i, dbName, options, 0, conns.back()->get() ) );
+            }
+            catch( std::exception &e ){
+                string message =
+                        str::stream() << "could not get last error from a shard " << *i
+                                      << causedBy( e );
+
+                warning() << message << endl;
+                errmsg = message;
+
+                // a gle we sent may still be answered; don't leave that for the next user
+                for ( size_t j = 0; j < conns.size(); j++ )
+                    conns[j]->kill();
+
+                return false;
+            }
+        }
+
         vector<string> errors;
         vector<BSONObj> errorObjects;
-        for ( set<string>::iterator i = shards->begin(); i != shards->end(); i++ ) {
+        size_t k = 0;
+        for ( set<string>::iterator i = shards->begin(); i != shards->end(); i++, k++ ) {
             string theShard = *i;
             bbb.append( theShard );
 
             LOG(5) << "gathering a response for gle from: " << theShard << endl;
 
-            boost::scoped_ptr<ShardConnection> conn;
+            ShardConnection* conn = conns[k].get();
             BSONObj res;
             bool ok = false;
             try {
-                conn.reset( new ShardConnection( theShard , "" ) ); // constructor can throw if shard is down
-                ok = (*conn)->runCommand( dbName , options , res );
+                ok = gles[k]->join();
+                res = gles[k]->result();
+                // spawnCommand reports a failure to send as a command that failed, with no reply
+                uassert( 16841, "no reply to getLastError", ok || ! res.isEmpty() );
                 shardRawGLE.append( theShard , res );
             }
             catch( std::exception &e ){
@@ -349,8 +378,12 @@ namespace mongo {
                 warning() << message << endl;
                 errmsg = message;
 
-                if (conn)
-                    conn->done();
+                for ( size_t j = 0; j < conns.size(); j++ ) {
+                    if ( j < k )
+                        conns[j]->done();
+                    else
+                        conns[j]->kill();
+                }
 
                 return false;
             }
@@ -370,10 +403,11 @@ namespace mongo {
                 else if ( updatedExistingStat == 0 )
                     updatedExistingStat = -1;
             }
-
-            conn->done();
         }
 
+        for ( size_t j = 0; j < conns.size(); j++ )
+            conns[j]->done();
+
         bbb.done();
         result.append( "shardRawGLE" , shardRawGLE.obj() );
 
@@ -38,6 +38,7 @@
 #include "mongo/s/writeback_listener.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/message_port.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/ramlog.h"
 #include "mongo/util/stringutils.h"
@@ -1291,6 +1292,7 @@ namespace mongo {
                 result.appendNumber("maxBsonObjectSize", BSONObjMaxUserSize);
                 result.appendNumber("maxMessageSizeBytes", MaxMessageSizeBytes);
                 result.appendDate("localTime", jsTime());
+                negotiateCompression(cmdObj, ClientBasic::getCurrent()->port(), result);
 
                 return true;
             }
@@ -188,6 +188,11 @@ namespace mongo {
 
         static ShardedConnectionInfo* get( bool create );
         static void reset();
+
+        /** take this thread's info off it without deleting it, and put it back (on any
+            thread) later.  for servers that run a connection's requests on several threads. */
+        static ShardedConnectionInfo* release();
+        static void set( ShardedConnectionInfo* info );
         static void addHook();
 
         bool inForceVersionOkMode() const {
@@ -33,6 +33,7 @@
 #include "mongo/client/connpool.h"
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/client/distlock.h"
+#include "mongo/client/parallel.h"
 #include "mongo/db/auth/action_set.h"
 #include "mongo/db/auth/action_type.h"
 #include "mongo/db/auth/authorization_manager.h"
@@ -51,6 +52,7 @@
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/repl/rs_config.h"
 #include "mongo/db/repl/write_concern.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/config.h"
@@ -1550,6 +1552,16 @@ namespace mongo {
        commend to "commit"
     */
 
+    /** how many cloned documents the recipient inserts per acquisition of the db write lock */
+    static int migrateCloneInsertsPerLock = 100;
+
+    static ExportedServerParameter<int> MigrateCloneInsertsPerLock(
+        ServerParameterSet::getGlobal(),
+        "migrateCloneInsertsPerLock",
+        &migrateCloneInsertsPerLock,
+        true,
+        true );
+
     class MigrateStatus {
     public:
         
@@ -1675,49 +1687,64 @@ namespace mongo {
                 // 3. initial bulk clone
                 state = CLONE;
 
+                // the request for each batch goes out before we insert the previous one, so the
+                // donor reads the next batch off disk while we write this one
+                const BSONObj cloneCmd = BSON( "_migrateClone" << 1 );
+                shared_ptr<Future::CommandResult> pending =
+                    Future::spawnCommand( from, "admin", cloneCmd, 0, conn.get() );
+
                 while ( true ) {
-                    BSONObj res;
-                    if ( ! conn->runCommand( "admin" , BSON( "_migrateClone" << 1 ) , res ) ) {  // gets array of objects to copy, in disk order
+                    if ( ! pending->join() ) {  // gets array of objects to copy, in disk order
                         state = FAIL;
                         errmsg = "_migrateClone failed: ";
-                        errmsg += res.toString();
+                        errmsg += pending->result().toString();
                         error() << errmsg << migrateLog;
                         conn.done();
                         return;
                     }
 
-                    BSONObj arr = res["objects"].Obj();
-                    int thisTime = 0;
+                    shared_ptr<Future::CommandResult> batch = pending;
+                    pending.reset();
 
-                    BSONObjIterator i( arr );
-                    while( i.more() ) {
-                        BSONObj o = i.next().Obj();
-                        {
-                            PageFaultRetryableSection pgrs;
-                            while ( 1 ) {
-                                try {
-                                    Lock::DBWrite lk( ns );
-                                    Helpers::upsert( ns, o, true );
-                                    break;
-                                }
-                                catch ( PageFaultException& e ) {
-                                    e.touch();
+                    vector<BSONObj> objs;
+                    BSONObjIterator i( batch->result()["objects"].Obj() );
+                    while ( i.more() )
+                        objs.push_back( i.next().Obj() );
+
+                    if ( objs.empty() )
+                        break;
+
+                    pending = Future::spawnCommand( from, "admin", cloneCmd, 0, conn.get() );
+
+                    // with secondaryThrottle we wait for replication after every document, so
+                    // there's no point holding the lock across several
+                    const size_t perLock = secondaryThrottle ? 1 : std::max( migrateCloneInsertsPerLock, 1 );
+                    size_t next = 0;
+                    while ( next < objs.size() ) {
+                        PageFaultRetryableSection pgrs;
+                        while ( 1 ) {
+                            try {
+                                Lock::DBWrite lk( ns );
+                                // a page fault restarts us after the documents already inserted
+                                for ( size_t n = 0; n < perLock && next < objs.size(); n++ ) {
+                                    Helpers::upsert( ns, objs[next], true );
+                                    numCloned++;
+                                    clonedBytes += objs[next].objsize();
+                                    next++;
                                 }
+                                break;
+                            }
+                            catch ( PageFaultException& e ) {
+                                e.touch();
                             }
                         }
-                        thisTime++;
-                        numCloned++;
-                        clonedBytes += o.objsize();
 
-                        if ( secondaryThrottle && thisTime > 0 ) {
+                        if ( secondaryThrottle ) {
                             if ( ! waitForReplication( cc().getLastOp(), 2, 60 /* seconds to wait */ ) ) {
                                 warning() << "secondaryThrottle on, but doc insert timed out after 60 seconds, continuing" << endl;
                             }
                         }
                     }
-
-                    if ( thisTime == 0 )
-                        break;
                 }
 
                 timing.done(3);
@@ -34,6 +34,9 @@
  */
 namespace mongo {
 
+    // the aggregation Sorter (in coredb) names its files under dbpath, but mongos never spills
+    string dbpath;
+
     void* remapPrivateView(void *oldPrivateAddr) {
         log() << "remapPrivateView called in mongos, aborting" << endl;
         fassertFailed(16462);
@@ -501,6 +501,58 @@ namespace mongo {
             }
         }
 
+        /**
+         * With ContinueOnError the order of inserts to different shards doesn't matter, so we
+         * regroup the documents of a sharded insert by target shard, keeping their order within
+         * each shard.  _getNextInsertGroup() then sends each shard its documents in one batch
+         * rather than one batch per run of documents that happen to be adjacent, and _insert()
+         * leaves the errors of all the shards to the client's getLastError.
+         *
+         * A document without a shard key is an error raised by mongos in its place in the
+         * insert, which regrouping would move, so such inserts are left alone.
+         *
+         * Returns false, leaving grouped alone, if the documents can't or needn't be regrouped.
+         */
+        bool _groupInsertsByShard(const string& ns, const ChunkManagerPtr& manager, DbMessage& d,
+                                  Message* grouped) {
+            vector<string> shardOrder;
+            map<string, vector<BSONObj> > byShard;
+            bool interleaved = false;
+
+            d.markSet();
+            while (d.moreJSObjs()) {
+                BSONObj o = d.nextJsObj();
+                if (!manager->hasShardKey(o)) {
+                    d.markReset();
+                    return false;
+                }
+
+                const string& shard = manager->findChunkForDoc(o)->getShard().getName();
+                vector<BSONObj>& docs = byShard[shard];
+                if (docs.empty())
+                    shardOrder.push_back(shard);
+                else if (shardOrder.back() != shard)
+                    interleaved = true;
+                docs.push_back(o);
+            }
+            d.markReset();
+
+            if (!interleaved)
+                return false;
+
+            BufBuilder b;
+            b.appendNum(d.reservedField());
+            b.appendStr(ns);
+            for (vector<string>::const_iterator i = shardOrder.begin(); i != shardOrder.end(); ++i) {
+                const vector<BSONObj>& docs = byShard[*i];
+                for (vector<BSONObj>::const_iterator j = docs.begin(); j != docs.end(); ++j)
+                    j->appendSelfToBufBuilder(b);
+            }
+
+            grouped->setData(dbInsert, b.buf(), b.len());
+            return true;
+        }
+
         /**
          * This insert function now handes all inserts, unsharded or sharded, through mongos.
          *
@@ -527,10 +579,45 @@ namespace mongo {
 
             if (!d.moreJSObjs()) return;
 
+            if (flags & InsertOption_ContinueOnError) {
+                ChunkManagerPtr manager;
+                ShardPtr primary;
+                grid.getDBConfig(ns)->getChunkManagerOrPrimary(ns, manager, primary);
+
+                Message grouped;
+                if (manager && _groupInsertsByShard(ns, manager, d, &grouped)) {
+                    DbMessage groupedMsg(grouped);
+                    _insert(ns, groupedMsg, flags, r, true);
+                    return;
+                }
+            }
+
             _insert(ns, d, flags, r);
         }
 
-        void _insert(const string& ns, DbMessage& d, int flags, Request& r) // TODO: remove
+        /**
+         * @return whether the next document of d would go to one of the shards in written, or
+         * may: a document we can't place is assumed to.
+         */
+        bool _nextInsertReusesShard(DbMessage& d, const InsertGroup& group,
+                                    const set<string>& written) {
+            if (!group.manager)
+                return true;
+            const char* here = d.markGet();
+            BSONObj next = d.nextJsObj();
+            d.markReset(here);
+            if (!group.manager->hasShardKey(next))
+                return true;
+            return written.count(group.manager->findChunkForDoc(next)->getShard().getName()) > 0;
+        }
+
+        /**
+         * @param groupedByShard whether d was regrouped by _groupInsertsByShard(), so that each
+         *        shard's documents are together and getLastError is only needed between groups
+         *        that would otherwise reuse a shard's connection
+         */
+        void _insert(const string& ns, DbMessage& d, int flags, Request& r,
+                     bool groupedByShard = false) // TODO: remove
         {
             uassert( 16056, str::stream() << "shutting down server during insert", ! inShutdown() );
 
@@ -543,6 +630,10 @@ namespace mongo {
 
             bool prevInsertException = false;
 
+            // Shards written since the last intermediate GLE.  A later insert on the same
+            // connection would hide an error from the client's GLE.
+            set<string> writtenSinceGLE;
+
             while (d.moreJSObjs()) {
 
                 // TODO: Replace this with a better check to see if we're making progress
@@ -571,6 +662,7 @@ namespace mongo {
                 }
 
                 scoped_ptr<ShardConnection> dbconPtr;
+                bool ranIntermediateGLE = false;
 
                 try {
 
@@ -626,15 +718,24 @@ namespace mongo {
                             // CHECK INTERMEDIATE ERROR
                             //
 
-                            // We need to check the mongod error if we're inserting more documents,
-                            // or if a later mongos error might mask an insert error,
-                            // or if an earlier error might mask this error from GLE
-                            if (d.moreJSObjs() || group.hasException() || prevInsertException) {
+                            // We need to check the mongod error if we're inserting more documents
+                            // (when regrouped by shard, only if they go to a shard already
+                            // written: otherwise the client's GLE gathers every shard's result at
+                            // once), or if a later mongos error might mask an insert error, or if
+                            // an earlier error might mask this error from GLE
+                            writtenSinceGLE.insert(group.shard->getName());
+                            bool checkBeforeMore = d.moreJSObjs() &&
+                                    (!groupedByShard || _nextInsertReusesShard(d, group,
+                                                                               writtenSinceGLE));
+                            if (checkBeforeMore || group.hasException() || prevInsertException) {
+
+                                ranIntermediateGLE = true;
+                                writtenSinceGLE.clear();
 
                                 LOG(3) << "running intermediate GLE to "
                                        << group.shard->toString() << " during bulk insert "
                                        << "because "
-                                       << (d.moreJSObjs() ? "we have more documents to insert" : 
+                                       << (checkBeforeMore ? "we have more documents to insert" : 
                                           (group.hasException() ? "exception detected while preparing group" :
                                                                       "a previous error exists"))
                                        << endl;
@@ -783,7 +884,7 @@ namespace mongo {
 
                 // Reset our list of last shards we talked to, since we already got writebacks
                 // earlier.
-                if (d.moreJSObjs()) r.getClientInfo()->clearSinceLastGetError();
+                if (d.moreJSObjs() && ranIntermediateGLE) r.getClientInfo()->clearSinceLastGetError();
             }
         }
 
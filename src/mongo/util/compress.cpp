@@ -42,4 +42,12 @@ namespace mongo {
         return snappy::Uncompress(compressed, compressed_length, uncompressed);
     }
 
+    bool uncompressedLength(const char* compressed, size_t compressed_length, size_t* result) {
+        return snappy::GetUncompressedLength(compressed, compressed_length, result);
+    }
+
+    bool rawUncompress(const char* compressed, size_t compressed_length, char* uncompressed) {
+        return snappy::RawUncompress(compressed, compressed_length, uncompressed);
+    }
+
 }
@@ -0,0 +1,214 @@
+// @file read_mostly_lock.cpp
+
+/**
+*    Copyright (C) 2012 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/util/concurrency/read_mostly_lock.h"
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include <boost/thread/thread.hpp>
+
+#include "mongo/util/concurrency/threadlocal.h"
+
+namespace mongo {
+
+    namespace {
+        const unsigned MaxStripes = 64;
+        const unsigned MinSpins = 16;
+        const unsigned MaxSpins = 4 * 1024;
+
+        unsigned stripeCount() {
+            unsigned cores = boost::thread::hardware_concurrency();
+            unsigned n = 1;
+            while ( n < cores && n < MaxStripes )
+                n *= 2;
+            return n;
+        }
+
+        inline void cpuRelax() {
+#if defined(__i386__) || defined(__x86_64__)
+            asm volatile ( "pause" );
+#endif
+        }
+
+        // used where we can't ask which cpu we are on: each thread gets a stripe of its own
+        AtomicUInt32 nextThreadStripe;
+        ThreadLocalValue<unsigned> threadStripe;
+    }
+
+    ReadMostlyLock::ReadMostlyLock() :
+        _stripes( 0 ),
+        _nStripes( stripeCount() ),
+        _w( 0 ),
+        _W( false ),
+        _pendingW( 0 ),
+        _draining( false ) {
+        _stripes = new Stripe[_nStripes];
+        _spinLimit.store( MinSpins * 16 );
+    }
+
+    ReadMostlyLock::~ReadMostlyLock() {
+        delete[] _stripes;
+    }
+
+    ReadMostlyLock::Stripe& ReadMostlyLock::myStripe() {
+#if defined(__linux__)
+        int cpu = sched_getcpu();
+        if ( cpu >= 0 )
+            return _stripes[ cpu & ( _nStripes - 1 ) ];
+#endif
+        unsigned& s = threadStripe.getRef();
+        if ( s == 0 )
+            s = nextThreadStripe.addAndFetch( 1 );
+        return _stripes[ s & ( _nStripes - 1 ) ];
+    }
+
+    int ReadMostlyLock::sharedCount() const {
+        // a thread may unlock on a different stripe than it locked on (it moved cpus), so
+        // single stripes can be negative; only the sum means anything.  the callers that
+        // need this to be current have just closed the gate, whose store is fenced.
+        int n = 0;
+        for ( unsigned i = 0; i < _nStripes; i++ )
+            n += _stripes[i].n.loadRelaxed();
+        return n;
+    }
+
+    bool ReadMostlyLock::gateOpen() const {
+        return _gate.loadRelaxed() == 0;
+    }
+
+    bool ReadMostlyLock::noShared() const {
+        return sharedCount() == 0;
+    }
+
+    bool ReadMostlyLock::spin( bool (ReadMostlyLock::*ready)() const ) {
+        unsigned limit = _spinLimit.loadRelaxed();
+        for ( unsigned i = 0; i < limit; i++ ) {
+            if ( (this->*ready)() ) {
+                // aim for about twice what this wait took
+                unsigned next = ( limit + 2 * i ) / 2;
+                _spinLimit.store( next < MinSpins ? MinSpins : next > MaxSpins ? MaxSpins : next );
+                return true;
+            }
+            cpuRelax();
+        }
+        // spinning didn't pay off, do less of it next time
+        _spinLimit.store( limit / 2 < MinSpins ? MinSpins : limit / 2 );
+        return false;
+    }
+
+    void ReadMostlyLock::lock_R() {
+        if ( _gate.loadRelaxed() == 0 ) {
+            Stripe& s = myStripe();
+            // the add is a full barrier, so either a w/W closing the gate sees our count when
+            // it drains, or we see the closed gate here and back out
+            s.n.fetchAndAdd( 1 );
+            if ( _gate.load() == 0 )
+                return;
+            releaseShared( s );
+        }
+        lock_R_slow();
+    }
+
+    NOINLINE_DECL void ReadMostlyLock::lock_R_slow() {
+        while ( 1 ) {
+            if ( !spin( &ReadMostlyLock::gateOpen ) ) {
+                boost::mutex::scoped_lock lk( _m );
+                while ( _gate.load() != 0 )
+                    _c.wait( lk );
+            }
+            Stripe& s = myStripe();
+            s.n.fetchAndAdd( 1 );
+            if ( _gate.load() == 0 )
+                return;
+            releaseShared( s );
+        }
+    }
+
+    void ReadMostlyLock::unlock_R() {
+        releaseShared( myStripe() );
+    }
+
+    void ReadMostlyLock::releaseShared( Stripe& s ) {
+        s.n.fetchAndSubtract( 1 );
+        if ( _gate.load() != 0 ) {
+            // someone may be waiting in drainShared() for us
+            boost::mutex::scoped_lock lk( _m );
+            _drained.notify_all();
+        }
+    }
+
+    void ReadMostlyLock::updateGate() {
+        _gate.store( ( _w || _W || _pendingW || _draining ) ? 1 : 0 );
+    }
+
+    void ReadMostlyLock::drainShared( boost::mutex::scoped_lock& lk ) {
+        // the gate is closed.  spin outside of _m (the readers we wait for take it to wake us)
+        _draining = true;
+        lk.unlock();
+        spin( &ReadMostlyLock::noShared );
+        lk.lock();
+        while ( sharedCount() != 0 )
+            _drained.wait( lk );
+        _draining = false;
+    }
+
+    void ReadMostlyLock::lock_w() {
+        boost::mutex::scoped_lock lk( _m );
+        while ( _W || _pendingW || _draining )
+            _c.wait( lk );
+        if ( _w++ == 0 ) {
+            updateGate();
+            drainShared( lk );
+            // other w's wait while we drain
+            _c.notify_all();
+        }
+    }
+
+    void ReadMostlyLock::unlock_w() {
+        boost::mutex::scoped_lock lk( _m );
+        fassert( 16836, _w > 0 );
+        if ( --_w == 0 ) {
+            updateGate();
+            _c.notify_all();
+        }
+    }
+
+    void ReadMostlyLock::lock_W() {
+        boost::mutex::scoped_lock lk( _m );
+        _pendingW++;
+        updateGate();
+        while ( _W || _w || _draining )
+            _c.wait( lk );
+        _pendingW--;
+        _W = true;
+        drainShared( lk );
+    }
+
+    void ReadMostlyLock::unlock_W() {
+        boost::mutex::scoped_lock lk( _m );
+        fassert( 16837, _W );
+        _W = false;
+        updateGate();
+        _c.notify_all();
+    }
+
+}
@@ -0,0 +1,96 @@
+// @file read_mostly_lock.h
+
+/**
+*    Copyright (C) 2012 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    /** A lock with the R, w and W modes of QLock, built for the case where R is by far the
+        most common request.
+
+          R - shared.  compatible with other R's.
+          w - intent write.  compatible with other w's.
+          W - exclusive.
+
+        R holders are counted in per cpu stripes (each on its own cache line), so taking and
+        releasing R touches no shared cache line while no w or W is around: a reader bumps its
+        stripe and then checks the gate word, which is only written when w/W activity starts
+        or stops.  w and W go through a mutex, close the gate, and wait for the stripes to
+        drain.  Waiters spin for a while before parking; the spin length adapts to how long
+        waits have recently been.
+
+        As with QLock, a pending W blocks new w's and R's, and R's wait while any w is held.
+
+        Non-recursive.
+    */
+    class ReadMostlyLock : boost::noncopyable {
+    public:
+        ReadMostlyLock();
+        ~ReadMostlyLock();
+
+        void lock_R();
+        void unlock_R();
+        void lock_w();
+        void unlock_w();
+        void lock_W();
+        void unlock_W();
+
+        /** for tests and stats: number of R holders right now */
+        int sharedCount() const;
+
+    private:
+        enum { CacheLineSize = 64 };
+        struct Stripe {
+            AtomicInt32 n;
+            char pad[ CacheLineSize - sizeof(AtomicInt32) ];
+        };
+
+        Stripe& myStripe();
+        void lock_R_slow();
+        void releaseShared( Stripe& s );
+        void drainShared( boost::mutex::scoped_lock& lk );
+        void updateGate();
+
+        bool gateOpen() const;
+        bool noShared() const;
+        /** spin until ready or our adaptive limit runs out. @return true if ready */
+        bool spin( bool (ReadMostlyLock::*ready)() const );
+
+        Stripe* _stripes;
+        unsigned _nStripes;        // power of 2
+        AtomicUInt32 _gate;        // nonzero: R must take the slow path
+        AtomicUInt32 _spinLimit;   // adaptive; see spin()
+
+        boost::mutex _m;
+        boost::condition _c;       // mode changes (w/W released, drain done)
+        boost::condition _drained; // last R left while the gate was closed
+
+        // guarded by _m
+        int _w;
+        bool _W;
+        int _pendingW;
+        bool _draining;
+    };
+
+}
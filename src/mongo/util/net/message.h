@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <boost/shared_ptr.hpp>
+
 #include "mongo/bson/util/atomic_int.h"
 #include "mongo/util/net/hostandport.h"
 #include "mongo/util/net/sock.h"
@@ -43,7 +45,8 @@ namespace mongo {
         dbQuery = 2004,
         dbGetMore = 2005,
         dbDelete = 2006,
-        dbKillCursors = 2007
+        dbKillCursors = 2007,
+        dbCompressed = 2012 /* wraps another message; only seen on the wire, see MessagingPort */
     };
 
     bool doesOpGetAResponse( int op );
@@ -59,6 +62,7 @@ namespace mongo {
         case dbGetMore: return "getmore";
         case dbDelete: return "remove";
         case dbKillCursors: return "killcursors";
+        case dbCompressed: return "compressed";
         default:
             massert( 16141, str::stream() << "cannot translate opcode " << op, !op );
             return "";
@@ -192,6 +196,21 @@ namespace mongo {
 
         int dataSize() const { return size() - sizeof(MSGHEADER); }
 
+        /** the bytes after the header, copied into *scratch if they span several buffers */
+        const char* body( string* scratch ) const {
+            if ( _buf ) {
+                return _buf->_data;
+            }
+            scratch->reserve( size() - MsgDataHeaderSize );
+            for( MsgVec::const_iterator i = _data.begin(); i != _data.end(); ++i ) {
+                if ( i == _data.begin() )
+                    scratch->append( i->first + MsgDataHeaderSize, i->second - MsgDataHeaderSize );
+                else
+                    scratch->append( i->first, i->second );
+            }
+            return scratch->data();
+        }
+
         // concat multiple buffers - noop if <2 buffers already, otherwise can be expensive copy
         // can get rid of this if we make response handling smarter
         void concat() {
@@ -222,6 +241,7 @@ namespace mongo {
             r._buf = 0;
             if ( r._data.size() > 0 ) {
                 _data.swap( r._data );
+                _pinned.swap( r._pinned );
             }
             r._freeIt = false;
             _freeIt = true;
@@ -233,12 +253,19 @@ namespace mongo {
                 if ( _buf ) {
                     free( _buf );
                 }
+                // buffers from appendPinned() are in _pinned's order; their holders own them
+                PinVec::const_iterator pin = _pinned.begin();
                 for( vector< pair< char *, int > >::const_iterator i = _data.begin(); i != _data.end(); ++i ) {
+                    if ( pin != _pinned.end() && i->first == pin->first ) {
+                        ++pin;
+                        continue;
+                    }
                     free(i->first);
                 }
             }
             _buf = 0;
             _data.clear();
+            _pinned.clear();
             _freeIt = false;
         }
 
@@ -263,6 +290,27 @@ namespace mongo {
             header()->len += size;
         }
 
+        /**
+         * Adds a buffer by reference: the message keeps a reference to holder, which owns
+         * data, until it is reset, and sends the bytes from where they are rather than
+         * copying them.  The message must already have its header buffer.
+         */
+        void appendPinned( const char *data, int size, const boost::shared_ptr<void>& holder ) {
+            verify( !empty() && _freeIt );
+            verify( holder );
+            if ( size <= 0 ) {
+                return;
+            }
+            if ( _buf ) {
+                _data.push_back( make_pair( (char*)_buf, _buf->len ) );
+                _buf = 0;
+            }
+            char *d = const_cast<char*>( data );
+            _pinned.push_back( make_pair( d, holder ) );
+            _data.push_back( make_pair( d, size ) );
+            header()->len += size;
+        }
+
         // use to set first buffer if empty
         void setData(MsgData *d, bool freeIt) {
             verify( empty() );
@@ -299,6 +347,10 @@ namespace mongo {
         // byte buffer(s) - the first must contain at least a full MsgData unless using _buf for storage instead
         typedef vector< pair< char*, int > > MsgVec;
         MsgVec _data;
+        // holders keeping the buffers added by appendPinned() alive; those entries of _data
+        // aren't freed
+        typedef vector< pair< char*, boost::shared_ptr<void> > > PinVec;
+        PinVec _pinned;
         bool _freeIt;
     };
 
@@ -24,6 +24,7 @@
 
 #include "mongo/db/cmdline.h"
 #include "mongo/util/background.h"
+#include "mongo/util/compress.h"
 #include "mongo/util/goodies.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
@@ -124,18 +125,18 @@ namespace mongo {
     }
 
     MessagingPort::MessagingPort(int fd, const SockAddr& remote) 
-        : psock( new Socket( fd , remote ) ) , piggyBackData(0) {
+        : psock( new Socket( fd , remote ) ) , piggyBackData(0), _compress(false) {
         ports.insert(this);
     }
 
     MessagingPort::MessagingPort( double timeout, int ll ) 
-        : psock( new Socket( timeout, ll ) ) {
+        : psock( new Socket( timeout, ll ) ), _compress(false) {
         ports.insert(this);
         piggyBackData = 0;
     }
 
     MessagingPort::MessagingPort( boost::shared_ptr<Socket> sock )
-        : psock( sock ), piggyBackData( 0 ) {
+        : psock( sock ), piggyBackData( 0 ), _compress( false ) {
         ports.insert(this);
     }
 
@@ -201,6 +202,8 @@ again:
 
             guard.Dismiss();
             m.setData(md, true);
+            if ( md->operation() == dbCompressed )
+                return uncompressMessage( m );
             return true;
 
         }
@@ -268,9 +271,111 @@ again:
             }
         }
 
+        Message compressed;
+        if ( _compress && compressMessage( toSend, compressed ) ) {
+            compressed.send( *this, "say" );
+            return;
+        }
+
         toSend.send( *this, "say" );
     }
 
+    bool MessagingPort::compressionAllowed = false;
+
+    namespace {
+        // after the standard header: the wrapped message's opcode and its size less the header
+        struct CompressedHeader {
+            int originalOpCode;
+            int uncompressedSize;
+        };
+        const int CompressedPrefixSize = MsgDataHeaderSize + sizeof( CompressedHeader );
+    }
+
+    bool MessagingPort::compressMessage( Message& toSend, Message& compressed ) {
+        int op = toSend.operation();
+        if ( op != dbQuery && op != dbInsert && op != opReply )
+            return false;
+        int size = toSend.size();
+        if ( size < MinCompressedMessageSize )
+            return false;
+
+        string scratch;
+        const char* body = toSend.body( &scratch );
+        int bodySize = size - MsgDataHeaderSize;
+
+        size_t maxLen = maxCompressedLength( bodySize );
+        MsgData* md = (MsgData*) malloc( CompressedPrefixSize + maxLen );
+        verify( md );
+        size_t compressedLen;
+        rawCompress( body, bodySize, md->_data + sizeof( CompressedHeader ), &compressedLen );
+        if ( CompressedPrefixSize + compressedLen >= size_t( size ) ) {
+            // didn't shrink; not worth the receiver's time
+            free( md );
+            return false;
+        }
+
+        md->len = CompressedPrefixSize + compressedLen;
+        md->id = toSend.header()->id;
+        md->responseTo = toSend.header()->responseTo;
+        md->setOperation( dbCompressed );
+        CompressedHeader* ch = reinterpret_cast<CompressedHeader*>( md->_data );
+        ch->originalOpCode = op;
+        ch->uncompressedSize = bodySize;
+        compressed.setData( md, true );
+        return true;
+    }
+
+    bool MessagingPort::uncompressMessage( Message& m ) {
+        MsgData* md = m.singleData();
+        const CompressedHeader* ch = reinterpret_cast<const CompressedHeader*>( md->_data );
+        const char* compressed = md->_data + sizeof( CompressedHeader );
+        size_t len;
+        // check the size before allocating for it
+        if ( md->len < CompressedPrefixSize ||
+             ch->originalOpCode == dbCompressed ||
+             ch->uncompressedSize < 0 ||
+             ch->uncompressedSize > MaxMessageSizeBytes - MsgDataHeaderSize ||
+             !uncompressedLength( compressed, md->len - CompressedPrefixSize, &len ) ||
+             len != size_t( ch->uncompressedSize ) ) {
+            LOG(0) << "recv(): bad compressed message from " << remote() << endl;
+            m.reset();
+            return false;
+        }
+
+        MsgData* out = (MsgData*) malloc( MsgDataHeaderSize + len );
+        verify( out );
+        if ( !rawUncompress( compressed, md->len - CompressedPrefixSize, out->_data ) ) {
+            free( out );
+            LOG(0) << "recv(): bad compressed message from " << remote() << endl;
+            m.reset();
+            return false;
+        }
+        out->len = MsgDataHeaderSize + len;
+        out->id = md->id;
+        out->responseTo = md->responseTo;
+        out->setOperation( ch->originalOpCode );
+        m.reset();
+        m.setData( out, true );
+        return true;
+    }
+
+    void negotiateCompression( const BSONObj& cmdObj,
+                               AbstractMessagingPort* port,
+                               BSONObjBuilder& result ) {
+        if ( !MessagingPort::compressionAllowed || !port )
+            return;
+        BSONElement e = cmdObj["compression"];
+        if ( e.type() != Array )
+            return;
+        BSONForEach( c, e.Obj() ) {
+            if ( c.type() == String && c.valuestrsafe() == string( "snappy" ) ) {
+                port->setCompression( true );
+                result.append( "compression", BSON_ARRAY( "snappy" ) );
+                return;
+            }
+        }
+    }
+
     void MessagingPort::piggyBack( Message& toSend , int responseTo ) {
 
         if ( toSend.header()->len > 1300 ) {
@@ -40,6 +40,9 @@ namespace mongo {
         long long connectionId() const { return _connectionId; }
         void setConnectionId( long long connectionId );
 
+        /** compress large outgoing messages from now on.  see negotiateCompression() */
+        virtual void setCompression( bool on ) {}
+
     public:
         // TODO make this private with some helpers
 
@@ -123,9 +126,28 @@ namespace mongo {
             return psock->getSockCreationMicroSec();
         }
 
+        /**
+         * With compression on, say() sends queries, inserts and replies of at least
+         * MinCompressedMessageSize bytes snappy compressed, wrapped in a dbCompressed message
+         * that carries the original opcode.  recv() always unwraps such messages, so only the
+         * sending side of a connection needs to know.
+         */
+        virtual void setCompression( bool on ) { _compress = on; }
+        bool compressing() const { return _compress; }
+
+        static const int MinCompressedMessageSize = 1024;
+
+        /** whether this process asks for (as a client) and agrees to (as a server) compression.
+            set from the networkMessageCompression server parameter. */
+        static bool compressionAllowed;
+
     private:
-        
+        /** @return false if toSend shouldn't be sent compressed; it's left untouched either way */
+        bool compressMessage( Message& toSend, Message& compressed );
+        bool uncompressMessage( Message& m );
+
         PiggyBackData * piggyBackData;
+        bool _compress;
         
         // this is the parsed version of remote
         // mutable because its initialized only on call to remote()
@@ -137,5 +159,13 @@ namespace mongo {
         friend class PiggyBackData;
     };
 
+    /**
+     * The isMaster side of compression negotiation: if the isMaster command cmdObj asks for a
+     * compressor we have and we allow it, turn compression on for port and say so in result.
+     */
+    void negotiateCompression( const BSONObj& cmdObj,
+                               AbstractMessagingPort* port,
+                               BSONObjBuilder& result );
+
 
 } // namespace mongo
@@ -47,6 +47,25 @@ namespace mongo {
          * called once when a socket is disconnected
          */
         virtual void disconnected( AbstractMessagingPort* p ) = 0;
+
+        /** a connection's thread local state, while it is off any thread */
+        class ThreadState {
+        public:
+            virtual ~ThreadState() {}
+        };
+
+        /**
+         * Servers that run many connections over a few worker threads need the handler to
+         * move a connection's thread local state (Client etc.) on and off the worker around
+         * each call.  Handlers that can do that return true and implement the two calls below.
+         */
+        virtual bool canMoveBetweenThreads() const { return false; }
+
+        /** takes the calling thread's connection state off it. @return owned by the caller */
+        virtual ThreadState* detachFromThread( AbstractMessagingPort* p ) { return 0; }
+
+        /** puts state from detachFromThread() on the calling thread; takes ownership */
+        virtual void attachToThread( AbstractMessagingPort* p , ThreadState* state ) { delete state; }
     };
 
     class MessageServer {
@@ -23,6 +23,7 @@
 
 #include "mongo/db/cmdline.h"
 #include "mongo/db/lasterror.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/net/listen.h"
@@ -32,11 +33,29 @@
 #include "mongo/util/net/ssl_manager.h"
 
 #ifdef __linux__  // TODO: consider making this ifndef _WIN32
+# include <sys/epoll.h>
 # include <sys/resource.h>
 #endif
 
 namespace mongo {
 
+    namespace {
+        // 0 means a thread per connection
+        int networkWorkerThreads = 0;
+        ExportedServerParameter<int> NetworkWorkerThreadsSetting(ServerParameterSet::getGlobal(),
+                                                                 "networkWorkerThreads",
+                                                                 &networkWorkerThreads,
+                                                                 true,
+                                                                 false);
+
+        ExportedServerParameter<bool> NetworkMessageCompressionSetting(
+                ServerParameterSet::getGlobal(),
+                "networkMessageCompression",
+                &MessagingPort::compressionAllowed,
+                true,
+                false);
+    }
+
     class PortMessageServer : public MessageServer , public Listener {
     public:
         /**
@@ -240,7 +259,251 @@ namespace mongo {
     };
 
 
+#ifdef __linux__
+    /**
+     * Serves connections from a fixed pool of worker threads instead of a thread each.
+     *
+     * Idle connections sit in an epoll set and cost only their socket and MessagingPort.
+     * When one becomes readable the poll thread queues it; a worker takes it off the queue,
+     * reads and processes one message, and rearms the socket.  A connection that has more
+     * requests waiting goes to the back of the queue, so a busy client can't hold off the
+     * others.  Around each message the handler moves the connection's thread local state onto
+     * the worker and back off (see MessageHandler::canMoveBetweenThreads()).
+     *
+     * A request that blocks (a slow client mid-message, a long operation) holds its worker,
+     * so at most networkWorkerThreads requests are in progress at once.
+     */
+    class EpollMessageServer : public MessageServer , public Listener {
+    public:
+        EpollMessageServer( const MessageServer::Options& opts , MessageHandler * handler ,
+                            int nWorkers ) :
+            Listener( "" , opts.ipList, opts.port ), _handler(handler), _nWorkers(nWorkers),
+            _epfd(-1), _m("EpollMessageServer"), _stopping(false) {
+        }
+
+        virtual ~EpollMessageServer() {
+            if ( _epfd >= 0 )
+                close( _epfd );
+        }
+
+        virtual void acceptedMP(MessagingPort * p) {
+            if ( ! Listener::globalTicketHolder.tryAcquire() ) {
+                log() << "connection refused because too many open connections: " << Listener::globalTicketHolder.used() << endl;
+                p->shutdown();
+                delete p;
+                sleepmillis(2); // otherwise we'll hard loop
+                return;
+            }
+
+            p->psock->setLogLevel(1);
+            // a worker calls connected() for it before it goes into the poll set
+            enqueue( new Connection( p ) );
+        }
+
+        virtual void setAsTimeTracker() {
+            Listener::setAsTimeTracker();
+        }
+
+        void run() {
+            _epfd = epoll_create( 1024 );
+            massert( 16838, str::stream() << "epoll_create failed: " << errnoWithDescription(),
+                     _epfd >= 0 );
+
+            _threads.create_thread( boost::bind( &EpollMessageServer::pollThread, this ) );
+            for ( int i = 0; i < _nWorkers; i++ )
+                _threads.create_thread( boost::bind( &EpollMessageServer::workerThread, this, i ) );
+            log() << "serving connections from " << _nWorkers << " worker threads" << endl;
+
+            initAndListen();
+
+            // listening stops at shutdown; let the workers finish what they're doing
+            {
+                scoped_lock lk( _m );
+                _stopping = true;
+                _ready.notify_all();
+            }
+            _threads.join_all();
+        }
+
+        virtual bool useUnixSockets() const { return true; }
+
+    private:
+        struct Connection {
+            Connection( MessagingPort* p ) :
+                port(p), le(new LastError()), state(0), connected(false), inPoll(false) {
+            }
+            MessagingPort* port;
+            LastError* le;
+            MessageHandler::ThreadState* state; // null while on a worker
+            bool connected;
+            bool inPoll;
+        };
+
+        void enqueue( Connection* c ) {
+            scoped_lock lk( _m );
+            _queue.push_back( c );
+            _ready.notify_one();
+        }
+
+        void pollThread() {
+            setThreadName( "connPoller" );
+            const int MaxEvents = 256;
+            struct epoll_event events[MaxEvents];
+            while ( ! inShutdown() ) {
+                int n = epoll_wait( _epfd, events, MaxEvents, 1000 );
+                if ( n < 0 ) {
+                    if ( errno != EINTR ) {
+                        error() << "epoll_wait failed: " << errnoWithDescription() << endl;
+                        sleepmillis(10);
+                    }
+                    continue;
+                }
+                if ( n == 0 )
+                    continue;
+
+                scoped_lock lk( _m );
+                for ( int i = 0; i < n; i++ )
+                    _queue.push_back( static_cast<Connection*>( events[i].data.ptr ) );
+                _ready.notify_all();
+            }
+        }
+
+        void workerThread( int n ) {
+            {
+                string threadName = str::stream() << "connWorker" << n;
+                setThreadName( threadName.c_str() );
+            }
+            while ( true ) {
+                Connection* c;
+                {
+                    scoped_lock lk( _m );
+                    while ( _queue.empty() && ! _stopping )
+                        _ready.wait( lk.boost() );
+                    if ( _queue.empty() )
+                        return;
+                    c = _queue.front();
+                    _queue.pop_front();
+                }
+                serve( c );
+            }
+        }
+
+        /** the sockets are oneshot, so a connection is on at most one worker at a time */
+        bool rearm( Connection* c ) {
+            struct epoll_event ev;
+            ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+            ev.data.ptr = c;
+            int op = c->inPoll ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+            c->inPoll = true;
+            if ( epoll_ctl( _epfd, op, c->port->psock->rawFD(), &ev ) != 0 ) {
+                log() << "epoll_ctl failed, closing client connection: " << errnoWithDescription() << endl;
+                return false;
+            }
+            return true;
+        }
+
+        /** runs one step of a connection (connect, or one request) on this worker */
+        void serve( Connection* c ) {
+            MessagingPort* p = c->port;
+            {
+                string threadName = "conn";
+                if ( p->connectionId() > 0 )
+                    threadName = str::stream() << threadName << p->connectionId();
+                setThreadName( threadName.c_str() );
+            }
+
+            lastError.reset( c->le );
+            if ( c->state ) {
+                _handler->attachToThread( p, c->state );
+                c->state = 0;
+            }
+
+            bool keep = false;
+            try {
+                if ( ! c->connected ) {
+                    c->connected = true;
+                    _handler->connected( p );
+                    keep = true;
+                }
+                else {
+                    Message m;
+                    p->psock->clearCounters();
+                    if ( p->recv(m) ) {
+                        _handler->process( m , p , c->le );
+                        networkCounter.hit( p->psock->getBytesIn() , p->psock->getBytesOut() );
+                        keep = ! inShutdown();
+                    }
+                    else if( !cmdLine.quiet ){
+                        int conns = Listener::globalTicketHolder.used()-1;
+                        const char* word = (conns == 1 ? " connection" : " connections");
+                        log() << "end connection " << p->psock->remoteString() << " (" << conns << word << " now open)" << endl;
+                    }
+                }
+            }
+            catch ( AssertionException& e ) {
+                log() << "AssertionException handling request, closing client connection: " << e << endl;
+            }
+            catch ( SocketException& e ) {
+                log() << "SocketException handling request, closing client connection: " << e << endl;
+            }
+            catch ( const DBException& e ) { // must be right above std::exception to avoid catching subclasses
+                log() << "DBException handling request, closing client connection: " << e << endl;
+            }
+            catch ( std::exception &e ) {
+                error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
+                dbexit( EXIT_UNCAUGHT );
+            }
+            catch ( ... ) {
+                error() << "Uncaught exception, terminating" << endl;
+                dbexit( EXIT_UNCAUGHT );
+            }
+
+            if ( keep ) {
+                // off this thread before another worker can pick it up
+                c->state = _handler->detachFromThread( p );
+                lastError.release();
+                if ( rearm( c ) )
+                    return;
+                lastError.reset( c->le );
+                _handler->attachToThread( p, c->state );
+                c->state = 0;
+            }
+
+            p->shutdown();
+            _handler->disconnected( p );
+            delete _handler->detachFromThread( p );
+            lastError.reset( NULL ); // deletes c->le
+            delete p;
+            delete c;
+            Listener::globalTicketHolder.release();
+        }
+
+        MessageHandler* _handler;
+        const int _nWorkers;
+        int _epfd;
+
+        mongo::mutex _m;        // guards _queue and _stopping
+        boost::condition _ready;
+        std::deque<Connection*> _queue;
+        bool _stopping;
+
+        boost::thread_group _threads;
+    };
+#endif
+
     MessageServer * createServer( const MessageServer::Options& opts , MessageHandler * handler ) {
+#ifdef __linux__
+        if ( networkWorkerThreads > 0 ) {
+            bool canUse = handler->canMoveBetweenThreads();
+#ifdef MONGO_SSL
+            // ssl buffers input of its own, so socket readiness doesn't tell us there's a message
+            canUse = canUse && ! cmdLine.sslOnNormalPorts;
+#endif
+            if ( canUse )
+                return new EpollMessageServer( opts , handler , networkWorkerThreads );
+            warning() << "networkWorkerThreads not supported here, using a thread per connection" << endl;
+        }
+#endif
         return new PortMessageServer( opts , handler );
     }
 
@@ -0,0 +1,228 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Tests the MessageServer that serves connections from a pool of worker threads, which
+ * createServer() returns when networkWorkerThreads is set.
+ */
+
+#include "mongo/pch.h"
+
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/cmdline.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/net/listen.h"
+#include "mongo/util/net/message_port.h"
+#include "mongo/util/net/message_server.h"
+#include "mongo/util/net/sock.h"
+
+namespace {
+    const int TARGET_PORT = 27019;
+
+    mongo::mutex shutDownMutex("shutDownMutex");
+    bool shuttingDown = false;
+}
+
+namespace mongo {
+    class DBClientBase;
+
+    // Symbols defined to build the binary correctly.
+    CmdLine cmdLine;
+
+    bool inShutdown() {
+        scoped_lock sl(shutDownMutex);
+        return shuttingDown;
+    }
+
+    DBClientBase *createDirectClient() { return NULL; }
+
+    void dbexit(ExitCode rc, const char *why){
+        {
+            scoped_lock sl(shutDownMutex);
+            shuttingDown = true;
+        }
+
+        ::_exit(rc);
+    }
+
+    bool haveLocalShardingInfo(const string& ns) {
+        return false;
+    }
+}
+
+#ifdef __linux__
+
+namespace {
+
+    using namespace mongo;
+
+    /** Echoes each message back, counting what happens to the connections. */
+    class EchoMessageHandler : public MessageHandler {
+    public:
+        EchoMessageHandler() : _m("EchoMessageHandler"), _connected(0), _disconnected(0),
+                               _detached(0) {
+        }
+
+        virtual void connected(AbstractMessagingPort* p) {
+            scoped_lock lk(_m);
+            ++_connected;
+        }
+
+        virtual void process(Message& m, AbstractMessagingPort* p, LastError* le) {
+            Message response;
+            response.setData(opReply, m.singleData()->_data, m.dataSize());
+            p->reply(m, response, m.header()->id);
+        }
+
+        virtual void disconnected(AbstractMessagingPort* p) {
+            scoped_lock lk(_m);
+            ++_disconnected;
+        }
+
+        virtual bool canMoveBetweenThreads() const { return true; }
+
+        virtual ThreadState* detachFromThread(AbstractMessagingPort* p) {
+            scoped_lock lk(_m);
+            ++_detached;
+            return new ThreadState();
+        }
+
+        int connected() { scoped_lock lk(_m); return _connected; }
+        int disconnected() { scoped_lock lk(_m); return _disconnected; }
+        int detached() { scoped_lock lk(_m); return _detached; }
+
+    private:
+        mongo::mutex _m;
+        int _connected;
+        int _disconnected;
+        int _detached;
+    };
+
+    class EpollMessageServerTest : public unittest::Test {
+    public:
+        void setUp() {
+            ServerParameter* workers =
+                    ServerParameterSet::getGlobal()->getMap().find("networkWorkerThreads")->second;
+            ASSERT_OK(workers->setFromString("2"));
+
+            {
+                scoped_lock sl(shutDownMutex);
+                shuttingDown = false;
+            }
+            MessageServer::Options options;
+            options.port = TARGET_PORT;
+            _server.reset(createServer(options, &_handler));
+            _serverThread = boost::thread(runServer, _server.get());
+        }
+
+        void tearDown() {
+            {
+                scoped_lock sl(shutDownMutex);
+                shuttingDown = true;
+            }
+            ListeningSockets::get()->closeAll();
+            // Joins the poll and worker threads too.
+            _serverThread.join();
+            _server.reset();
+
+            ServerParameter* workers =
+                    ServerParameterSet::getGlobal()->getMap().find("networkWorkerThreads")->second;
+            ASSERT_OK(workers->setFromString("0"));
+        }
+
+        /** Connect, retrying while the server starts listening. */
+        void connect(MessagingPort* port) {
+            SockAddr addr("localhost", TARGET_PORT);
+            for (int i = 0; i < 100; ++i) {
+                if (port->connect(addr)) {
+                    return;
+                }
+                sleepmillis(50);
+            }
+            FAIL("couldn't connect to the server");
+        }
+
+        /** Send 'text' and check it comes back. */
+        void echo(MessagingPort* port, const string& text) {
+            Message toSend;
+            toSend.setData(dbQuery, text.c_str(), text.size() + 1);
+            Message response;
+            ASSERT_TRUE(port->call(toSend, response));
+            ASSERT_EQUALS(opReply, response.operation());
+            ASSERT_EQUALS(text, string(response.singleData()->_data));
+        }
+
+        /** Wait for 'n' connections to have been disconnected. */
+        void awaitDisconnected(int n) {
+            for (int i = 0; i < 200 && _handler.disconnected() < n; ++i) {
+                sleepmillis(50);
+            }
+            ASSERT_EQUALS(n, _handler.disconnected());
+        }
+
+        static void runServer(MessageServer* server) {
+            server->run();
+        }
+
+        EchoMessageHandler _handler;
+        scoped_ptr<MessageServer> _server;
+        boost::thread _serverThread;
+    };
+
+    TEST_F(EpollMessageServerTest, AcceptReadAndDisconnect) {
+        MessagingPort client;
+        connect(&client);
+        echo(&client, "first");
+        echo(&client, "second");
+        ASSERT_EQUALS(1, _handler.connected());
+        // The connection went off its worker after connecting and after the first message,
+        // before the second could be read.
+        ASSERT_TRUE(_handler.detached() >= 2);
+
+        client.shutdown();
+        awaitDisconnected(1);
+    }
+
+    TEST_F(EpollMessageServerTest, InterleavedConnections) {
+        MessagingPort first;
+        MessagingPort second;
+        MessagingPort third;
+        connect(&first);
+        connect(&second);
+        connect(&third);
+        // More connections than workers, each served in turn.
+        for (int i = 0; i < 10; ++i) {
+            echo(&first, str::stream() << "first " << i);
+            echo(&second, str::stream() << "second " << i);
+            echo(&third, str::stream() << "third " << i);
+        }
+        ASSERT_EQUALS(3, _handler.connected());
+
+        second.shutdown();
+        awaitDisconnected(1);
+        echo(&first, "still there");
+        echo(&third, "still there");
+
+        first.shutdown();
+        third.shutdown();
+        awaitDisconnected(3);
+    }
+
+} // namespace
+
+#endif // __linux__
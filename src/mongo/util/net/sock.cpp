@@ -28,6 +28,7 @@
 # include <netinet/tcp.h>
 # include <arpa/inet.h>
 # include <errno.h>
+# include <limits.h>
 # include <netdb.h>
 # if defined(__openbsd__)
 #  include <sys/uio.h>
@@ -594,9 +595,12 @@ namespace mongo {
         struct msghdr meta;
         memset( &meta, 0, sizeof( meta ) );
         meta.msg_iov = &d[ 0 ];
-        meta.msg_iovlen = d.size();
+        size_t left = i; // buffers not completely sent yet
+
+        while( left > 0 ) {
+            // replies built from many buffers can have more than sendmsg takes at once
+            meta.msg_iovlen = std::min( left, size_t( IOV_MAX ) );
 
-        while( meta.msg_iovlen > 0 ) {
             int ret = -1;
             if (MONGO_FAIL_POINT(throwSockExcep)) {
 #if defined(_WIN32)
@@ -632,7 +636,7 @@ namespace mongo {
                     else {
                         ret -= i->iov_len;
                         ++i;
-                        --(meta.msg_iovlen);
+                        --left;
                     }
                 }
             }
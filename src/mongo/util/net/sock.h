@@ -216,6 +216,9 @@ namespace mongo {
         void setTimeout( double secs );
         bool isStillConnected();
 
+        /** for event loops that watch many sockets at once */
+        int rawFD() const { return _fd; }
+
 #ifdef MONGO_SSL
         /** secures inline */
         void secure( SSLManagerInterface* ssl );
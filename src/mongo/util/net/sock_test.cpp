@@ -30,6 +30,7 @@
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/concurrency/synchronization.h"
 #include "mongo/util/fail_point_service.h"
+#include "mongo/util/net/message_port.h"
 
 namespace mongo {
 
@@ -339,5 +340,47 @@ namespace {
         ASSERT_TRUE(tryRecv());
     }
 
+    TEST(SocketTest, SendVectorOfManyBuffers) {
+        const SocketPair sockets = socketPair(SOCK_STREAM);
+        ASSERT_TRUE(sockets.first);
+        ASSERT_TRUE(sockets.second);
+
+        // more buffers than a single sendmsg() call accepts
+        const int n = 4000;
+        std::vector<char> sent(n);
+        std::vector<std::pair<char*, int> > data;
+        for (int i = 0; i < n; ++i) {
+            sent[i] = static_cast<char>(i);
+            data.push_back(std::make_pair(&sent[i], 1));
+        }
+        sockets.first->send(data, "SocketTest::SendVectorOfManyBuffers");
+
+        std::vector<char> received(n);
+        sockets.second->recv(&received[0], n);
+        ASSERT_TRUE(sent == received);
+    }
+    TEST(MessagingPortTest, CompressedMessageRoundTrip) {
+        const SocketPair sockets = socketPair(SOCK_STREAM);
+        ASSERT_TRUE(sockets.first);
+        ASSERT_TRUE(sockets.second);
+        MessagingPort sender(sockets.first);
+        MessagingPort receiver(sockets.second);
+        sender.setCompression(true);
+
+        // compressible, and well over the size below which messages go uncompressed
+        const std::string payload(64 * 1024, 'x');
+        Message toSend;
+        toSend.setData(dbQuery, payload.c_str(), payload.size());
+        sender.say(toSend);
+
+        Message received;
+        ASSERT_TRUE(receiver.recv(received));
+        ASSERT_EQUALS(dbQuery, received.operation());
+        ASSERT_EQUALS(unsigned(toSend.header()->id), unsigned(received.header()->id));
+        ASSERT_EQUALS(toSend.size(), received.size());
+        ASSERT_EQUALS(0, memcmp(toSend.singleData()->_data,
+                                received.singleData()->_data,
+                                payload.size()));
+    }
 
 } // namespace